@@ -0,0 +1,35 @@
+/**
+ * cjson.decode throughput over the deterministic corpus in json-corpus.ts.
+ *
+ * Run against the default build and a SIMD build to compare:
+ *
+ *   npm run build:wasm && node --import tsx bench/cjson-decode.bench.ts
+ *   npm run build:wasm:simd && node --import tsx bench/cjson-decode.bench.ts
+ */
+
+import { load } from "../src/index.js";
+import { generateCorpus } from "./json-corpus.js";
+
+const ROUNDS = 9;
+const SCRIPT = "local t = cjson.decode(ARGV[1]) return #t";
+
+const engine = (await load({ limits: { maxFuel: 2_000_000_000 } })).createStandalone();
+
+for (const doc of generateCorpus()) {
+  const arg = Buffer.from(doc.json, "utf8");
+  const expected = (JSON.parse(doc.json) as unknown[]).length;
+  engine.evalWithArgs(SCRIPT, [], [arg]); // warm up
+  const times: number[] = [];
+  for (let i = 0; i < ROUNDS; i++) {
+    const start = process.hrtime.bigint();
+    const n = engine.evalWithArgs(SCRIPT, [], [arg]);
+    times.push(Number(process.hrtime.bigint() - start) / 1e6);
+    if (n !== expected) throw new Error(`${doc.name}: decoded ${String(n)} items, expected ${expected}`);
+  }
+  times.sort((a, b) => a - b);
+  const median = times[ROUNDS >> 1];
+  const mbps = arg.length / 1024 / 1024 / (median / 1000);
+  console.log(
+    `${doc.name.padEnd(18)} ${String(arg.length).padStart(8)} B  median ${median.toFixed(2).padStart(8)} ms  ${mbps.toFixed(1)} MB/s`,
+  );
+}
@@ -0,0 +1,89 @@
+/**
+ * Deterministic JSON corpus for the cjson.decode benchmark.
+ *
+ * Every document is generated from a fixed-seed PRNG, so the corpus is the same
+ * on every machine and across runs without checking multi-hundred-KB fixtures
+ * into the repo. Shapes mirror what scripts typically keep in Redis strings:
+ * records with short keys, long text fields (some with escapes and non-ASCII),
+ * numeric arrays and deep-ish nesting.
+ */
+
+/** mulberry32: tiny, fast, good enough for fixture generation. */
+function prng(seed: number): () => number {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = a;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+const WORDS = ["alpha", "beta", "gamma", "delta", "cache", "user", "order", "stock", "état", "naïve", "数据", "😀"];
+
+function text(rand: () => number, words: number, escapes: boolean): string {
+  const out: string[] = [];
+  for (let i = 0; i < words; i++) {
+    out.push(WORDS[Math.floor(rand() * WORDS.length)]);
+    if (escapes && rand() < 0.05) out.push('"quoted"\n\t\\');
+  }
+  return out.join(" ");
+}
+
+function record(rand: () => number, id: number, escapes: boolean): unknown {
+  return {
+    id,
+    name: text(rand, 3, false),
+    active: rand() < 0.5,
+    score: Math.round(rand() * 1e6) / 100,
+    ratio: rand() * 2 - 1,
+    tags: Array.from({ length: 1 + Math.floor(rand() * 5) }, () => text(rand, 1, false)),
+    note: rand() < 0.3 ? null : text(rand, 20 + Math.floor(rand() * 40), escapes),
+    history: Array.from({ length: 8 }, () => Math.floor(rand() * 100000)),
+    meta: { created: 1_700_000_000 + id, owner: { id: id % 97, region: text(rand, 1, false) } },
+  };
+}
+
+function nested(rand: () => number, depth: number): unknown {
+  if (depth === 0) return text(rand, 2, false);
+  return { level: depth, items: [nested(rand, depth - 1), Math.floor(rand() * 1000)] };
+}
+
+export type CorpusDocument = { name: string; json: string };
+
+/** Returns the benchmark corpus (about 1.6 MB of JSON in total). */
+export function generateCorpus(): CorpusDocument[] {
+  const docs: CorpusDocument[] = [];
+  const sizes: Array<[string, number]> = [
+    ["records-4k", 8],
+    ["records-64k", 128],
+    ["records-512k", 1024],
+  ];
+  for (const [name, count] of sizes) {
+    const rand = prng(0xc0ffee ^ count);
+    docs.push({
+      name,
+      json: JSON.stringify(Array.from({ length: count }, (_, i) => record(rand, i, false))),
+    });
+  }
+  {
+    const rand = prng(0xbadc0de);
+    docs.push({
+      name: "escaped-text-256k",
+      json: JSON.stringify(Array.from({ length: 512 }, (_, i) => record(rand, i, true))),
+    });
+  }
+  {
+    const rand = prng(42);
+    docs.push({
+      name: "numbers-256k",
+      json: JSON.stringify(Array.from({ length: 24000 }, () => Math.round((rand() - 0.5) * 1e9) / 1e3)),
+    });
+  }
+  {
+    const rand = prng(7);
+    docs.push({ name: "nested-32", json: JSON.stringify(Array.from({ length: 64 }, () => nested(rand, 32))) });
+  }
+  return docs;
+}
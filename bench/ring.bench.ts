@@ -0,0 +1,59 @@
+/**
+ * Worker round-trip benchmark: SharedArrayBuffer ring vs postMessage.
+ *
+ * One worker hosts a standalone engine. The main thread sends the same small
+ * eval to it N times, one at a time, first through `postMessage` and then
+ * through a submission ring, and reports the mean round trip. The script is
+ * trivial on purpose: what is measured is the hop, not the eval.
+ *
+ * Run with: node --import tsx bench/ring.bench.ts [evals]
+ */
+
+import { Worker, isMainThread, parentPort, workerData } from "node:worker_threads";
+import { createRing, load, RingConsumer, RingProducer } from "../src/index.js";
+
+const SCRIPT = "return ARGV[1]";
+
+if (isMainThread) {
+  const evals = Number(process.argv[2] ?? 20000);
+  const ring = createRing({ slots: 16, slotBytes: 4096 });
+  const worker = new Worker(new URL(import.meta.url), { workerData: { ring } });
+  const call = (msg: unknown) =>
+    new Promise((resolve) => {
+      worker.once("message", resolve);
+      worker.postMessage(msg);
+    });
+  await call({ script: SCRIPT, keys: [], args: ["warm"] }); // engine loaded
+
+  let start = process.hrtime.bigint();
+  for (let i = 0; i < evals; i++) {
+    await call({ script: SCRIPT, keys: ["k"], args: [String(i)] });
+  }
+  const messageUs = Number(process.hrtime.bigint() - start) / 1e3 / evals;
+
+  worker.postMessage({ keys: [], args: [] });
+  const producer = new RingProducer(ring);
+  await producer.submit(SCRIPT, [], ["warm"]);
+  start = process.hrtime.bigint();
+  for (let i = 0; i < evals; i++) {
+    await producer.submit(SCRIPT, ["k"], [String(i)]);
+  }
+  const ringUs = Number(process.hrtime.bigint() - start) / 1e3 / evals;
+
+  producer.close();
+  await worker.terminate();
+  console.log(`postMessage  ${messageUs.toFixed(1)} us/eval  (${evals} evals)`);
+  console.log(`ring         ${ringUs.toFixed(1)} us/eval  (${evals} evals)`);
+} else {
+  const engine = (await load()).createStandalone();
+  parentPort!.on("message", (msg: { script?: string; keys: string[]; args: string[] }) => {
+    if (msg.script === undefined) {
+      // Switch to the ring; serve() blocks this worker until the ring closes.
+      new RingConsumer(workerData.ring).serve((script, keys, args) =>
+        engine.evalWithArgs(script, keys, args),
+      );
+      return;
+    }
+    parentPort!.postMessage(engine.evalWithArgs(msg.script, msg.keys, msg.args));
+  });
+}
@@ -0,0 +1,48 @@
+/**
+ * Time-to-first-eval benchmark: startup phases, with and without warm-up.
+ *
+ * Each run loads a fresh engine on a new worker thread (so nothing compiled by
+ * an earlier run is reused), prints the per-phase timing breakdown, then times
+ * the first few evals of a mixed script. With `warmup: true` those evals should
+ * already run on optimized code.
+ *
+ * Run with: node --import tsx bench/startup.bench.ts [runs]
+ */
+
+import { Worker, isMainThread, parentPort, workerData } from "node:worker_threads";
+import { load, type StartupTimings } from "../src/index.js";
+
+const SCRIPT =
+  "local t = {} for i = 1, 200 do t[i] = ARGV[1] .. i end " +
+  "return {#table.concat(t), cjson.encode({n = #t})}";
+const FIRST_EVALS = 20;
+
+type RunResult = { timings: StartupTimings; evalsMs: number };
+
+if (isMainThread) {
+  const runs = Number(process.argv[2] ?? 5);
+  for (const warmup of [false, true]) {
+    const results: RunResult[] = [];
+    for (let i = 0; i < runs; i++) {
+      const worker = new Worker(new URL(import.meta.url), { workerData: { warmup } });
+      results.push(await new Promise<RunResult>((resolve) => worker.once("message", resolve)));
+      await worker.terminate();
+    }
+    const mean = (pick: (r: RunResult) => number) =>
+      (results.reduce((sum, r) => sum + pick(r), 0) / results.length).toFixed(2);
+    console.log(`warmup=${warmup} (${runs} runs, mean ms)`);
+    for (const phase of ["glueMs", "wasmReadMs", "compileMs", "instantiateMs", "initMs", "warmupMs"] as const) {
+      console.log(`  ${phase.padEnd(14)} ${mean((r) => r.timings[phase])}`);
+    }
+    console.log(`  ${"firstEvalMs".padEnd(14)} ${mean((r) => r.timings.firstEvalMs ?? 0)}`);
+    console.log(`  first ${FIRST_EVALS} evals ${mean((r) => r.evalsMs)}`);
+  }
+} else {
+  const engine = (await load({ warmup: workerData.warmup })).createStandalone();
+  const start = performance.now();
+  for (let i = 0; i < FIRST_EVALS; i++) {
+    engine.evalWithArgs(SCRIPT, [], [String(i)]);
+  }
+  const evalsMs = performance.now() - start;
+  parentPort!.postMessage({ timings: engine.getStartupTimings(), evalsMs });
+}
@@ -0,0 +1,69 @@
+/**
+ * Adversarial string-hash benchmark.
+ *
+ * Lua 5.1 hashes at most ~32 bytes of a string, sampled every `(len >> 5) + 1`
+ * bytes from the end. The keys below are 1 KiB long and differ only in bytes the
+ * sampling skips, so under the stock hash they all share one hash value: every
+ * intern and every table lookup walks a single chain. With `hashSeed` set, every
+ * byte is hashed and the keys spread out.
+ *
+ * Run with: node --import tsx bench/string-hash.bench.ts [keyCount]
+ */
+
+import { load } from "../src/index.js";
+
+const KEY_LEN = 1024;
+const keyCount = Number(process.argv[2] ?? 2000);
+const ROUNDS = 5;
+
+/** Byte offsets the stock 5.1 hash reads for a string of `len` bytes. */
+function sampledOffsets(len: number): Set<number> {
+  const step = (len >> 5) + 1;
+  const offsets = new Set<number>();
+  for (let l1 = len; l1 >= step; l1 -= step) {
+    offsets.add(l1 - 1);
+  }
+  return offsets;
+}
+
+/** Keys identical on every sampled byte, distinct on the skipped ones. */
+function collidingKeys(count: number): Buffer[] {
+  const sampled = sampledOffsets(KEY_LEN);
+  const free: number[] = [];
+  for (let i = 0; i < KEY_LEN && free.length < 4; i++) {
+    if (!sampled.has(i)) free.push(i);
+  }
+  return Array.from({ length: count }, (_, n) => {
+    const key = Buffer.alloc(KEY_LEN, 0x61);
+    for (let b = 0; b < free.length; b++) {
+      key[free[b]] = 0x61 + ((n >> (b * 4)) & 0xf);
+    }
+    return key;
+  });
+}
+
+const SCRIPT = `
+local t = {}
+for i = 1, #ARGV do t[ARGV[i]] = i end
+local hits = 0
+for i = 1, #ARGV do if t[ARGV[i]] == i then hits = hits + 1 end end
+return hits
+`;
+
+async function run(label: string, hashSeed: number | undefined, args: Buffer[]) {
+  const engine = (await load({ hashSeed })).createStandalone();
+  engine.evalWithArgs(SCRIPT, [], args); // warm up
+  const times: number[] = [];
+  for (let i = 0; i < ROUNDS; i++) {
+    const start = process.hrtime.bigint();
+    const hits = engine.evalWithArgs(SCRIPT, [], args);
+    times.push(Number(process.hrtime.bigint() - start) / 1e6);
+    if (hits !== args.length) throw new Error(`${label}: expected ${args.length} hits, got ${String(hits)}`);
+  }
+  times.sort((a, b) => a - b);
+  console.log(`${label.padEnd(14)} median ${times[ROUNDS >> 1].toFixed(2)} ms  (${keyCount} keys x ${KEY_LEN} B)`);
+}
+
+const args = collidingKeys(keyCount);
+await run("sampled hash", undefined, args);
+await run("seeded hash", 0x2545f491, args);
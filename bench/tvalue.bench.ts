@@ -0,0 +1,65 @@
+/**
+ * Value layout benchmark: Lua heap used by value-heavy structures, and the time
+ * to scan them.
+ *
+ * A wasm32 TValue is 16 bytes in the stock build and 12 in the experimental
+ * compact build. Array slots, hash nodes, upvalues and stack slots all hold
+ * TValues. Run against both builds to compare:
+ *
+ *   npm run build:wasm && node --import tsx bench/tvalue.bench.ts
+ *   npm run build:wasm:compact && node --import tsx bench/tvalue.bench.ts
+ */
+
+import { load } from "../src/index.js";
+
+const ROUNDS = 7;
+
+/** Each body builds `x` from `n`; the harness measures the heap it holds. */
+const WORKLOADS: Array<{ name: string; n: number; build: string; scan: string }> = [
+  {
+    name: "array of numbers",
+    n: 1_000_000,
+    build: "local x = {} for i = 1, n do x[i] = i end",
+    scan: "local s = 0 for r = 1, 10 do for i = 1, n do s = s + x[i] end end",
+  },
+  {
+    name: "hash, number keys",
+    n: 200_000,
+    build: "local x = {} for i = 1, n do x[i + 0.5] = i end",
+    scan: "local s = 0 for r = 1, 10 do for _, v in pairs(x) do s = s + v end end",
+  },
+  {
+    name: "closures, 2 upvalues",
+    n: 100_000,
+    build: "local x = {} for i = 1, n do local a, b = i, -i x[i] = function() return a + b end end",
+    scan: "local s = 0 for r = 1, 10 do for i = 1, n do s = s + x[i]() end end",
+  },
+];
+
+const engine = (await load({ limits: { maxFuel: 2_000_000_000 } })).createStandalone();
+
+for (const { name, n, build, scan } of WORKLOADS) {
+  const bytes = engine.evalWithArgs(
+    `local n = tonumber(ARGV[1])
+     collectgarbage('collect')
+     local before = collectgarbage('count')
+     ${build}
+     collectgarbage('collect')
+     return math.floor((collectgarbage('count') - before) * 1024)`,
+    [],
+    [String(n)],
+  ) as number;
+  const script = `local n = tonumber(ARGV[1]) ${build} ${scan} return 1`;
+  engine.evalWithArgs(script, [], [String(n)]); // warm up
+  const times: number[] = [];
+  for (let i = 0; i < ROUNDS; i++) {
+    const start = process.hrtime.bigint();
+    engine.evalWithArgs(script, [], [String(n)]);
+    times.push(Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  times.sort((a, b) => a - b);
+  console.log(
+    `${name.padEnd(22)} n=${String(n).padStart(8)}  ${(bytes / n).toFixed(1).padStart(6)} B/item  ` +
+      `${(bytes / 1024 / 1024).toFixed(1).padStart(6)} MB  build+10 scans median ${times[ROUNDS >> 1].toFixed(2).padStart(8)} ms`,
+  );
+}
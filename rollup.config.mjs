@@ -19,6 +19,8 @@ const nodeExternal = [
   "node:path",
   "node:url",
   "node:crypto",
+  "node:worker_threads",
+  "node:diagnostics_channel",
   ...assetExternal,
 ];
 
@@ -43,6 +45,20 @@ export default [
     external: nodeExternal,
     plugins: [resolve({ preferBuiltins: true }), commonjs(), ts(true)],
   },
+  // WorkerPool's worker entry (Node only), co-located with the Node build.
+  {
+    input: "./src/pool-worker.ts",
+    output: { file: "dist/pool-worker.mjs", format: "esm", sourcemap: true },
+    external: nodeExternal,
+    plugins: [resolve({ preferBuiltins: true }), commonjs(), ts(false)],
+  },
+  // ScriptCompiler's worker entry (Node only).
+  {
+    input: "./src/compile-worker.ts",
+    output: { file: "dist/compile-worker.mjs", format: "esm", sourcemap: true },
+    external: nodeExternal,
+    plugins: [resolve({ preferBuiltins: true }), commonjs(), ts(false)],
+  },
   // Browser build (ESM) — alias `./loader.js` to the fetch-based browser loader
   // so no `node:*` builtin enters the graph. No declarations (node build emits them).
   {
@@ -53,6 +69,9 @@ export default [
       alias({
         entries: [
           { find: "./loader.js", replacement: abs("./src/loader.browser.ts") },
+          { find: "./pool.js", replacement: abs("./src/pool.browser.ts") },
+          { find: "./compiler.js", replacement: abs("./src/compiler.browser.ts") },
+          { find: "./diagnostics.js", replacement: abs("./src/diagnostics.browser.ts") },
         ],
       }),
       resolve({ browser: true }),
@@ -21,3 +21,11 @@ try {
   const message = err instanceof Error ? err.message : String(err);
   throw new Error(`Failed to copy module from ${moduleSource}: ${message}`);
 }
+
+const glueSource = path.join(rootDir, "wasm", "build", "redis_lua.cjs");
+try {
+  await fs.copyFile(glueSource, path.join(distDir, "redis_lua.cjs"));
+} catch (err) {
+  const message = err instanceof Error ? err.message : String(err);
+  throw new Error(`Failed to copy CommonJS glue from ${glueSource}: ${message}`);
+}
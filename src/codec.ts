@@ -39,25 +39,31 @@
  * @module codec
  */
 
-import type { ReplyValue, RedisProps } from "./types.js";
+import type {
+  AllocationClass,
+  AllocationCount,
+  ReplyValue,
+  RedisProps,
+  RedisPropsDelta,
+} from "./types.js";
 
 /** Reply type tag: null/nil value. Wire format: [0x00][0x00000000] */
-const REPLY_NULL = 0x00;
+export const REPLY_NULL = 0x00;
 
 /** Reply type tag: 64-bit signed integer. Wire format: [0x01][0x00000008][int64le] */
-const REPLY_INT = 0x01;
+export const REPLY_INT = 0x01;
 
 /** Reply type tag: bulk string (binary-safe bytes). Wire format: [0x02][length: u32le][bytes...] */
-const REPLY_BULK = 0x02;
+export const REPLY_BULK = 0x02;
 
 /** Reply type tag: array of nested replies. Wire format: [0x03][count: u32le][reply1][reply2]... */
-const REPLY_ARRAY = 0x03;
+export const REPLY_ARRAY = 0x03;
 
 /** Reply type tag: status reply (Redis +OK style). Wire format: [0x04][length: u32le][bytes...] */
-const REPLY_STATUS = 0x04;
+export const REPLY_STATUS = 0x04;
 
 /** Reply type tag: error reply (Redis -ERR style). Wire format: [0x05][length: u32le][bytes...] */
-const REPLY_ERROR = 0x05;
+export const REPLY_ERROR = 0x05;
 
 /**
  * Reply type tag: script-aborting error. Same wire payload as REPLY_ERROR, but
@@ -69,12 +75,12 @@ const REPLY_ERROR = 0x05;
  */
 export const REPLY_SCRIPT_ERROR = 0x06;
 
-const REPLY_BOOL = 0x07;
-const REPLY_DOUBLE = 0x08;
-const REPLY_MAP = 0x09;
-const REPLY_SET = 0x0a;
-const REPLY_BIG_NUMBER = 0x0b;
-const REPLY_VERBATIM = 0x0c;
+export const REPLY_BOOL = 0x07;
+export const REPLY_DOUBLE = 0x08;
+export const REPLY_MAP = 0x09;
+export const REPLY_SET = 0x0a;
+export const REPLY_BIG_NUMBER = 0x0b;
+export const REPLY_VERBATIM = 0x0c;
 
 /** redisProps wire kinds. */
 const PROP_KIND_FIELD = 0;
@@ -179,6 +185,20 @@ function header(type: number, countOrLen: number): Buffer {
   return out;
 }
 
+/**
+ * A reply already in the wire format, typically from a `ReplyBuilder`.
+ * {@link encodeReplyValue} returns its bytes as they are, after one
+ * `instanceof` check and no shape probing.
+ */
+export class EncodedReply {
+  constructor(readonly bytes: Buffer) {}
+
+  /** True for an error reply. */
+  get isError(): boolean {
+    return this.bytes[0] === REPLY_ERROR;
+  }
+}
+
 /**
  * Encodes a ReplyValue into the ABI wire format for transmission to WASM.
  *
@@ -197,9 +217,14 @@ function header(type: number, countOrLen: number): Buffer {
  * encodeReplyValue({ ok: Buffer.from("OK") });     // STATUS reply
  * encodeReplyValue({ err: Buffer.from("ERR") });   // ERROR reply
  * encodeReplyValue([1, 2, 3]);                     // ARRAY reply
+ * encodeReplyValue(new ReplyBuilder().int(1).finish()); // as built
  * ```
  */
-export function encodeReplyValue(value: ReplyValue): Buffer {
+export function encodeReplyValue(value: ReplyValue | EncodedReply): Buffer {
+  if (value instanceof EncodedReply) {
+    return value.bytes;
+  }
+
   // Handle null/undefined -> NULL reply
   if (value === null || value === undefined) {
     return Buffer.from([REPLY_NULL, 0, 0, 0, 0]);
@@ -501,15 +526,27 @@ export function encodeArgArray(
  *   [payload]     // bool: u8 | number: f64le | string: u32 len + bytes | none: (empty)
  * ```
  *
+ * A `null` entry (in a {@link RedisPropsDelta}) is a field with no value, which
+ * removes the member.
+ *
  * @throws TypeError if an entry does not have exactly one of `value` / `returns`.
  */
-export function encodeRedisProps(props: RedisProps | undefined): Buffer {
+export function encodeRedisProps(props: RedisProps | RedisPropsDelta | undefined): Buffer {
   const names = props ? Object.keys(props) : [];
   const header = Buffer.alloc(4);
   header.writeUInt32LE(names.length, 0);
   const parts: Buffer[] = [header];
 
   for (const name of names) {
+    const nameBuf = Buffer.from(name, "utf8");
+    const nameHeader = Buffer.alloc(4);
+    nameHeader.writeUInt32LE(nameBuf.length, 0);
+    parts.push(nameHeader, nameBuf);
+
+    if (props![name] === null) {
+      parts.push(Buffer.from([PROP_KIND_FIELD, PROP_VTYPE_NONE]));
+      continue;
+    }
     const prop = props![name] as Record<string, unknown>;
     const hasValue = Object.prototype.hasOwnProperty.call(prop, "value");
     const hasReturns = Object.prototype.hasOwnProperty.call(prop, "returns");
@@ -519,11 +556,6 @@ export function encodeRedisProps(props: RedisProps | undefined): Buffer {
       );
     }
 
-    const nameBuf = Buffer.from(name, "utf8");
-    const nameHeader = Buffer.alloc(4);
-    nameHeader.writeUInt32LE(nameBuf.length, 0);
-    parts.push(nameHeader, nameBuf);
-
     const kind = hasValue ? PROP_KIND_FIELD : PROP_KIND_STUB;
     const raw = hasValue ? prop.value : prop.returns;
     parts.push(Buffer.from([kind]));
@@ -563,6 +595,98 @@ function encodePropValue(raw: unknown, name: string, isField: boolean): Buffer {
   );
 }
 
+/**
+ * Decodes a `profile_take` blob (profiling builds only) into opcode and
+ * C-function call counts.
+ *
+ * Two sections, opcodes then C functions, each:
+ * ```
+ * [count: u32] { [name_len: u32][name bytes][calls: u64] } * count
+ * ```
+ */
+export function decodeProfile(buffer: Buffer): {
+  opcodes: Record<string, number>;
+  cfunctions: Record<string, number>;
+} {
+  let offset = 0;
+  const readSection = (): Record<string, number> => {
+    const section: Record<string, number> = {};
+    const count = buffer.readUInt32LE(offset);
+    offset += 4;
+    for (let i = 0; i < count; i++) {
+      const nameLen = buffer.readUInt32LE(offset);
+      offset += 4;
+      const name = buffer.toString("utf8", offset, offset + nameLen);
+      offset += nameLen;
+      section[name] = Number(buffer.readBigUInt64LE(offset));
+      offset += 8;
+    }
+    return section;
+  };
+  const opcodes = readSection();
+  const cfunctions = readSection();
+  return { opcodes, cfunctions };
+}
+
+/** Object types in `alloc_snapshot` order (see wasm/src/alloc_track.c). */
+export const ALLOCATION_CLASSES: readonly AllocationClass[] = [
+  "string",
+  "table",
+  "function",
+  "proto",
+  "userdata",
+  "thread",
+  "upvalue",
+];
+
+/** One owner slot from an `alloc_snapshot` blob. */
+export type AllocationEntry = {
+  owner: number;
+  liveBytes: number;
+  liveBlocks: number;
+  allocations: number;
+  allocatedBytes: number;
+  objects: Record<AllocationClass, AllocationCount>;
+};
+
+/**
+ * Decodes an `alloc_snapshot` blob into per-owner entries. Classes past the
+ * ones this version knows are skipped.
+ *
+ * ```
+ * [owner_count: u32][class_count: u32]
+ * { [owner: u32][live_bytes: u64][live_blocks: u64][allocations: u64]
+ *   [allocated_bytes: u64] { [objects: u64][bytes: u64] } * class_count }
+ * * owner_count
+ * ```
+ */
+export function decodeAllocationSnapshot(buffer: Buffer): AllocationEntry[] {
+  const ownerCount = buffer.readUInt32LE(0);
+  const classCount = buffer.readUInt32LE(4);
+  const u64 = (at: number) => Number(buffer.readBigUInt64LE(at));
+  const entries: AllocationEntry[] = [];
+  let offset = 8;
+  for (let i = 0; i < ownerCount; i++) {
+    const objects = {} as Record<AllocationClass, AllocationCount>;
+    for (const [cls, name] of ALLOCATION_CLASSES.entries()) {
+      const at = offset + 36 + cls * 16;
+      objects[name] = cls < classCount
+        ? { count: u64(at), bytes: u64(at + 8) }
+        : { count: 0, bytes: 0 };
+    }
+    entries.push({
+      owner: buffer.readUInt32LE(offset),
+      liveBytes: u64(offset + 4),
+      liveBlocks: u64(offset + 12),
+      allocations: u64(offset + 20),
+      allocatedBytes: u64(offset + 28),
+      objects,
+    });
+    offset += 36 + classCount * 16;
+  }
+  return entries;
+}
+
 /**
  * Packs a pointer and length into a single bigint for non-sret ABI paths.
  *
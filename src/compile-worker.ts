@@ -0,0 +1,37 @@
+/**
+ * @fileoverview Worker-thread entry point for {@link ScriptCompiler}.
+ *
+ * Instantiates the compiler's shared compiled module as a standalone engine,
+ * reports `ready`, then answers each `{ id, script }` with the script's
+ * bytecode or its compile error. Scripts are parsed here and never run.
+ *
+ * @module compile-worker
+ */
+
+import { parentPort, workerData } from "node:worker_threads";
+import type { CompileReply, CompileRequest, CompileWorkerData } from "./compiler.js";
+import { load } from "./engine.js";
+import { setBytecodeSealKey } from "./helpers.js";
+
+async function run(data: CompileWorkerData): Promise<void> {
+  setBytecodeSealKey(data.sealKey);
+  const module = await load({ ...data.load, wasmModule: data.wasmModule });
+  const engine = module.createStandalone();
+  parentPort!.on("message", ({ id, script }: CompileRequest) => {
+    let reply: CompileReply;
+    try {
+      reply = { id, bytecode: engine.compileScript(script) };
+    } catch (err) {
+      reply = { id, error: err instanceof Error ? err.message : String(err) };
+    }
+    parentPort!.postMessage(reply);
+  });
+  parentPort!.postMessage({ type: "ready" });
+}
+
+run(workerData as CompileWorkerData).catch((err: unknown) => {
+  parentPort!.postMessage({
+    type: "error",
+    message: err instanceof Error ? err.message : String(err),
+  });
+});
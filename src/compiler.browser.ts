@@ -0,0 +1,20 @@
+/**
+ * @fileoverview Browser stand-in for `compiler.ts`.
+ *
+ * The off-thread compiler is built on `node:worker_threads`; rollup aliases
+ * this file in for the browser target. `compileScript`, `installScript` and
+ * `evalSha` on an engine work in the browser, so a Web Worker engine can play
+ * the compiler's role.
+ *
+ * @module compiler.browser
+ */
+
+import type { ScriptCompilerOptions } from "./compiler.js";
+
+export class ScriptCompiler {
+  private constructor() {}
+
+  static async create(_options: ScriptCompilerOptions = {}): Promise<ScriptCompiler> {
+    throw new Error("ScriptCompiler requires Node.js worker_threads");
+  }
+}
@@ -0,0 +1,256 @@
+/**
+ * @fileoverview Off-thread `SCRIPT LOAD` compilation (Node.js).
+ *
+ * A `ScriptCompiler` owns one worker-thread engine that only parses. `load()`
+ * returns the script's sha at once and compiles in the background; when the
+ * bytecode arrives it is installed into every attached engine in one
+ * synchronous loop, so no eval on this thread observes a half-installed
+ * script. Until then the sha's status is `"pending"` and `evalSha` on a
+ * serving engine replies `NOSCRIPT`. Serving engines never run the parser for
+ * scripts registered this way.
+ *
+ * Bytecode is only valid for engines built from the same WASM binary; the
+ * compiler instantiates the same compiled module as its `load` options.
+ *
+ * The browser build aliases this module to `compiler.browser.ts`.
+ *
+ * @module compiler
+ */
+
+import type { Worker } from "node:worker_threads";
+import { bytecodeSealKey, computeSha1Hex, unsealBytecode } from "./helpers.js";
+import { ensureBuffer } from "./codec.js";
+import { compileWasm } from "./loader.js";
+import { workerEntryUrl } from "./pool.js";
+import type { LoadOptions } from "./types.js";
+
+/** Data the compile worker starts with. @internal */
+export type CompileWorkerData = {
+  wasmModule: WebAssembly.Module;
+  load: Omit<LoadOptions, "wasmModule">;
+  /** This thread's bytecode seal key, so the worker's bytecode installs here. */
+  sealKey: Uint8Array;
+};
+
+/** Request/reply exchanged with the compile worker. @internal */
+export type CompileRequest = { id: number; script: Uint8Array };
+/** @internal */
+export type CompileReply = { id: number; bytecode?: Uint8Array; error?: string };
+
+/** Options for {@link ScriptCompiler.create}. */
+export type ScriptCompilerOptions = {
+  /**
+   * Options the compile worker passes to `load()`. Must be structured-cloneable
+   * and select the same WASM binary as the engines the bytecode is installed in.
+   */
+  load?: LoadOptions;
+
+  /** Worker entry point. Default: the co-located `compile-worker` module. */
+  workerUrl?: string | URL;
+};
+
+/** Lifecycle of a script registered with {@link ScriptCompiler.load}. */
+export type ScriptStatus = "pending" | "ready" | "failed";
+
+/** Anything bytecode can be installed into (`LuaEngine`, `LuaWasmEngine`). */
+export type ScriptTarget = {
+  installScript(sha: string, bytecode: Buffer | Uint8Array): void;
+  scriptExists(sha: string): boolean;
+  scriptEvict(sha: string): void;
+};
+
+type Entry = {
+  status: ScriptStatus;
+  bytecode?: Uint8Array;
+  error?: string;
+  done: Promise<void>;
+  settle: () => void;
+};
+
+/**
+ * Compiles scripts on a worker thread and installs the bytecode into attached
+ * engines.
+ *
+ * ```typescript
+ * const compiler = await ScriptCompiler.create();
+ * compiler.attach(engine);
+ * const sha = compiler.load("return KEYS[1]");
+ * await compiler.ready(sha);
+ * engine.evalSha(sha, ["key:1"]);
+ * ```
+ */
+export class ScriptCompiler {
+  private readonly engines = new Set<ScriptTarget>();
+  private readonly scripts = new Map<string, Entry>();
+  private readonly inflight = new Map<number, string>();
+  private nextId = 1;
+  private closed = false;
+
+  private constructor(private readonly thread: Worker) {
+    thread.on("message", (msg: CompileReply) => this.onReply(msg));
+    thread.on("error", (err: Error) => this.failAll(err.message));
+    thread.on("exit", () => this.failAll("compile worker exited"));
+    thread.unref();
+  }
+
+  /** Compiles the WASM (unless `load.wasmModule` is given) and starts the compile worker. */
+  static async create(options: ScriptCompilerOptions = {}): Promise<ScriptCompiler> {
+    const { Worker } = await import("node:worker_threads");
+    const { wasmModule, ...load } = options.load ?? {};
+    const workerData: CompileWorkerData = {
+      wasmModule: wasmModule ?? (await compileWasm(load)),
+      load,
+      sealKey: bytecodeSealKey(),
+    };
+    const thread = new Worker(options.workerUrl ?? (await workerEntryUrl("compile-worker")), {
+      workerData,
+    });
+    await new Promise<void>((resolve, reject) => {
+      const onMessage = (msg: { type?: string; message?: string }) => {
+        if (msg.type === "ready") {
+          thread.off("message", onMessage);
+          thread.off("error", reject);
+          resolve();
+        } else if (msg.type === "error") {
+          reject(new Error(`compile worker failed to start: ${msg.message}`));
+        }
+      };
+      thread.on("message", onMessage);
+      thread.on("error", reject);
+    });
+    return new ScriptCompiler(thread);
+  }
+
+  /** Adds an engine; scripts already compiled are installed into it now. */
+  attach(engine: ScriptTarget): void {
+    for (const [sha, entry] of this.scripts) {
+      if (entry.status === "ready") {
+        engine.installScript(sha, entry.bytecode!);
+      }
+    }
+    this.engines.add(engine);
+  }
+
+  /** Stops installing into `engine`. Scripts it already has stay installed. */
+  detach(engine: ScriptTarget): void {
+    this.engines.delete(engine);
+  }
+
+  /**
+   * Registers a script and returns its sha. Compilation happens on the worker;
+   * the status stays `"pending"` until the bytecode is installed into every
+   * attached engine. Loading a script again is a no-op unless it failed.
+   */
+  load(script: Buffer | Uint8Array | string): string {
+    if (this.closed) {
+      throw new Error("ScriptCompiler is closed");
+    }
+    const scriptBuf = ensureBuffer(script, "script");
+    const sha = computeSha1Hex(scriptBuf).toString("utf8");
+    const existing = this.scripts.get(sha);
+    if (existing && existing.status !== "failed") {
+      return sha;
+    }
+
+    let settle!: () => void;
+    const done = new Promise<void>((resolve) => (settle = resolve));
+    this.scripts.set(sha, { status: "pending", done, settle });
+    const id = this.nextId++;
+    this.inflight.set(id, sha);
+    if (this.inflight.size === 1) {
+      this.thread.ref();
+    }
+    const request: CompileRequest = { id, script: scriptBuf };
+    this.thread.postMessage(request);
+    return sha;
+  }
+
+  /** Status of a registered script, or undefined if it was never loaded. */
+  status(sha: string): ScriptStatus | undefined {
+    return this.scripts.get(sha.toLowerCase())?.status;
+  }
+
+  /** Compile or install error of a `"failed"` script. */
+  error(sha: string): string | undefined {
+    return this.scripts.get(sha.toLowerCase())?.error;
+  }
+
+  /** Resolves once the script is installed; rejects if it failed. */
+  async ready(sha: string): Promise<void> {
+    const entry = this.scripts.get(sha.toLowerCase());
+    if (!entry) {
+      throw new Error(`unknown script ${sha}`);
+    }
+    await entry.done;
+    if (entry.status === "failed") {
+      throw new Error(entry.error);
+    }
+  }
+
+  /** Stops the worker. Pending scripts fail. */
+  async close(): Promise<void> {
+    if (this.closed) {
+      return;
+    }
+    this.closed = true;
+    this.engines.clear();
+    await this.thread.terminate();
+    this.failAll("ScriptCompiler closed");
+  }
+
+  private onReply(msg: CompileReply): void {
+    const sha = this.inflight.get(msg.id);
+    if (sha === undefined) {
+      return;
+    }
+    this.inflight.delete(msg.id);
+    if (this.inflight.size === 0) {
+      this.thread.unref();
+    }
+    const entry = this.scripts.get(sha)!;
+    if (msg.error !== undefined) {
+      this.fail(entry, msg.error);
+      return;
+    }
+    if (!unsealBytecode(Buffer.from(sha, "latin1"), msg.bytecode!)) {
+      this.fail(entry, "ERR bytecode was not compiled by this process for this sha");
+      return;
+    }
+    // One synchronous pass: every attached engine switches from NOSCRIPT to
+    // the compiled script before any other task on this thread runs. If one
+    // engine refuses it (say, over its quota), the engines it was installed
+    // into so far drop it again, so a failed script is on none of them.
+    const installed: ScriptTarget[] = [];
+    try {
+      for (const engine of this.engines) {
+        const had = engine.scriptExists(sha);
+        engine.installScript(sha, msg.bytecode!);
+        if (!had) {
+          installed.push(engine);
+        }
+      }
+    } catch (err) {
+      for (const engine of installed) {
+        engine.scriptEvict(sha);
+      }
+      this.fail(entry, err instanceof Error ? err.message : String(err));
+      return;
+    }
+    entry.status = "ready";
+    entry.bytecode = msg.bytecode;
+    entry.settle();
+  }
+
+  private fail(entry: Entry, error: string): void {
+    entry.status = "failed";
+    entry.error = error;
+    entry.settle();
+  }
+
+  private failAll(error: string): void {
+    for (const sha of this.inflight.values()) {
+      this.fail(this.scripts.get(sha)!, error);
+    }
+    this.inflight.clear();
+  }
+}
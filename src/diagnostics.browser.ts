@@ -0,0 +1,44 @@
+/**
+ * @fileoverview Browser stand-in for `diagnostics.ts`.
+ *
+ * There is no `node:diagnostics_channel` in the browser. `DIAGNOSTICS` is
+ * `false` here, so the bundler drops every guarded publish site; the channels
+ * exist only to satisfy the imports.
+ *
+ * @module diagnostics.browser
+ */
+
+import type {
+  CompileEvent,
+  EvalEndEvent,
+  EvalStartEvent,
+  HostCallEndEvent,
+  HostCallStartEvent,
+  PublishChannel,
+  RecycleEvent,
+  ResetEvent,
+} from "./diagnostics.js";
+
+export const DIAGNOSTICS_CHANNELS = {
+  evalStart: "lua-redis-wasm:eval:start",
+  evalEnd: "lua-redis-wasm:eval:end",
+  hostCallStart: "lua-redis-wasm:host-call:start",
+  hostCallEnd: "lua-redis-wasm:host-call:end",
+  compile: "lua-redis-wasm:compile",
+  reset: "lua-redis-wasm:reset",
+  recycle: "lua-redis-wasm:recycle",
+} as const;
+
+export const DIAGNOSTICS = false;
+
+function silent<T>(): PublishChannel<T> {
+  return { hasSubscribers: false, publish() {} };
+}
+
+export const evalStartChannel = silent<EvalStartEvent>();
+export const evalEndChannel = silent<EvalEndEvent>();
+export const hostCallStartChannel = silent<HostCallStartEvent>();
+export const hostCallEndChannel = silent<HostCallEndEvent>();
+export const compileChannel = silent<CompileEvent>();
+export const resetChannel = silent<ResetEvent>();
+export const recycleChannel = silent<RecycleEvent>();
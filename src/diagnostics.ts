@@ -0,0 +1,128 @@
+/**
+ * @fileoverview `node:diagnostics_channel` publishing (Node build).
+ *
+ * Engines publish structured events on the named channels below so APM agents
+ * can observe evals, host calls and lifecycle events without patching
+ * `LuaEngine`. Every publish site checks `hasSubscribers` first, so nothing is
+ * measured or allocated unless someone listens.
+ *
+ * ```js
+ * import diagnostics_channel from "node:diagnostics_channel";
+ * import { DIAGNOSTICS_CHANNELS } from "lua-redis-wasm";
+ * diagnostics_channel.subscribe(DIAGNOSTICS_CHANNELS.evalEnd, (event) => {
+ *   metrics.observe(event.sha, event.durationMs, event.fuelUsed);
+ * });
+ * ```
+ *
+ * The browser build aliases this module to `diagnostics.browser.ts`, where
+ * `DIAGNOSTICS` is `false` and the guarded blocks are dropped by the bundler.
+ *
+ * @module diagnostics
+ */
+
+import diagnosticsChannel from "node:diagnostics_channel";
+import type { LuaEngine } from "./engine.js";
+
+/** Channel names, for `diagnostics_channel.subscribe()`. */
+export const DIAGNOSTICS_CHANNELS = {
+  evalStart: "lua-redis-wasm:eval:start",
+  evalEnd: "lua-redis-wasm:eval:end",
+  hostCallStart: "lua-redis-wasm:host-call:start",
+  hostCallEnd: "lua-redis-wasm:host-call:end",
+  compile: "lua-redis-wasm:compile",
+  reset: "lua-redis-wasm:reset",
+  recycle: "lua-redis-wasm:recycle",
+} as const;
+
+/** Which engine method ran the eval. */
+export type EvalKind = "eval" | "evalWithArgs" | "evalSha";
+
+/** `evalStart`: an eval is about to enter WASM. */
+export type EvalStartEvent = {
+  engine: LuaEngine;
+  kind: EvalKind;
+  sha: string;
+  keys: number;
+};
+
+/** `evalEnd`: the eval's reply has been decoded. */
+export type EvalEndEvent = EvalStartEvent & {
+  durationMs: number;
+  /** Fuel charged, in units of the `maxFuel` limit (the hook charges 1000 at a time). */
+  fuelUsed: number;
+  /** Encoded reply size crossing the ABI. */
+  replyBytes: number;
+  /** True when the reply is an error. */
+  error: boolean;
+};
+
+/** `hostCallStart`: a script called `redis.call` or `redis.pcall`. */
+export type HostCallStartEvent = {
+  engine: LuaEngine | null;
+  kind: "call" | "pcall";
+  /** Command name, upper-cased. */
+  command: string;
+  /** Encoded argument size. */
+  argBytes: number;
+};
+
+/** `hostCallEnd`: the host's reply has been encoded for the script. */
+export type HostCallEndEvent = HostCallStartEvent & {
+  durationMs: number;
+  replyBytes: number;
+  /** True when the host replied with (or threw) an error. */
+  error: boolean;
+};
+
+/** `compile`: `compileScript()` (and so `scriptLoad()` and preloading) ran the parser. */
+export type CompileEvent = {
+  engine: LuaEngine;
+  sha: string;
+  sourceBytes: number;
+  /** Bytecode size; 0 when compilation failed. */
+  bytecodeBytes: number;
+  durationMs: number;
+  /** Compiler message when compilation failed. */
+  error?: string;
+};
+
+/** `reset`: `engine.reset()` replaced the Lua state. */
+export type ResetEvent = {
+  engine: LuaEngine;
+  durationMs: number;
+  /** Preloaded scripts re-installed into the new state. */
+  preloaded: number;
+};
+
+/** `recycle`: a `WorkerPool` started, retired or lost a worker. */
+export type RecycleEvent = {
+  action: "spawn" | "retire" | "exit";
+  /** The worker's stats slot. */
+  worker: number;
+  /** Serving workers after the change. */
+  workers: number;
+};
+
+/** A channel as used by the publish sites. */
+export type PublishChannel<T> = {
+  readonly hasSubscribers: boolean;
+  publish(message: T): void;
+};
+
+/** `false` in the browser build, so guarded publish sites compile out. */
+export const DIAGNOSTICS = true;
+
+export const evalStartChannel: PublishChannel<EvalStartEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.evalStart);
+export const evalEndChannel: PublishChannel<EvalEndEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.evalEnd);
+export const hostCallStartChannel: PublishChannel<HostCallStartEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.hostCallStart);
+export const hostCallEndChannel: PublishChannel<HostCallEndEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.hostCallEnd);
+export const compileChannel: PublishChannel<CompileEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.compile);
+export const resetChannel: PublishChannel<ResetEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.reset);
+export const recycleChannel: PublishChannel<RecycleEvent> =
+  diagnosticsChannel.channel(DIAGNOSTICS_CHANNELS.recycle);
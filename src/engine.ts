@@ -31,6 +31,7 @@
  * │                      LuaEngine                              │
  * │  - eval(script)                                             │
  * │  - evalWithArgs(script, keys, args)                         │
+ * │  - evalSha(sha, keys, args)                                 │
  * └─────────────────────────────────────────────────────────────┘
  * ```
  *
@@ -59,11 +60,25 @@ import type {
   StandaloneOptions,
   RedisProp,
   RedisProps,
+  RedisPropsDelta,
   CompatProfile,
   CompatOverrides,
+  PreloadScript,
+  ScriptProfile,
+  StartupTimings,
+  AllocationCount,
+  AllocationSnapshot,
+  AllocationStats,
+  EngineMemoryUsage,
+  ScriptCacheOptions,
+  ScriptCacheStats,
 } from "./types.js";
 import {
+  ALLOCATION_CLASSES,
+  decodeAllocationSnapshot,
+  decodeProfile,
   decodeReply,
+  EncodedReply,
   encodeArgArray,
   encodeRedisProps,
   ensureBuffer,
@@ -71,12 +86,28 @@ import {
   unpackPtrLen,
 } from "./codec.js";
 import {
+  compileWasm,
   loadModule,
   type HostImport,
   type WasmExports,
   defaultModulePath,
   defaultWasmPath,
 } from "./loader.js";
+import { emptyTimings, type PtrLenResult } from "./loader-core.js";
+import type { MemoryGovernor } from "./governor.js";
+import { ScriptNamespaces } from "./script-cache.js";
+import type { Tracer } from "./trace.js";
+import {
+  DIAGNOSTICS,
+  compileChannel,
+  evalEndChannel,
+  evalStartChannel,
+  hostCallEndChannel,
+  hostCallStartChannel,
+  resetChannel,
+  type EvalKind,
+} from "./diagnostics.js";
+import { WARMUP_CORPUS, WARMUP_ROUNDS, type WarmupEntry } from "./warmup.js";
 import {
   readBytes,
   allocAndWrite,
@@ -85,6 +116,8 @@ import {
   returnPtrLen,
   decodeArgs,
   computeSha1Hex,
+  sealBytecode,
+  unsealBytecode,
 } from "./helpers.js";
 
 /**
@@ -108,13 +141,60 @@ import {
  * ```
  */
 export class LuaEngine {
+  private profiles = new Map<string, ScriptProfile>();
+  /** Installed script sha -> bytecode size and SHA1 of the bytecode. */
+  private installed = new Map<string, { bytes: number; digest: string }>();
+  private scriptCacheBytes = 0;
+  /** Preloaded script sha -> its sealed bytecode, re-installed by reset. */
+  private preloaded = new Map<string, Buffer | Uint8Array>();
+  /** Which installed scripts each script cache namespace holds. */
+  private scripts: ScriptNamespaces;
+  /** `redis.*` changes from {@link updateRedisProps}, re-applied by reset. */
+  private redisPropsDelta: RedisPropsDelta = {};
+  /** Script sha -> allocation owner slot, when tracking allocations. */
+  private allocOwners = new Map<string, number>();
+  /** Owner slot of the eval in progress (0: none). */
+  private allocOwner = 0;
+  /** Evals charged to the engine because every owner slot was taken. */
+  private untrackedEvals = 0;
+  /** Owner slot -> reply/arg buffers copied across for its evals. */
+  private allocBuffers = new Map<number, { reply: AllocationCount; args: AllocationCount }>();
+  /** Set while warming up: evals publish no diagnostics and own no allocations. */
+  private warmingUp = false;
+  private tracer: Tracer | null = null;
+  /** Address of the WASM-side phase timestamps (5 x f64), 0 if not exported. */
+  private traceMarksPtr = 0;
+  /** Encoded size of the last reply decoded, for diagnostics events. */
+  private lastReplyBytes = 0;
+  private governor: MemoryGovernor | null = null;
+  /** Lua state closed by {@link hibernate}; rebuilt on next use. */
+  private hibernated = false;
+  private lastActive = performance.now();
+  /** Compat flags evals run under (see {@link useProfile}). */
+  private evalCompat: number;
+
   /**
    * @internal
    */
   constructor(
     private exports: WasmExports,
     private limits: EngineLimits | undefined,
-  ) {}
+    private timings: StartupTimings = emptyTimings(),
+    private trackAllocations = false,
+    scriptCache: ScriptCacheOptions = {},
+    private baseCompat = resolveCompatFlags(),
+  ) {
+    this.scripts = new ScriptNamespaces(scriptCache);
+    this.evalCompat = baseCompat;
+  }
+
+  /**
+   * Returns how long loading, init, warm-up and the first eval took.
+   * `firstEvalMs` is absent until the engine has run an eval.
+   */
+  getStartupTimings(): StartupTimings {
+    return { ...this.timings };
+  }
 
   /**
    * Returns the configured resource limits, if any.
@@ -124,6 +204,170 @@ export class LuaEngine {
     return this.limits;
   }
 
+  /**
+   * Returns opcode and C-function call histograms keyed by script sha,
+   * accumulated since the engine was created or {@link clearProfile} was last
+   * called. Always empty unless the WASM module is a profiling build
+   * (`npm run build:wasm:profile`).
+   */
+  getProfile(): Map<string, ScriptProfile> {
+    return new Map(
+      [...this.profiles].map(([sha, p]) => [
+        sha,
+        { evals: p.evals, opcodes: { ...p.opcodes }, cfunctions: { ...p.cfunctions } },
+      ]),
+    );
+  }
+
+  /** Discards all accumulated profiles. */
+  clearProfile(): void {
+    this.profiles.clear();
+  }
+
+  /**
+   * Evaluates each entry of `corpus` `rounds` times without publishing
+   * diagnostics or attributing allocations to the warm-up scripts, then
+   * discards the profiles they produced.
+   * @internal
+   */
+  warmUp(corpus: WarmupEntry[], rounds: number): void {
+    this.warmingUp = true;
+    try {
+      for (let round = 0; round < rounds; round++) {
+        for (const { script, keys, args } of corpus) {
+          this.evalWithArgs(script, keys, args);
+        }
+      }
+    } finally {
+      this.warmingUp = false;
+    }
+    this.clearProfile();
+  }
+
+  /**
+   * Starts recording every eval's lifecycle into `tracer` (see {@link Tracer}),
+   * or stops with `null`. Without a tracer, evals take no timestamps.
+   */
+  setTracer(tracer: Tracer | null): void {
+    this.exports._set_trace?.(tracer ? 1 : 0);
+    this.traceMarksPtr = tracer ? (this.exports._trace_marks?.() ?? 0) : 0;
+    this.tracer = tracer;
+  }
+
+  /** The tracer set by {@link setTracer} or `LoadOptions.tracer`, if any. */
+  getTracer(): Tracer | null {
+    return this.tracer;
+  }
+
+  /**
+   * Registers with `governor` (see {@link MemoryGovernor}), leaving any
+   * previous one, or unregisters with `null`.
+   */
+  setMemoryGovernor(governor: MemoryGovernor | null): void {
+    this.governor?.unregister(this);
+    this.governor = governor;
+    governor?.register(this);
+  }
+
+  /** Current Lua heap, script cache and WASM memory usage. */
+  getMemoryUsage(): EngineMemoryUsage {
+    return {
+      luaHeapBytes: this.exports._heap_bytes?.() ?? 0,
+      scriptCacheBytes: this.scriptCacheBytes,
+      cachedScripts: this.installed.size,
+      wasmMemoryBytes: this.exports.HEAPU8.buffer.byteLength,
+      hibernated: this.hibernated,
+      idleMs: performance.now() - this.lastActive,
+    };
+  }
+
+  /**
+   * Evicts cached scripts other than preloaded ones; `evalSha` replies
+   * `NOSCRIPT` for them until they are loaded again. Returns the bytecode bytes
+   * dropped.
+   */
+  shrinkScriptCache(): number {
+    if (!this.exports._script_evict || this.hibernated) {
+      return 0;
+    }
+    return this.evictScripts(this.scripts.shrink());
+  }
+
+  /** Script cache usage and `evalSha` hit rates by namespace. */
+  getScriptCacheStats(): Record<string, ScriptCacheStats> {
+    return this.scripts.stats();
+  }
+
+  /**
+   * Runs an incremental GC step of `stepKb` KB, or a full collection when 0.
+   * Returns the Lua heap size afterwards.
+   */
+  collectGarbage(stepKb = 0): number {
+    return this.hibernated ? 0 : (this.exports._gc_step?.(stepKb) ?? 0);
+  }
+
+  /**
+   * Closes the Lua state, freeing its heap; returns the bytes freed. The next
+   * eval (or compile/install) rebuilds the state as {@link reset} does. The
+   * WASM instance keeps its linear memory for the new state to reuse.
+   */
+  hibernate(): number {
+    const close = this.exports._hibernate;
+    if (!close || this.hibernated) {
+      return 0;
+    }
+    const freed = this.exports._heap_bytes?.() ?? 0;
+    close();
+    this.hibernated = true;
+    this.clearState();
+    return freed;
+  }
+
+  /**
+   * Returns Lua heap usage by script sha and object type. By default a full
+   * garbage collection runs first, so live figures only count reachable
+   * objects; pass `false` to see the heap as it is, garbage included.
+   *
+   * @throws Error unless the engine was loaded with `trackAllocations: true`
+   */
+  getAllocationSnapshot(collect = true): AllocationSnapshot {
+    const snapshot = this.requireExport(this.exports._alloc_snapshot, "_alloc_snapshot");
+    if (!this.trackAllocations) {
+      throw new Error("Allocation tracking is off; load with trackAllocations: true");
+    }
+    const { ptr, len } = this.resultPtrLen(this.callPtrLen(snapshot, collect ? 1 : 0));
+    const entries = ptr
+      ? decodeAllocationSnapshot(Buffer.from(this.exports.HEAPU8.subarray(ptr, ptr + len)))
+      : [];
+    if (ptr) {
+      this.exports._free_mem(ptr);
+    }
+    const byOwner = new Map(entries.map((entry) => [entry.owner, entry]));
+    const stats = (owner: number): AllocationStats => {
+      const entry = byOwner.get(owner);
+      const buffers = this.allocBuffers.get(owner);
+      return {
+        liveBytes: entry?.liveBytes ?? 0,
+        liveBlocks: entry?.liveBlocks ?? 0,
+        allocations: entry?.allocations ?? 0,
+        allocatedBytes: entry?.allocatedBytes ?? 0,
+        objects: entry?.objects ?? emptyObjectCounts(),
+        replyBuffers: { ...(buffers?.reply ?? { count: 0, bytes: 0 }) },
+        argBuffers: { ...(buffers?.args ?? { count: 0, bytes: 0 }) },
+      };
+    };
+    const scripts: Record<string, AllocationStats> = {};
+    for (const [sha, owner] of this.allocOwners) {
+      scripts[sha] = stats(owner);
+    }
+    return {
+      liveBytes: entries.reduce((sum, entry) => sum + entry.liveBytes, 0),
+      engine: stats(0),
+      scripts,
+      untrackedEvals: this.untrackedEvals,
+    };
+  }
+
   /**
    * Evaluates a Lua script and returns the result.
    *
@@ -146,13 +390,31 @@ export class LuaEngine {
    * ```
    */
   eval(script: Buffer | Uint8Array | string): ReplyValue {
+    const refused = this.admit();
+    if (refused) {
+      return refused;
+    }
+    const start = this.timings.firstEvalMs === undefined ? performance.now() : 0;
+    const tracer = this.tracer;
+    const traceStart = tracer ? performance.now() : 0;
     const scriptBuf = ensureBuffer(script, "script");
     const sha = computeSha1Hex(scriptBuf).toString("utf8");
     const ptr = this.exports._alloc(scriptBuf.length);
     this.exports.HEAPU8.set(scriptBuf, ptr);
+    const published = DIAGNOSTICS ? this.publishEvalStart("eval", sha, 0) : 0;
+    this.enterAllocOwner(sha);
+    const callStart = tracer ? performance.now() : 0;
     const result = this.callEval(ptr, scriptBuf.length);
+    const callEnd = tracer ? performance.now() : 0;
     this.exports._free_mem(ptr);
-    return this.decodeResult(result, sha);
+    const reply = this.decodeResult(result, sha);
+    if (DIAGNOSTICS && published) {
+      this.publishEvalEnd("eval", sha, 0, published, reply);
+    }
+    if (tracer) {
+      this.traceEval(tracer, "EVAL", { sha }, traceStart, callStart, callEnd);
+    }
+    return this.finishEval(start, reply);
   }
 
   /**
@@ -181,9 +443,17 @@ export class LuaEngine {
     keys: Array<Buffer | Uint8Array | string> = [],
     args: Array<Buffer | Uint8Array | string> = [],
   ): ReplyValue {
+    const refused = this.admit();
+    if (refused) {
+      return refused;
+    }
+    const start = this.timings.firstEvalMs === undefined ? performance.now() : 0;
+    const tracer = this.tracer;
+    const traceStart = tracer ? performance.now() : 0;
     const scriptBuf = ensureBuffer(script, "script");
     const sha = computeSha1Hex(scriptBuf).toString("utf8");
     const argBuf = encodeArgArray([...keys, ...args]);
+    const argsEncoded = tracer ? performance.now() : 0;
 
     // Enforce maxArgBytes limit on host side
     if (this.limits?.maxArgBytes && argBuf.length > this.limits.maxArgBytes) {
@@ -196,7 +466,10 @@ export class LuaEngine {
     const argsPtr = this.exports._alloc(argBuf.length);
     this.exports.HEAPU8.set(scriptBuf, scriptPtr);
     this.exports.HEAPU8.set(argBuf, argsPtr);
+    const published = DIAGNOSTICS ? this.publishEvalStart("evalWithArgs", sha, keys.length) : 0;
+    this.enterAllocOwner(sha, argBuf.length);
 
+    const callStart = tracer ? performance.now() : 0;
     const result = this.callEvalWithArgs(
       scriptPtr,
       scriptBuf.length,
@@ -204,10 +477,554 @@ export class LuaEngine {
       argBuf.length,
       keys.length,
     );
+    const callEnd = tracer ? performance.now() : 0;
 
     this.exports._free_mem(scriptPtr);
     this.exports._free_mem(argsPtr);
-    return this.decodeResult(result, sha);
+    const reply = this.decodeResult(result, sha);
+    if (DIAGNOSTICS && published) {
+      this.publishEvalEnd("evalWithArgs", sha, keys.length, published, reply);
+    }
+    if (tracer) {
+      const info = { sha, keys: keys.length, argBytes: argBuf.length };
+      this.traceEval(tracer, "EVAL", info, traceStart, callStart, callEnd, argsEncoded);
+    }
+    return this.finishEval(start, reply);
+  }
+
+  /**
+   * Compiles a script to bytecode without running it (the parse half of
+   * `SCRIPT LOAD`). The bytecode is sealed with an HMAC over it and the
+   * source's sha under a per-process key, and can be installed under that sha
+   * into any engine in this process built from the same WASM binary with
+   * {@link installScript}. It is opaque: persisting it or passing it to
+   * another process is not supported.
+   *
+   * @throws Error with the compiler's message if the script does not compile
+   */
+  compileScript(script: Buffer | Uint8Array | string): Buffer {
+    const compile = this.requireExport(this.exports._script_compile, "_script_compile");
+    this.wake();
+    const scriptBuf = ensureBuffer(script, "script");
+    const start = DIAGNOSTICS && compileChannel.hasSubscribers ? performance.now() : 0;
+    const ptr = this.exports._alloc(scriptBuf.length);
+    this.exports.HEAPU8.set(scriptBuf, ptr);
+    const reply = this.takeReply(this.callPtrLen(compile, ptr, scriptBuf.length));
+    this.exports._free_mem(ptr);
+    const compiled = Buffer.isBuffer(reply);
+    const error = compiled ? undefined : replyErrorMessage(reply, "ERR script compile failed");
+    const shaBuf = computeSha1Hex(scriptBuf);
+    if (DIAGNOSTICS && start) {
+      compileChannel.publish({
+        engine: this,
+        sha: shaBuf.toString("utf8"),
+        sourceBytes: scriptBuf.length,
+        bytecodeBytes: compiled ? reply.length : 0,
+        durationMs: performance.now() - start,
+        error,
+      });
+    }
+    if (!compiled) {
+      throw new Error(error);
+    }
+    return sealBytecode(shaBuf, reply);
+  }
+
+  /**
+   * Installs bytecode from {@link compileScript} under `sha` in `namespace`
+   * (see `LoadOptions.scriptCache`). {@link evalSha} in the same namespace then
+   * runs it without parsing. A failed install leaves any script already cached
+   * under `sha` in place. A namespace over its quota evicts its least recently
+   * used scripts.
+   *
+   * Loading bytecode is unsafe (the VM refuses binary chunks from scripts for
+   * this reason): crafted bytecode can corrupt the interpreter. Only bytecode
+   * that `compileScript` in this process sealed for the source with this `sha`
+   * is accepted, so bytecode from any other origin (disk, the network, another
+   * process) is rejected rather than trusted.
+   *
+   * @throws Error if `sha` is not 40 hex chars, the bytecode is not sealed for
+   * `sha` or is rejected by the VM, or it alone exceeds the namespace's quota
+   */
+  installScript(sha: string, bytecode: Buffer | Uint8Array, namespace = ""): void {
+    const install = this.requireExport(this.exports._script_install, "_script_install");
+    this.wake();
+    const shaBuf = shaBuffer(sha);
+    if (!shaBuf) {
+      throw new Error("ERR invalid script sha");
+    }
+    const bcBuf = unsealBytecode(shaBuf, ensureBuffer(bytecode, "bytecode"));
+    if (!bcBuf) {
+      throw new Error("ERR bytecode was not compiled by this process for this sha");
+    }
+    this.scripts.checkFits(namespace, bcBuf.length);
+    // The VM caches one function per sha for every namespace: replacing it
+    // under another namespace's feet would swap that tenant's script.
+    const key = shaBuf.toString("latin1");
+    const digest = computeSha1Hex(bcBuf).toString("latin1");
+    const current = this.installed.get(key);
+    if (current && current.digest !== digest && this.scripts.heldElsewhere(namespace, key)) {
+      throw new Error(`ERR script ${key} is loaded with different bytecode in another namespace`);
+    }
+    const shaPtr = allocAndWrite(this.exports, shaBuf);
+    const bcPtr = allocAndWrite(this.exports, bcBuf);
+    this.enterAllocOwner(key);
+    const reply = this.takeReply(this.callPtrLen(install, shaPtr, bcPtr, bcBuf.length));
+    this.leaveAllocOwner();
+    this.exports._free_mem(shaPtr);
+    this.exports._free_mem(bcPtr);
+    if (reply && typeof reply === "object" && "err" in reply) {
+      throw new Error(replyErrorMessage(reply, "ERR script install failed"));
+    }
+    this.scriptCacheBytes += bcBuf.length - (current?.bytes ?? 0);
+    this.installed.set(key, { bytes: bcBuf.length, digest });
+    this.evictScripts(this.scripts.add(namespace, key, bcBuf.length));
+  }
+
+  /**
+   * Compiles and installs a script on this engine, returning its sha
+   * (`SCRIPT LOAD`). To keep the parser off a serving engine, compile
+   * elsewhere (e.g. with a {@link ScriptCompiler}) and call
+   * {@link installScript} instead.
+   */
+  scriptLoad(script: Buffer | Uint8Array | string, namespace = ""): string {
+    const scriptBuf = ensureBuffer(script, "script");
+    const sha = computeSha1Hex(scriptBuf).toString("utf8");
+    this.installScript(sha, this.compileScript(scriptBuf), namespace);
+    return sha;
+  }
+
+  /** True if a script is installed under `sha` in `namespace`. */
+  scriptExists(sha: string, namespace = ""): boolean {
+    return this.scripts.has(namespace, sha.toLowerCase());
+  }
+
+  /**
+   * Compiles and installs scripts, keeping their bytecode so {@link reset}
+   * can re-install them without parsing. A sha preloaded again is kept once.
+   * Bytecode entries must come from {@link compileScript} in this process for
+   * the given sha (see {@link installScript}). Returns the shas in input order.
+   *
+   * @throws Error listing every script that failed; the others stay installed
+   */
+  preloadScripts(scripts: PreloadScript[]): string[] {
+    const shas: string[] = [];
+    const failures: string[] = [];
+    for (const script of scripts) {
+      let sha = "";
+      try {
+        let bytecode: Buffer | Uint8Array;
+        if (script instanceof Uint8Array || typeof script === "string") {
+          const source = ensureBuffer(script, "script");
+          sha = computeSha1Hex(source).toString("utf8");
+          bytecode = this.compileScript(source);
+        } else {
+          sha = script.sha.toLowerCase();
+          bytecode = script.bytecode;
+        }
+        this.installScript(sha, bytecode);
+        this.scripts.pin(sha);
+        this.preloaded.set(sha, bytecode);
+        shas.push(sha);
+      } catch (err) {
+        failures.push(`${sha || "script"}: ${err instanceof Error ? err.message : String(err)}`);
+      }
+    }
+    if (failures.length) {
+      throw new Error(`ERR ${failures.length} preloaded script(s) failed: ${failures.join("; ")}`);
+    }
+    return shas;
+  }
+
+  /**
+   * Replaces the Lua state with a fresh one: globals, loaded libraries and the
+   * script cache start over, while limits and compatibility settings are kept.
+   * Scripts from {@link preloadScripts} (and `LoadOptions.scripts`) are
+   * re-installed from their bytecode.
+   */
+  reset(): void {
+    const start = DIAGNOSTICS && resetChannel.hasSubscribers ? performance.now() : 0;
+    const result = this.hibernated ? this.exports._init() : this.exports._reset();
+    if (typeof result === "number" && result !== 0) {
+      throw new Error("Failed to reset Lua WASM engine");
+    }
+    this.hibernated = false;
+    this.clearState();
+    if (Object.keys(this.redisPropsDelta).length) {
+      this.applyRedisProps(encodeRedisProps(this.redisPropsDelta));
+    }
+    for (const [sha, bytecode] of this.preloaded) {
+      this.installScript(sha, bytecode);
+      this.scripts.pin(sha);
+    }
+    if (DIAGNOSTICS && start) {
+      resetChannel.publish({
+        engine: this,
+        durationMs: performance.now() - start,
+        preloaded: this.preloaded.size,
+      });
+    }
+  }
+
+  /**
+   * Applies `delta` to the live `redis` table: entries add or replace members
+   * (as in `LoadOptions.redisProps`) and `null` removes one. The table stays
+   * readonly to scripts; globals and cached scripts are untouched, so a config
+   * change needs no {@link reset}. Changes are kept across resets. A hibernated
+   * engine applies them when it next wakes.
+   *
+   * @throws TypeError for a malformed prop
+   */
+  updateRedisProps(delta: RedisPropsDelta): void {
+    this.requireExport(this.exports._update_redis_props, "_update_redis_props");
+    const blob = encodeRedisProps(delta);
+    if (!this.hibernated) {
+      this.applyRedisProps(blob);
+    }
+    Object.assign(this.redisPropsDelta, delta);
+  }
+
+  /**
+   * Runs later evals (`eval`, `evalWithArgs`, `evalSha`) under another
+   * compatibility profile's globals, or the engine's own when called with no
+   * arguments. Only `print`, `os` and `server` differ between profiles; the
+   * script cache, libraries and `redis` table are shared. Once a profile's
+   * environment exists (see `LoadOptions.profiles`), switching swaps one
+   * pointer. The selection is kept across {@link reset}.
+   */
+  useProfile(profile?: CompatProfile, compat?: CompatOverrides): void {
+    const flags = profile === undefined && compat === undefined
+      ? this.baseCompat
+      : resolveCompatFlags(profile, compat);
+    if (flags === this.evalCompat) {
+      return;
+    }
+    this.requireExport(this.exports._use_compat, "_use_compat")(flags);
+    this.evalCompat = flags;
+  }
+
+  /**
+   * Drops the script installed under `sha` from `namespace`. It stays installed
+   * for other namespaces that hold it.
+   */
+  scriptEvict(sha: string, namespace = ""): void {
+    this.evictScripts(this.scripts.remove(namespace, sha.toLowerCase()));
+  }
+
+  /**
+   * Drops every installed script (`SCRIPT FLUSH`), or only `namespace`'s.
+   * Scripts other namespaces also hold stay installed for them.
+   */
+  scriptFlush(namespace?: string): void {
+    if (namespace !== undefined && this.exports._script_evict) {
+      this.evictScripts(this.scripts.flush(namespace));
+      return;
+    }
+    this.exports._script_flush?.();
+    this.installed.clear();
+    this.scriptCacheBytes = 0;
+    this.scripts.clear();
+  }
+
+  /**
+   * Runs an installed script by sha with KEYS and ARGV (`EVALSHA`). Replies
+   * `NOSCRIPT` if nothing is installed under `sha` in `namespace`.
+   */
+  evalSha(
+    sha: string,
+    keys: Array<Buffer | Uint8Array | string> = [],
+    args: Array<Buffer | Uint8Array | string> = [],
+    namespace = "",
+  ): ReplyValue {
+    const refused = this.admit();
+    if (refused) {
+      return refused;
+    }
+    const start = this.timings.firstEvalMs === undefined ? performance.now() : 0;
+    const tracer = this.tracer;
+    const traceStart = tracer ? performance.now() : 0;
+    const evalSha = this.requireExport(this.exports._eval_sha, "_eval_sha");
+    const shaBuf = shaBuffer(sha);
+    if (!shaBuf || !this.scripts.lookup(namespace, shaBuf.toString("latin1"))) {
+      return {
+        err: Buffer.from("No matching script. Please use EVAL.", "utf8"),
+        code: Buffer.from("NOSCRIPT", "utf8"),
+      };
+    }
+    const argBuf = encodeArgArray([...keys, ...args]);
+    const argsEncoded = tracer ? performance.now() : 0;
+    if (this.limits?.maxArgBytes && argBuf.length > this.limits.maxArgBytes) {
+      return {
+        err: Buffer.from("ERR KEYS/ARGV exceeds configured limit", "utf8"),
+      };
+    }
+    const shaPtr = allocAndWrite(this.exports, shaBuf);
+    const argsPtr = allocAndWrite(this.exports, argBuf);
+    const key = shaBuf.toString("latin1");
+    const published = DIAGNOSTICS ? this.publishEvalStart("evalSha", key, keys.length) : 0;
+    this.enterAllocOwner(key, argBuf.length);
+    const callStart = tracer ? performance.now() : 0;
+    const result = this.callPtrLen(evalSha, shaPtr, argsPtr, argBuf.length, keys.length);
+    const callEnd = tracer ? performance.now() : 0;
+    this.exports._free_mem(shaPtr);
+    this.exports._free_mem(argsPtr);
+    const reply = this.decodeResult(result, key);
+    if (DIAGNOSTICS && published) {
+      this.publishEvalEnd("evalSha", key, keys.length, published, reply);
+    }
+    if (tracer) {
+      const info = { sha: key, keys: keys.length, argBytes: argBuf.length };
+      this.traceEval(tracer, "EVALSHA", info, traceStart, callStart, callEnd, argsEncoded);
+    }
+    return this.finishEval(start, reply);
+  }
+
+  /**
+   * Attributes Lua allocations to `sha` until {@link leaveAllocOwner}, and
+   * counts the eval's KEYS/ARGV buffer. No-op unless tracking allocations.
+   * @private
+   */
+  private enterAllocOwner(sha: string, argBytes?: number): void {
+    if (!this.trackAllocations || this.warmingUp) {
+      return;
+    }
+    let owner = this.allocOwners.get(sha);
+    if (owner === undefined) {
+      owner = this.allocOwners.size + 1 < ALLOC_OWNER_SLOTS ? this.allocOwners.size + 1 : 0;
+      if (owner) {
+        this.allocOwners.set(sha, owner);
+      } else {
+        this.untrackedEvals++;
+      }
+    }
+    this.allocOwner = owner;
+    this.exports._set_alloc_owner?.(owner);
+    if (argBytes !== undefined) {
+      const buffers = this.ownerBuffers(owner);
+      buffers.args.count++;
+      buffers.args.bytes += argBytes;
+    }
+  }
+
+  /** Back to the engine owner, counting the reply buffer if there was one. @private */
+  private leaveAllocOwner(replyBytes = 0): void {
+    if (!this.trackAllocations || this.warmingUp) {
+      return;
+    }
+    if (replyBytes) {
+      const buffers = this.ownerBuffers(this.allocOwner);
+      buffers.reply.count++;
+      buffers.reply.bytes += replyBytes;
+    }
+    this.allocOwner = 0;
+    this.exports._set_alloc_owner?.(0);
+  }
+
+  /** @private */
+  private ownerBuffers(owner: number): { reply: AllocationCount; args: AllocationCount } {
+    let buffers = this.allocBuffers.get(owner);
+    if (!buffers) {
+      buffers = { reply: { count: 0, bytes: 0 }, args: { count: 0, bytes: 0 } };
+      this.allocBuffers.set(owner, buffers);
+    }
+    return buffers;
+  }
+
+  /**
+   * Records one eval's spans: the eval, KEYS/ARGV encoding (when
+   * `argsEncoded` is given), the WASM call with the phases it timestamped, and
+   * the reply decode. Host calls were recorded as they happened.
+   * @private
+   */
+  private traceEval(
+    tracer: Tracer,
+    name: string,
+    info: Record<string, string | number>,
+    start: number,
+    callStart: number,
+    callEnd: number,
+    argsEncoded?: number,
+  ): void {
+    const end = performance.now();
+    tracer.span(name, "eval", start, end, info);
+    if (argsEncoded !== undefined) {
+      tracer.span("encode args", "js", start, argsEncoded);
+    }
+    tracer.span("wasm", "wasm", callStart, callEnd);
+    if (this.traceMarksPtr) {
+      const marks = new Float64Array(this.exports.HEAPU8.buffer, this.traceMarksPtr, 5);
+      for (let i = 1; i < marks.length; i++) {
+        if (marks[i - 1] && marks[i]) {
+          tracer.span(TRACE_PHASES[i - 1], "wasm", marks[i - 1], marks[i]);
+        }
+      }
+    }
+    tracer.span("decode reply", "js", callEnd, end);
+  }
+
+  /**
+   * Publishes `evalStart` for an eval about to enter WASM. Returns the start
+   * time when `evalEnd` has subscribers, else 0.
+   * @private
+   */
+  private publishEvalStart(kind: EvalKind, sha: string, keys: number): number {
+    if (this.warmingUp) {
+      return 0;
+    }
+    if (evalStartChannel.hasSubscribers) {
+      evalStartChannel.publish({ engine: this, kind, sha, keys });
+    }
+    return evalEndChannel.hasSubscribers ? performance.now() : 0;
+  }
+
+  /** @private */
+  private publishEvalEnd(
+    kind: EvalKind,
+    sha: string,
+    keys: number,
+    start: number,
+    reply: ReplyValue,
+  ): void {
+    evalEndChannel.publish({
+      engine: this,
+      kind,
+      sha,
+      keys,
+      durationMs: performance.now() - start,
+      fuelUsed: this.exports._fuel_used?.() ?? 0,
+      replyBytes: this.lastReplyBytes,
+      error: isErrorReply(reply),
+    });
+  }
+
+  /**
+   * Wakes a hibernated engine and asks the governor whether evals are allowed.
+   * Returns the OOM reply if not.
+   * @private
+   */
+  private admit(): ReplyValue | undefined {
+    this.lastActive = performance.now();
+    if (this.governor && !this.governor.admit()) {
+      return {
+        err: Buffer.from("command not allowed when used memory > 'maxmemory'.", "utf8"),
+        code: Buffer.from("OOM", "utf8"),
+      };
+    }
+    this.wake();
+    return undefined;
+  }
+
+  /**
+   * Records `firstEvalMs` when `start` was taken for the first eval, and
+   * reports the heap to the governor.
+   * @private
+   */
+  private finishEval(start: number, reply: ReplyValue): ReplyValue {
+    if (start) {
+      this.timings.firstEvalMs = performance.now() - start;
+    }
+    this.lastActive = performance.now();
+    this.governor?.report(this, this.exports._heap_bytes?.() ?? 0);
+    return reply;
+  }
+
+  /** Writes an encoded props delta onto the `redis` table. @private */
+  private applyRedisProps(blob: Buffer): void {
+    const update = this.requireExport(this.exports._update_redis_props, "_update_redis_props");
+    const ptr = allocAndWrite(this.exports, blob);
+    const reply = this.takeReply(this.callPtrLen(update, ptr, blob.length));
+    this.exports._free_mem(ptr);
+    if (reply && typeof reply === "object" && "err" in reply) {
+      throw new Error(replyErrorMessage(reply, "ERR redis props update failed"));
+    }
+  }
+
+  /** Rebuilds the Lua state after {@link hibernate}. @private */
+  private wake(): void {
+    if (this.hibernated) {
+      this.reset();
+    }
+  }
+
+  /**
+   * Removes scripts no namespace holds any more from the VM cache. Returns the
+   * bytecode bytes dropped.
+   * @private
+   */
+  private evictScripts(shas: string[]): number {
+    const evict = this.exports._script_evict;
+    let dropped = 0;
+    for (const sha of shas) {
+      const bytes = this.installed.get(sha)?.bytes;
+      if (!evict || bytes === undefined) {
+        continue;
+      }
+      const shaPtr = allocAndWrite(this.exports, Buffer.from(sha, "latin1"));
+      evict(shaPtr);
+      this.exports._free_mem(shaPtr);
+      this.installed.delete(sha);
+      dropped += bytes;
+    }
+    this.scriptCacheBytes -= dropped;
+    return dropped;
+  }
+
+  /** Forgets per-state bookkeeping once the Lua state is gone. @private */
+  private clearState(): void {
+    this.installed.clear();
+    this.scriptCacheBytes = 0;
+    this.scripts.clear();
+    this.allocOwners.clear();
+    this.allocBuffers.clear();
+    this.untrackedEvals = 0;
+  }
+
+  /**
+   * Calls a PtrLen-returning export, passing an sret pointer first when the
+   * ABI expects one (the export takes one more parameter than `args`).
+   * @private
+   */
+  private callPtrLen(
+    fn: (...args: number[]) => PtrLenResult,
+    ...args: number[]
+  ): bigint | number[] | { ptr: number; len: number } | number {
+    if (fn.length > args.length) {
+      const retPtr = this.exports._alloc(8);
+      fn(retPtr, ...args);
+      const ptrLen = this.readPtrLen(retPtr);
+      this.exports._free_mem(retPtr);
+      return ptrLen;
+    }
+    const result = fn(...args);
+    if (result === undefined) {
+      throw new Error("Unexpected PtrLen return type");
+    }
+    return result;
+  }
+
+  /** @private */
+  private requireExport<T>(fn: T | undefined, name: string): T {
+    if (!fn) {
+      throw new Error(`WASM module does not export ${name}; rebuild it`);
+    }
+    return fn;
+  }
+
+  /**
+   * Decodes a reply from a non-eval export: no profiling, limits or error
+   * decoration.
+   * @private
+   */
+  private takeReply(
+    result: bigint | number[] | { ptr: number; len: number } | number,
+  ): ReplyValue {
+    const { ptr, len } = this.resultPtrLen(result);
+    if (!ptr || !len) {
+      return null;
+    }
+    const buffer = Buffer.from(this.exports.HEAPU8.subarray(ptr, ptr + len));
+    this.exports._free_mem(ptr);
+    return decodeReply(buffer).value;
   }
 
   /**
@@ -293,30 +1110,85 @@ export class LuaEngine {
   }
 
   /**
-   * Decodes a PtrLen result from WASM into a ReplyValue.
+   * Folds the counts from the last eval into the profile for `sha`. No-op
+   * unless the module exports `_profile_take` (profiling builds).
    * @private
    */
-  private decodeResult(
-    result: bigint | number[] | { ptr: number; len: number } | number,
-    sha: string,
-  ): ReplyValue {
+  private collectProfile(sha: string): void {
+    const take = this.exports._profile_take;
+    if (!take) {
+      return;
+    }
     let ptrLen: { ptr: number; len: number };
+    if (take.length >= 1) {
+      const retPtr = this.exports._alloc(8);
+      take(retPtr);
+      ptrLen = this.readPtrLen(retPtr);
+      this.exports._free_mem(retPtr);
+    } else {
+      const result = take();
+      if (result === undefined || typeof result === "number") {
+        return;
+      }
+      ptrLen = unpackPtrLen(result);
+    }
+    if (!ptrLen.ptr) {
+      return;
+    }
+    const blob = Buffer.from(
+      this.exports.HEAPU8.subarray(ptrLen.ptr, ptrLen.ptr + ptrLen.len),
+    );
+    this.exports._free_mem(ptrLen.ptr);
 
+    const counts = decodeProfile(blob);
+    let profile = this.profiles.get(sha);
+    if (!profile) {
+      profile = { evals: 0, opcodes: {}, cfunctions: {} };
+      this.profiles.set(sha, profile);
+    }
+    profile.evals++;
+    for (const [name, n] of Object.entries(counts.opcodes)) {
+      profile.opcodes[name] = (profile.opcodes[name] ?? 0) + n;
+    }
+    for (const [name, n] of Object.entries(counts.cfunctions)) {
+      profile.cfunctions[name] = (profile.cfunctions[name] ?? 0) + n;
+    }
+  }
+
+  /**
+   * Extracts ptr/len from whichever PtrLen shape the ABI returned. Must run
+   * before any other WASM call, which would clobber getTempRet0.
+   * @private
+   */
+  private resultPtrLen(
+    result: bigint | number[] | { ptr: number; len: number } | number,
+  ): { ptr: number; len: number } {
     if (typeof result === "number") {
       if (this.exports.getTempRet0) {
         const len = this.exports.getTempRet0();
         if (!len) {
           throw new Error("Unexpected PtrLen return type");
         }
-        ptrLen = { ptr: result >>> 0, len };
-      } else {
-        ptrLen = this.readPtrLen(result >>> 0);
+        return { ptr: result >>> 0, len };
       }
-    } else {
-      ptrLen = unpackPtrLen(result);
+      return this.readPtrLen(result >>> 0);
     }
+    return unpackPtrLen(result);
+  }
 
-    const { ptr, len } = ptrLen;
+  /**
+   * Decodes a PtrLen result from WASM into a ReplyValue.
+   * @private
+   */
+  private decodeResult(
+    result: bigint | number[] | { ptr: number; len: number } | number,
+    sha: string,
+  ): ReplyValue {
+    const { ptr, len } = this.resultPtrLen(result);
+    this.lastReplyBytes = len;
+    // After reading ptrLen: these call into WASM, which clobbers getTempRet0.
+    this.leaveAllocOwner(len);
+    this.collectProfile(sha);
 
     if (!ptr || !len) {
       return null;
@@ -395,6 +1267,42 @@ function buildScriptError(
   };
 }
 
+/** Spans between consecutive WASM trace marks (see set_trace in runtime.c). */
+const TRACE_PHASES = ["set KEYS/ARGV", "compile", "execute", "encode reply"];
+
+/** Owner slots in alloc_track.c (ALLOC_TRACK_OWNERS); slot 0 is the engine. */
+const ALLOC_OWNER_SLOTS = 1024;
+
+function emptyObjectCounts(): AllocationStats["objects"] {
+  return Object.fromEntries(
+    ALLOCATION_CLASSES.map((name) => [name, { count: 0, bytes: 0 }]),
+  ) as AllocationStats["objects"];
+}
+
+function isErrorReply(reply: ReplyValue | EncodedReply): boolean {
+  if (reply instanceof EncodedReply) {
+    return reply.isError;
+  }
+  return reply !== null && typeof reply === "object" && "err" in reply;
+}
+
+/** Validates a 40-char hex sha and returns it lowercased, or null. */
+function shaBuffer(sha: string): Buffer | null {
+  if (!/^[0-9a-fA-F]{40}$/.test(sha)) {
+    return null;
+  }
+  return Buffer.from(sha.toLowerCase(), "latin1");
+}
+
+/** Flattens an error reply into `CODE message` for a thrown Error. */
+function replyErrorMessage(reply: ReplyValue, fallback: string): string {
+  if (reply && typeof reply === "object" && "err" in reply) {
+    const { err, code } = reply as { err: Buffer; code?: Buffer };
+    return code ? `${code.toString("utf8")} ${err.toString("utf8")}` : err.toString("utf8");
+  }
+  return fallback;
+}
+
 /**
  * Builds the `host_redis_props` handler. The import takes no input args and
  * returns a PtrLen blob (the encoded redisProps). A `count == 0` blob (length 4)
@@ -515,6 +1423,7 @@ function resolveCompatFlags(
 
 export class LuaWasmModule {
   private consumed = false;
+  private engine: LuaEngine | null = null;
 
   /**
    * @internal
@@ -523,6 +1432,12 @@ export class LuaWasmModule {
     private exports: WasmExports,
     private handlers: MutableHandlers,
     private options: LoadOptions,
+    /**
+     * Time spent per startup phase. Load phases are filled in by `load()`;
+     * `initMs` and `warmupMs` once an engine is created, and `firstEvalMs`
+     * after that engine's first eval.
+     */
+    readonly timings: StartupTimings = emptyTimings(),
   ) {}
 
   /**
@@ -558,9 +1473,7 @@ export class LuaWasmModule {
     this.consumed = true;
 
     this.wireHostCallbacks(host);
-    this.initializeLua();
-
-    return new LuaEngine(this.exports, this.options.limits);
+    return this.startEngine();
   }
 
   /**
@@ -587,9 +1500,7 @@ export class LuaWasmModule {
     this.consumed = true;
 
     this.wireStandaloneCallbacks();
-    this.initializeLua();
-
-    return new LuaEngine(this.exports, this.options.limits);
+    return this.startEngine();
   }
 
   /**
@@ -614,6 +1525,43 @@ export class LuaWasmModule {
     }
   }
 
+  /** Initializes Lua, preloads `scripts`, runs the warm-up, and hands out the engine. */
+  private startEngine(): LuaEngine {
+    let start = performance.now();
+    this.initializeLua();
+    const engine = new LuaEngine(
+      this.exports,
+      this.options.limits,
+      this.timings,
+      this.options.trackAllocations === true && this.exports._set_alloc_tracking !== undefined,
+      this.options.scriptCache,
+      resolveCompatFlags(this.options.profile, this.options.compat),
+    );
+    if (this.options.scripts?.length) {
+      engine.preloadScripts(this.options.scripts);
+    }
+    this.timings.initMs = performance.now() - start;
+
+    const warmup = this.options.warmup;
+    if (warmup) {
+      start = performance.now();
+      const corpus = warmup === true
+        ? WARMUP_CORPUS
+        : warmup.map((script) => ({ script, keys: [], args: [] }));
+      this.withStubHost(() => engine.warmUp(corpus, WARMUP_ROUNDS));
+      delete this.timings.firstEvalMs;
+      this.timings.warmupMs = performance.now() - start;
+    }
+    if (this.options.tracer) {
+      engine.setTracer(this.options.tracer);
+    }
+    if (this.options.governor) {
+      engine.setMemoryGovernor(this.options.governor);
+    }
+    this.engine = engine;
+    return engine;
+  }
+
   private initializeLua(): void {
     if (this.exports._set_limits && this.options.limits) {
       this.exports._set_limits(
@@ -623,12 +1571,42 @@ export class LuaWasmModule {
       );
     }
 
+    if (this.exports._set_load_limits && this.options.limits) {
+      this.exports._set_load_limits(
+        this.options.limits.maxScriptBytes ?? 0,
+        this.options.limits.maxScriptFunctions ?? 0,
+        this.options.limits.maxScriptConstants ?? 0,
+        this.options.limits.maxScriptNesting ?? 0,
+        this.options.limits.maxParseMs ?? 0,
+      );
+    }
+
     if (this.exports._set_compat) {
       this.exports._set_compat(
         resolveCompatFlags(this.options.profile, this.options.compat),
       );
     }
 
+    if (this.exports._set_compat_envs && this.options.profiles?.length) {
+      let mask = 0;
+      for (const profile of this.options.profiles) {
+        mask |= 1 << resolveCompatFlags(profile);
+      }
+      this.exports._set_compat_envs(mask);
+    }
+
+    if (this.exports._set_string_hash && this.options.hashSeed !== undefined) {
+      this.exports._set_string_hash(1, this.options.hashSeed >>> 0);
+    }
+
+    if (this.exports._set_eval_arena && this.options.evalArenaBytes) {
+      this.exports._set_eval_arena(this.options.evalArenaBytes >>> 0);
+    }
+
+    if (this.exports._set_alloc_tracking && this.options.trackAllocations) {
+      this.exports._set_alloc_tracking(1);
+    }
+
     const initResult = this.exports._init();
     if (typeof initResult === "number" && initResult !== 0) {
       throw new Error("Failed to initialize Lua WASM engine");
@@ -638,7 +1616,7 @@ export class LuaWasmModule {
   private wireHostCallbacks(host: RedisHost): void {
     const exports = this.exports;
 
-    const callHandler = (args: Buffer[], isPcall: boolean): ReplyValue => {
+    const callHandler = (args: Buffer[], isPcall: boolean): ReplyValue | EncodedReply => {
       try {
         return isPcall
           ? host.redisPcall.call(host, args)
@@ -666,23 +1644,72 @@ export class LuaWasmModule {
       return returnPtrLen(exports.HEAPU8, abiArgs, ptrLen);
     };
 
-    this.handlers.call = (...args: number[]): bigint | void => {
+    const hostCall = (args: number[], isPcall: boolean): bigint | void => {
+      const tracer = this.engine?.getTracer();
+      const published =
+        DIAGNOSTICS && (hostCallStartChannel.hasSubscribers || hostCallEndChannel.hasSubscribers);
+      const start = tracer || published ? performance.now() : 0;
       const abiArgs = parseAbiArgs(args);
       const decoded = decodeArgs(
         readBytes(exports.HEAPU8, abiArgs.ptr, abiArgs.len),
       );
-      const ptrLen = encodeReplyToPtrLen(exports, callHandler(decoded, false));
+      const event = published
+        ? {
+            engine: this.engine,
+            kind: isPcall ? ("pcall" as const) : ("call" as const),
+            command: decoded[0]?.toString("latin1").toUpperCase() ?? "",
+            argBytes: abiArgs.len,
+          }
+        : null;
+      if (event && hostCallStartChannel.hasSubscribers) {
+        hostCallStartChannel.publish(event);
+      }
+      const reply = callHandler(decoded, isPcall);
+      const ptrLen = encodeReplyToPtrLen(exports, reply);
+      if (event && hostCallEndChannel.hasSubscribers) {
+        hostCallEndChannel.publish({
+          ...event,
+          durationMs: performance.now() - start,
+          replyBytes: ptrLen.len,
+          error: isErrorReply(reply),
+        });
+      }
+      if (tracer) {
+        tracer.span(isPcall ? "redis.pcall" : "redis.call", "host", start, performance.now(), {
+          command: decoded[0]?.toString("latin1").toUpperCase() ?? "",
+          argBytes: abiArgs.len,
+          replyBytes: ptrLen.len,
+        });
+      }
       return returnPtrLen(exports.HEAPU8, abiArgs, ptrLen);
     };
 
-    this.handlers.pcall = (...args: number[]): bigint | void => {
+    this.handlers.call = (...args: number[]): bigint | void => hostCall(args, false);
+
+    this.handlers.pcall = (...args: number[]): bigint | void => hostCall(args, true);
+  }
+
+  /**
+   * Runs `fn` with `redis.call`/`redis.pcall` answering `+OK` and `redis.log`
+   * dropping its message, so warm-up scripts exercise the host bridge without
+   * reaching (or being observed as calls to) the real host.
+   */
+  private withStubHost(fn: () => void): void {
+    const { call, pcall, log } = this.handlers;
+    const exports = this.exports;
+    const ok = (...args: number[]): bigint | void => {
       const abiArgs = parseAbiArgs(args);
-      const decoded = decodeArgs(
-        readBytes(exports.HEAPU8, abiArgs.ptr, abiArgs.len),
-      );
-      const ptrLen = encodeReplyToPtrLen(exports, callHandler(decoded, true));
+      const ptrLen = encodeReplyToPtrLen(exports, { ok: Buffer.from("OK", "utf8") });
       return returnPtrLen(exports.HEAPU8, abiArgs, ptrLen);
     };
+    this.handlers.call = ok;
+    this.handlers.pcall = ok;
+    this.handlers.log = (): void => {};
+    try {
+      fn();
+    } finally {
+      Object.assign(this.handlers, { call, pcall, log });
+    }
   }
 
   private wireStandaloneCallbacks(): void {
@@ -764,12 +1791,29 @@ export async function load(options: LoadOptions = {}): Promise<LuaWasmModule> {
     host_redis_setresp: (version: number) => handlers.setresp(version),
   };
 
-  const { exports } = await loadModule(options, hostImports);
+  const { exports, timings } = await loadModule(options, hostImports);
 
   // Wire the props handler now that we have real exports + the encoded blob.
   handlers.props = makePropsHandler(exports, encodeRedisProps(options.redisProps));
 
-  return new LuaWasmModule(exports, handlers, options);
+  return new LuaWasmModule(exports, handlers, options, timings);
+}
+
+/**
+ * Compiles the WASM binary without instantiating it.
+ *
+ * Pass the result as `wasmModule` to any number of `load()` calls to skip
+ * recompiling; a `WebAssembly.Module` can also be posted to worker threads.
+ *
+ * @example
+ * ```typescript
+ * const wasmModule = await compile();
+ * const a = (await load({ wasmModule })).createStandalone();
+ * const b = (await load({ wasmModule })).createStandalone();
+ * ```
+ */
+export function compile(options: LoadOptions = {}): Promise<WebAssembly.Module> {
+  return compileWasm(options);
 }
 
 /**
@@ -823,9 +1867,86 @@ export class LuaWasmEngine {
     return this.engine.evalWithArgs(script, keys, args);
   }
 
+  compileScript(script: Buffer | Uint8Array | string): Buffer {
+    return this.engine.compileScript(script);
+  }
+
+  installScript(sha: string, bytecode: Buffer | Uint8Array, namespace = ""): void {
+    this.engine.installScript(sha, bytecode, namespace);
+  }
+
+  scriptLoad(script: Buffer | Uint8Array | string, namespace = ""): string {
+    return this.engine.scriptLoad(script, namespace);
+  }
+
+  scriptExists(sha: string, namespace = ""): boolean {
+    return this.engine.scriptExists(sha, namespace);
+  }
+
+  scriptEvict(sha: string, namespace = ""): void {
+    this.engine.scriptEvict(sha, namespace);
+  }
+
+  scriptFlush(namespace?: string): void {
+    this.engine.scriptFlush(namespace);
+  }
+
+  getScriptCacheStats(): Record<string, ScriptCacheStats> {
+    return this.engine.getScriptCacheStats();
+  }
+
+  updateRedisProps(delta: RedisPropsDelta): void {
+    this.engine.updateRedisProps(delta);
+  }
+
+  useProfile(profile?: CompatProfile, compat?: CompatOverrides): void {
+    this.engine.useProfile(profile, compat);
+  }
+
+  preloadScripts(scripts: PreloadScript[]): string[] {
+    return this.engine.preloadScripts(scripts);
+  }
+
+  reset(): void {
+    this.engine.reset();
+  }
+
+  evalSha(
+    sha: string,
+    keys: Array<Buffer | Uint8Array | string> = [],
+    args: Array<Buffer | Uint8Array | string> = [],
+    namespace = "",
+  ): ReplyValue {
+    return this.engine.evalSha(sha, keys, args, namespace);
+  }
+
   getLimits(): EngineLimits | undefined {
     return this.engine.getLimits();
   }
+
+  getStartupTimings(): StartupTimings {
+    return this.engine.getStartupTimings();
+  }
+
+  getProfile(): Map<string, ScriptProfile> {
+    return this.engine.getProfile();
+  }
+
+  clearProfile(): void {
+    this.engine.clearProfile();
+  }
+
+  getAllocationSnapshot(collect = true): AllocationSnapshot {
+    return this.engine.getAllocationSnapshot(collect);
+  }
+
+  setTracer(tracer: Tracer | null): void {
+    this.engine.setTracer(tracer);
+  }
+
+  getTracer(): Tracer | null {
+    return this.engine.getTracer();
+  }
 }
 
 export type {
@@ -838,6 +1959,11 @@ export type {
   LoadOptions,
   RedisProp,
   RedisProps,
+  RedisPropsDelta,
   CompatProfile,
   CompatOverrides,
+  PreloadScript,
+  ScriptProfile,
+  StartupTimings,
+  AllocationSnapshot,
 };
@@ -0,0 +1,274 @@
+/**
+ * @fileoverview Process-wide memory governor shared by engines.
+ *
+ * Per-engine limits bound one script; they do not stop hundreds of engines
+ * from exhausting the process together. Engines registered with a
+ * `MemoryGovernor` (`LoadOptions.governor` or `engine.setMemoryGovernor()`)
+ * report their Lua heap after every eval. Once the total crosses a threshold
+ * the governor applies its policy, cheapest step first:
+ *
+ * 1. `shrinkCacheAt`: evict cached scripts that were not preloaded, from the
+ *    engines with the largest caches (`evalSha` then replies `NOSCRIPT`, as
+ *    after `SCRIPT FLUSH`);
+ * 2. `collectAt`: run the garbage collector, on the largest heaps first;
+ * 3. `hibernateAt`: close the Lua state of engines idle for `idleMs`, largest
+ *    first. The next eval rebuilds the state and re-installs preloaded scripts;
+ * 4. `rejectAt`: refuse evals with an `OOM` error until usage drops.
+ *
+ * The budget covers Lua heaps, which include cached scripts. WASM linear
+ * memory is reported but not governed: it never shrinks, so heap freed by the
+ * steps above is reused by the same engine rather than returned to the process.
+ *
+ * @module governor
+ */
+
+import type { LuaEngine } from "./engine.js";
+import type { EngineMemoryUsage } from "./types.js";
+
+/** Options for {@link MemoryGovernor}. Thresholds are fractions of `limitBytes`. */
+export type MemoryGovernorOptions = {
+  /** Lua heap budget across all registered engines, in bytes. */
+  limitBytes: number;
+  /** Evict non-preloaded cached scripts from this fraction. Default: 0.7. */
+  shrinkCacheAt?: number;
+  /** Collect garbage from this fraction. Default: 0.8. */
+  collectAt?: number;
+  /** Hibernate idle engines from this fraction. Default: 0.9. */
+  hibernateAt?: number;
+  /** Reject evals from this fraction. Default: 1. */
+  rejectAt?: number;
+  /** Time since an engine's last eval before it may be hibernated. Default: 30000. */
+  idleMs?: number;
+  /** Incremental GC step size in KB; 0 runs full collections. Default: 0. */
+  gcStepKb?: number;
+  /** Minimum time between policy passes. Default: 100. */
+  enforceIntervalMs?: number;
+};
+
+/** A policy step, as counted in {@link GovernorUsage.actions}. */
+export type GovernorAction = "shrinkCache" | "collect" | "hibernate" | "reject";
+
+/** Aggregate usage across registered engines. */
+export type GovernorUsage = {
+  limitBytes: number;
+  luaHeapBytes: number;
+  /** Bytecode size of cached scripts (part of `luaHeapBytes`). */
+  scriptCacheBytes: number;
+  /** Linear memory reserved by the engines' WASM instances. */
+  wasmMemoryBytes: number;
+  engines: number;
+  hibernated: number;
+  /** True while evals are refused. */
+  rejecting: boolean;
+  /** Times each step was applied (per engine; `reject` per episode). */
+  actions: Record<GovernorAction, number>;
+};
+
+type Entry = { ref: WeakRef<LuaEngine>; heapBytes: number };
+
+/**
+ * Tracks Lua heap usage across engines and sheds memory at thresholds. One
+ * instance is typically shared by every engine in the process. Engines are
+ * held weakly, so an unreferenced engine drops out on its own.
+ */
+export class MemoryGovernor {
+  readonly limitBytes: number;
+
+  private readonly shrinkCacheAt: number;
+  private readonly collectAt: number;
+  private readonly hibernateAt: number;
+  private readonly rejectAt: number;
+  private readonly idleMs: number;
+  private readonly gcStepKb: number;
+  private readonly enforceIntervalMs: number;
+  private entries = new Set<Entry>();
+  private byEngine = new WeakMap<LuaEngine, Entry>();
+  private heapBytes = 0;
+  private rejecting = false;
+  private lastEnforce = -Infinity;
+  private actions: Record<GovernorAction, number> = {
+    shrinkCache: 0,
+    collect: 0,
+    hibernate: 0,
+    reject: 0,
+  };
+
+  constructor(options: MemoryGovernorOptions) {
+    if (!(options.limitBytes > 0)) {
+      throw new Error("MemoryGovernor: limitBytes must be positive");
+    }
+    this.limitBytes = options.limitBytes;
+    this.shrinkCacheAt = options.shrinkCacheAt ?? 0.7;
+    this.collectAt = options.collectAt ?? 0.8;
+    this.hibernateAt = options.hibernateAt ?? 0.9;
+    this.rejectAt = options.rejectAt ?? 1;
+    this.idleMs = options.idleMs ?? 30_000;
+    this.gcStepKb = options.gcStepKb ?? 0;
+    this.enforceIntervalMs = options.enforceIntervalMs ?? 100;
+  }
+
+  /** Adds an engine. Use `engine.setMemoryGovernor()`, which calls this. */
+  register(engine: LuaEngine): void {
+    if (this.byEngine.has(engine)) {
+      return;
+    }
+    const ref = new WeakRef(engine);
+    const entry = { ref, heapBytes: engine.getMemoryUsage().luaHeapBytes };
+    this.entries.add(entry);
+    this.byEngine.set(engine, entry);
+    this.heapBytes += entry.heapBytes;
+  }
+
+  /** Removes an engine. */
+  unregister(engine: LuaEngine): void {
+    const entry = this.byEngine.get(engine);
+    if (entry) {
+      this.entries.delete(entry);
+      this.byEngine.delete(engine);
+      this.heapBytes -= entry.heapBytes;
+    }
+  }
+
+  /**
+   * Records an engine's heap after an eval, and runs a policy pass if the total
+   * is past the first threshold. Called by the engine.
+   */
+  report(engine: LuaEngine, heapBytes: number): void {
+    const entry = this.byEngine.get(engine);
+    if (!entry) {
+      return;
+    }
+    this.heapBytes += heapBytes - entry.heapBytes;
+    entry.heapBytes = heapBytes;
+    if (this.heapBytes >= this.threshold(this.shrinkCacheAt) && this.due()) {
+      this.enforce();
+    }
+  }
+
+  /** False while evals are refused. Called by engines before each eval. */
+  admit(): boolean {
+    if (this.rejecting && this.due()) {
+      this.enforce();
+    }
+    return !this.rejecting;
+  }
+
+  /** Re-measures every engine and applies the policy now. */
+  enforce(): GovernorUsage {
+    this.lastEnforce = performance.now();
+    const live = this.sample();
+    let heap = live.reduce((sum, e) => sum + e.usage.luaHeapBytes, 0);
+
+    let threshold = this.threshold(this.shrinkCacheAt);
+    if (heap >= threshold) {
+      const byCache = live.slice().sort((a, b) => b.usage.scriptCacheBytes - a.usage.scriptCacheBytes);
+      for (const { engine } of byCache) {
+        if (heap < threshold) {
+          break;
+        }
+        const evicted = engine.shrinkScriptCache();
+        if (evicted > 0) {
+          heap -= evicted;
+          this.actions.shrinkCache++;
+        }
+      }
+    }
+
+    threshold = this.threshold(this.collectAt);
+    if (heap >= threshold) {
+      for (const e of this.largestHeapsFirst(live)) {
+        if (heap < threshold) {
+          break;
+        }
+        if (e.usage.hibernated) {
+          continue;
+        }
+        const after = e.engine.collectGarbage(this.gcStepKb);
+        heap -= e.usage.luaHeapBytes - after;
+        e.usage.luaHeapBytes = after;
+        this.actions.collect++;
+      }
+    }
+
+    threshold = this.threshold(this.hibernateAt);
+    if (heap >= threshold) {
+      for (const e of this.largestHeapsFirst(live)) {
+        if (heap < threshold) {
+          break;
+        }
+        if (e.usage.hibernated || e.usage.idleMs < this.idleMs) {
+          continue;
+        }
+        heap -= e.engine.hibernate();
+        e.usage.luaHeapBytes = 0;
+        this.actions.hibernate++;
+      }
+    }
+
+    const rejecting = heap >= this.threshold(this.rejectAt);
+    if (rejecting && !this.rejecting) {
+      this.actions.reject++;
+    }
+    this.rejecting = rejecting;
+    this.heapBytes = 0;
+    for (const e of live) {
+      this.byEngine.get(e.engine)!.heapBytes = e.usage.luaHeapBytes;
+      this.heapBytes += e.usage.luaHeapBytes;
+    }
+    return this.usage();
+  }
+
+  /** Current usage per registered engine. */
+  engines(): Array<{ engine: LuaEngine; usage: EngineMemoryUsage }> {
+    return this.sample();
+  }
+
+  /** Current aggregate usage, re-measured. */
+  usage(): GovernorUsage {
+    const usage: GovernorUsage = {
+      limitBytes: this.limitBytes,
+      luaHeapBytes: 0,
+      scriptCacheBytes: 0,
+      wasmMemoryBytes: 0,
+      engines: 0,
+      hibernated: 0,
+      rejecting: this.rejecting,
+      actions: { ...this.actions },
+    };
+    for (const { usage: e } of this.sample()) {
+      usage.luaHeapBytes += e.luaHeapBytes;
+      usage.scriptCacheBytes += e.scriptCacheBytes;
+      usage.wasmMemoryBytes += e.wasmMemoryBytes;
+      usage.engines++;
+      usage.hibernated += e.hibernated ? 1 : 0;
+    }
+    return usage;
+  }
+
+  private threshold(fraction: number): number {
+    return this.limitBytes * fraction;
+  }
+
+  private due(): boolean {
+    return performance.now() - this.lastEnforce >= this.enforceIntervalMs;
+  }
+
+  /** Live engines with fresh usage; drops collected ones. */
+  private sample(): Array<{ engine: LuaEngine; usage: EngineMemoryUsage }> {
+    const live: Array<{ engine: LuaEngine; usage: EngineMemoryUsage }> = [];
+    for (const entry of this.entries) {
+      const engine = entry.ref.deref();
+      if (!engine) {
+        this.entries.delete(entry);
+        this.heapBytes -= entry.heapBytes;
+        continue;
+      }
+      live.push({ engine, usage: engine.getMemoryUsage() });
+    }
+    return live;
+  }
+
+  private largestHeapsFirst<T extends { usage: EngineMemoryUsage }>(live: T[]): T[] {
+    return live.slice().sort((a, b) => b.usage.luaHeapBytes - a.usage.luaHeapBytes);
+  }
+}
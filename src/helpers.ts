@@ -3,8 +3,8 @@
  * @module helpers
  */
 
-import { sha1Hex } from "./sha1.js";
-import { encodeReplyValue, packPtrLen } from "./codec.js";
+import { hmacSha1, sha1Hex } from "./sha1.js";
+import { encodeReplyValue, packPtrLen, type EncodedReply } from "./codec.js";
 import type { ReplyValue } from "./types.js";
 import type { WasmExports } from "./loader.js";
 
@@ -41,7 +41,10 @@ export function allocAndWrite(exports: WasmExports, data: Buffer): number {
  * Encodes a ReplyValue and writes it to WASM memory.
  * Returns the pointer and length for passing back to WASM.
  */
-export function encodeReplyToPtrLen(exports: WasmExports, value: ReplyValue): { ptr: number; len: number } {
+export function encodeReplyToPtrLen(
+  exports: WasmExports,
+  value: ReplyValue | EncodedReply,
+): { ptr: number; len: number } {
   const encoded = encodeReplyValue(value);
   const ptr = allocAndWrite(exports, encoded);
   return { ptr, len: encoded.length };
@@ -152,3 +155,59 @@ export function decodeArgs(buf: Buffer): Buffer[] {
 export function computeSha1Hex(data: Buffer): Buffer {
   return Buffer.from(sha1Hex(data), "utf8");
 }
+
+// =============================================================================
+// Bytecode Seal
+// =============================================================================
+
+/** Length of the HMAC-SHA1 tag `sealBytecode` appends. */
+const SEAL_BYTES = 20;
+
+let sealKey: Uint8Array | undefined;
+
+/**
+ * The per-process key bytecode is sealed with, created on first use. Never
+ * leaves the process; the compile worker receives it in its `workerData`.
+ * @internal
+ */
+export function bytecodeSealKey(): Uint8Array {
+  sealKey ??= globalThis.crypto.getRandomValues(new Uint8Array(32));
+  return sealKey;
+}
+
+/** Adopts the key of the thread that started this one. @internal */
+export function setBytecodeSealKey(key: Uint8Array): void {
+  sealKey = key;
+}
+
+function sealTag(sha: Buffer, bytecode: Uint8Array): Uint8Array {
+  const message = new Uint8Array(sha.length + bytecode.length);
+  message.set(sha);
+  message.set(bytecode, sha.length);
+  return hmacSha1(bytecodeSealKey(), message);
+}
+
+/**
+ * Appends an HMAC over `sha` (40 hex chars) and the bytecode, so only bytecode
+ * this process compiled from the source with that sha can be installed.
+ */
+export function sealBytecode(sha: Buffer, bytecode: Buffer): Buffer {
+  return Buffer.concat([bytecode, sealTag(sha, bytecode)]);
+}
+
+/**
+ * Returns the bytecode of a `sealBytecode` blob, or null if the tag does not
+ * match `sha` under this process' key.
+ */
+export function unsealBytecode(sha: Buffer, sealed: Uint8Array): Buffer | null {
+  if (sealed.length <= SEAL_BYTES) {
+    return null;
+  }
+  const bytecode = sealed.subarray(0, sealed.length - SEAL_BYTES);
+  const tag = sealTag(sha, bytecode);
+  let diff = 0;
+  for (let i = 0; i < SEAL_BYTES; i++) {
+    diff |= tag[i] ^ sealed[bytecode.length + i];
+  }
+  return diff === 0 ? Buffer.from(bytecode) : null;
+}
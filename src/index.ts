@@ -1,4 +1,29 @@
-export { load, LuaWasmModule, LuaEngine, LuaWasmEngine } from "./engine.js";
+export { load, compile, LuaWasmModule, LuaEngine, LuaWasmEngine } from "./engine.js";
+export { createRing, RingProducer, RingConsumer } from "./ring.js";
+export type { RingOptions, RingHandler } from "./ring.js";
+export { WorkerPool } from "./pool.js";
+export type { WorkerPoolOptions, PoolScaling, PoolMetrics, PoolDecision } from "./pool.js";
+export { ScriptCompiler } from "./compiler.js";
+export type { ScriptCompilerOptions, ScriptStatus, ScriptTarget } from "./compiler.js";
+export { prepareSnapshot, snapshotEngine } from "./snapshot.js";
+export { Tracer } from "./trace.js";
+export type { TraceEvent, TracerOptions } from "./trace.js";
+export { ReplyBuilder } from "./reply.js";
+export { EncodedReply } from "./codec.js";
+export { MemoryGovernor } from "./governor.js";
+export type { MemoryGovernorOptions, GovernorAction, GovernorUsage } from "./governor.js";
+export { DIAGNOSTICS_CHANNELS } from "./diagnostics.js";
+export type {
+  EvalKind,
+  EvalStartEvent,
+  EvalEndEvent,
+  HostCallStartEvent,
+  HostCallEndEvent,
+  CompileEvent,
+  ResetEvent,
+  RecycleEvent,
+} from "./diagnostics.js";
+export type { SnapshotOptions } from "./snapshot.js";
 export type {
   EngineOptions,
   EngineLimits,
@@ -11,8 +36,21 @@ export type {
   StandaloneOptions,
   RedisProp,
   RedisProps,
+  RedisPropsDelta,
   CompatProfile,
-  CompatOverrides
+  CompatOverrides,
+  PreloadScript,
+  ScriptProfile,
+  AllocationClass,
+  AllocationCount,
+  AllocationStats,
+  AllocationSnapshot,
+  EngineMemoryUsage,
+  ScriptCacheOptions,
+  ScriptCacheQuota,
+  ScriptCacheStats,
+  StartupTimings,
+  WasmModuleCache
 } from "./types.js";
 import { encodeReplyValue, decodeReply, encodeArgArray } from "./codec.js";
 import type { ReplyValue as ReplyValueType } from "./types.js";
@@ -13,6 +13,11 @@
  * @module loader-core
  */
 
+import type { StartupTimings } from "./types.js";
+
+/** The shapes a PtrLen return takes across Emscripten ABI conventions. */
+export type PtrLenResult = bigint | number[] | { ptr: number; len: number } | number | void;
+
 /**
  * Type definition for the Emscripten module exports — the functions and memory
  * exported by the WASM module (names prefixed with `_` per Emscripten convention).
@@ -71,6 +76,24 @@ export type WasmExports = {
    */
   _set_limits?: (maxFuel: number, maxReplyBytes: number, maxArgBytes: number) => void;
 
+  /** Applies a redisProps delta blob to the live `redis` table. */
+  _update_redis_props?: (ptr: number, len: number, retPtr?: number) => PtrLenResult;
+
+  /**
+   * Configure compile-time limits, applied whenever a script is loaded.
+   * Each is 0 = unlimited.
+   */
+  _set_load_limits?: (
+    maxScriptBytes: number,
+    maxFunctions: number,
+    maxConstants: number,
+    maxNesting: number,
+    maxParseMs: number,
+  ) => void;
+
+  /** Fuel the last eval charged against maxFuel. */
+  _fuel_used?: () => number;
+
   /**
    * Select the compatibility profile (which Redis/Valkey version's Lua sandbox
    * behavior to emulate). Bitmask: 0x1 keep `print`, 0x2 expose `os`, 0x4
@@ -78,6 +101,95 @@ export type WasmExports = {
    */
   _set_compat?: (flags: number) => void;
 
+  /**
+   * Compat flag sets to prebuild a global environment for at _init/_reset, as a
+   * mask with bit `1 << flags` set per flag set.
+   */
+  _set_compat_envs?: (mask: number) => void;
+
+  /**
+   * Run later evals under the global environment for the compat `flags`
+   * (bitmask as for _set_compat). Kept across _reset.
+   */
+  _use_compat?: (flags: number) => void;
+
+  /**
+   * Select the string hash for states built by the next _init/_reset: 0 keeps
+   * Lua's sampled hash, non-zero hashes every byte under `seed`.
+   */
+  _set_string_hash?: (seeded: number, seed: number) => void;
+
+  /** Experimental per-eval region size for the next _init/_reset; 0 disables it. */
+  _set_eval_arena?: (bytes: number) => void;
+
+  /**
+   * Compile a script to bytecode. Replies with a bulk string (the bytecode) or
+   * a script error.
+   * @param retPtr - Optional sret pointer
+   */
+  _script_compile?: (ptr: number, len: number, retPtr?: number) => PtrLenResult;
+
+  /**
+   * Load bytecode from _script_compile and cache it under a 40-char hex sha.
+   * Replies with status OK or an error.
+   */
+  _script_install?: (shaPtr: number, bcPtr: number, bcLen: number, retPtr?: number) =>
+    PtrLenResult;
+
+  /** Run the cached script for a 40-char hex sha with KEYS/ARGV (NOSCRIPT if none). */
+  _eval_sha?: (
+    shaPtr: number,
+    argsPtr: number,
+    argsLen: number,
+    keysCount: number,
+    retPtr?: number
+  ) => PtrLenResult;
+
+  /** Drop every cached script. */
+  _script_flush?: () => void;
+
+  /** Drop the cached script for a 40-char hex sha, if any. */
+  _script_evict?: (shaPtr: number) => void;
+
+  /** Bytes the Lua allocator holds for the state (0 when hibernated). */
+  _heap_bytes?: () => number;
+
+  /** Collect `kb` KB incrementally (0: full collection); returns _heap_bytes. */
+  _gc_step?: (kb: number) => number;
+
+  /** Close the Lua state, freeing its heap, until the next _init. */
+  _hibernate?: () => void;
+
+  /** Allocation tracking for the next _init/_reset (see alloc_track.c). */
+  _set_alloc_tracking?: (enabled: number) => void;
+
+  /** Attribute new Lua heap blocks to an owner slot (0: the engine). */
+  _set_alloc_owner?: (owner: number) => void;
+
+  /**
+   * Per-owner allocation counters and live objects by type, optionally after a
+   * full collection. Empty unless tracking is enabled.
+   */
+  _alloc_snapshot?: (collect: number, retPtr?: number) => PtrLenResult;
+
+  /** Take per-eval phase timestamps (see _trace_marks). */
+  _set_trace?: (enabled: number) => void;
+
+  /** Address of the last eval's five f64 phase timestamps. */
+  _trace_marks?: () => number;
+
+  /**
+   * Opcode / C-function call counts since the previous call, then zeroed.
+   * Exported only by profiling builds (`npm run build:wasm:profile`).
+   * @param retPtr - Optional sret pointer
+   */
+  _profile_take?: (retPtr?: number) =>
+    | bigint
+    | number[]
+    | { ptr: number; len: number }
+    | number
+    | void;
+
   /**
    * Allocate memory in WASM linear memory.
    * @param size - Number of bytes to allocate
@@ -127,20 +239,38 @@ export function defaultModulePath(): string {
   return new URL("./redis_lua.mjs", import.meta.url).href;
 }
 
+/** A zeroed timing breakdown the loader and module fill in as phases finish. */
+export function emptyTimings(): StartupTimings {
+  return { glueMs: 0, wasmReadMs: 0, compileMs: 0, instantiateMs: 0, initMs: 0, warmupMs: 0 };
+}
+
 /**
- * Instantiate an already-loaded Emscripten factory + WASM bytes, injecting the
- * host callbacks into the module's imports. Shared by both platform loaders.
+ * Instantiate an already-loaded Emscripten factory + WASM bytes (or an already
+ * compiled module), injecting the host callbacks into the module's imports.
+ * Shared by both platform loaders. Bytes are compiled first so compile and
+ * instantiate time land in separate `timings` fields; a loader that produced
+ * the module itself records its own `compileMs`.
  */
 export async function instantiate(
   moduleFactory: EmscriptenModuleFactory,
-  wasmBinary: Uint8Array,
-  hostImports: Record<string, HostImport>
+  wasm: Uint8Array | WebAssembly.Module,
+  hostImports: Record<string, HostImport>,
+  timings: StartupTimings = emptyTimings()
 ): Promise<{ module: WasmExports; exports: WasmExports }> {
+  let start = performance.now();
+  let compiled: WebAssembly.Module;
+  if (wasm instanceof WebAssembly.Module) {
+    compiled = wasm;
+  } else {
+    compiled = await WebAssembly.compile(wasm);
+    timings.compileMs = performance.now() - start;
+  }
+
+  start = performance.now();
   const module = await moduleFactory({
-    // wasmBinary + the custom instantiateWasm below fully drive instantiation,
-    // so locateFile is never consulted for the .wasm — pass other files through.
+    // The custom instantiateWasm below fully drives instantiation, so
+    // locateFile is never consulted for the .wasm — pass other files through.
     locateFile: (file) => file,
-    wasmBinary,
 
     // Custom instantiation to inject host imports.
     instantiateWasm(imports, successCallback) {
@@ -150,15 +280,15 @@ export async function instantiate(
       // Also add to WASI namespace for compatibility.
       imports.wasi_snapshot_preview1 = imports.env;
 
-      WebAssembly.instantiate(wasmBinary, imports).then((result) => {
-        const instantiated = result as unknown as WebAssembly.WebAssemblyInstantiatedSource;
-        successCallback(instantiated.instance, instantiated.module);
+      WebAssembly.instantiate(compiled, imports).then((instance) => {
+        successCallback(instance, compiled);
       });
 
       // Return empty object to signal async instantiation.
       return {};
     }
   });
+  timings.instantiateMs = performance.now() - start;
 
   return { module, exports: module };
 }
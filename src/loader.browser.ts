@@ -11,8 +11,9 @@
  * @module loader.browser
  */
 
-import type { LoadOptions } from "./types.js";
+import type { LoadOptions, StartupTimings } from "./types.js";
 import {
+  emptyTimings,
   instantiate,
   defaultModulePath,
   defaultWasmPath,
@@ -20,6 +21,7 @@ import {
   type HostImport,
   type WasmExports
 } from "./loader-core.js";
+import { canStoreModules, compileCached, resolveWasmCache } from "./wasm-cache.js";
 
 export { defaultModulePath, defaultWasmPath };
 export type { HostImport, WasmExports };
@@ -41,12 +43,8 @@ async function loadGlueFactory(
   return (imported.default ?? imported) as EmscriptenModuleFactory;
 }
 
-/** Fetch the WASM binary bytes (or use `options.wasmBytes` if provided). */
-async function loadWasmBinary(options: LoadOptions): Promise<Uint8Array> {
-  if (options.wasmBytes) {
-    return options.wasmBytes;
-  }
-  // Explicit URL (e.g. jsdelivr) wins; otherwise the co-located bundled asset.
+/** Fetch the WASM binary (explicit URL wins; otherwise the co-located asset). */
+async function fetchWasm(options: LoadOptions): Promise<Response> {
   const wasmUrl = options.wasmPath ?? new URL("./redis_lua.wasm", import.meta.url);
   const response = await fetch(wasmUrl);
   if (!response.ok) {
@@ -54,7 +52,53 @@ async function loadWasmBinary(options: LoadOptions): Promise<Uint8Array> {
       `Failed to fetch redis_lua.wasm: ${response.status} ${response.statusText}`
     );
   }
-  return new Uint8Array(await response.arrayBuffer());
+  return response;
+}
+
+/** compileStreaming only accepts responses served as `application/wasm`. */
+function canCompileStreaming(response: Response): boolean {
+  const type = response.headers.get("content-type") ?? "";
+  return (
+    typeof WebAssembly.compileStreaming === "function" &&
+    type.split(";")[0].trim().toLowerCase() === "application/wasm"
+  );
+}
+
+/**
+ * Produce the WASM to instantiate: `options.wasmModule` as is; a cached or
+ * freshly cached module when `wasmCache` is set and can store modules; a
+ * module compiled while the response downloads when it is served as
+ * `application/wasm`; otherwise the bytes, compiled by the core.
+ */
+async function loadWasm(
+  options: LoadOptions,
+  timings: StartupTimings
+): Promise<Uint8Array | WebAssembly.Module> {
+  if (options.wasmModule) {
+    return options.wasmModule;
+  }
+  const cache = resolveWasmCache(options.wasmCache);
+  if (options.wasmBytes) {
+    return cache ? compileCached(options.wasmBytes, cache, timings) : options.wasmBytes;
+  }
+
+  let start = performance.now();
+  // Probe the cache while the response is on its way: a store that refuses
+  // modules would otherwise cost streaming compilation on every load.
+  const [response, cacheable] = await Promise.all([
+    fetchWasm(options),
+    cache ? canStoreModules(cache) : false,
+  ]);
+  if (!cacheable && canCompileStreaming(response)) {
+    timings.wasmReadMs = performance.now() - start;
+    start = performance.now();
+    const module = await WebAssembly.compileStreaming(response);
+    timings.compileMs = performance.now() - start;
+    return module;
+  }
+  const bytes = new Uint8Array(await response.arrayBuffer());
+  timings.wasmReadMs = performance.now() - start;
+  return cache && cacheable ? compileCached(bytes, cache, timings) : bytes;
 }
 
 /**
@@ -62,13 +106,27 @@ async function loadWasmBinary(options: LoadOptions): Promise<Uint8Array> {
  *
  * @param options - Engine or standalone options with optional custom paths
  * @param hostImports - Map of host callback functions to inject
- * @returns Object containing the instantiated module and exports
+ * @returns The instantiated module and exports, and the time spent per phase
  */
 export async function loadModule(
   options: LoadOptions,
   hostImports: Record<string, HostImport>
-): Promise<{ module: WasmExports; exports: WasmExports }> {
-  const moduleFactory = await loadGlueFactory(options);
-  const wasmBinary = await loadWasmBinary(options);
-  return instantiate(moduleFactory, wasmBinary, hostImports);
+): Promise<{ module: WasmExports; exports: WasmExports; timings: StartupTimings }> {
+  const timings = emptyTimings();
+  const start = performance.now();
+  const moduleFactory = options.moduleFactory ?? (await loadGlueFactory(options));
+  timings.glueMs = performance.now() - start;
+  const wasm = await loadWasm(options, timings);
+  const loaded = await instantiate(moduleFactory, wasm, hostImports, timings);
+  return { ...loaded, timings };
+}
+
+/**
+ * Compiles the WASM binary once (streaming and `wasmCache` apply as in
+ * `loadModule`) so several engines can be instantiated from it via
+ * `wasmModule`.
+ */
+export async function compileWasm(options: LoadOptions = {}): Promise<WebAssembly.Module> {
+  const wasm = await loadWasm(options, emptyTimings());
+  return wasm instanceof WebAssembly.Module ? wasm : WebAssembly.compile(wasm);
 }
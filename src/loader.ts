@@ -10,8 +10,9 @@
  * @module loader
  */
 
-import type { LoadOptions } from "./types.js";
+import type { LoadOptions, StartupTimings } from "./types.js";
 import {
+  emptyTimings,
   instantiate,
   defaultModulePath,
   defaultWasmPath,
@@ -19,6 +20,7 @@ import {
   type HostImport,
   type WasmExports
 } from "./loader-core.js";
+import { compileCached, resolveWasmCache } from "./wasm-cache.js";
 
 export { defaultModulePath, defaultWasmPath };
 export type { HostImport, WasmExports };
@@ -67,18 +69,50 @@ async function loadWasmBinary(options: LoadOptions): Promise<Uint8Array> {
   return new Uint8Array(await readFile(wasmPath));
 }
 
+/**
+ * Produce the WASM to instantiate: `options.wasmModule` as is, a cached or
+ * freshly cached module when `wasmCache` is set, otherwise the bytes.
+ */
+async function loadWasm(
+  options: LoadOptions,
+  timings: StartupTimings
+): Promise<Uint8Array | WebAssembly.Module> {
+  if (options.wasmModule) {
+    return options.wasmModule;
+  }
+  const start = performance.now();
+  const bytes = await loadWasmBinary(options);
+  timings.wasmReadMs = performance.now() - start;
+  const cache = resolveWasmCache(options.wasmCache);
+  return cache ? compileCached(bytes, cache, timings) : bytes;
+}
+
 /**
  * Loads and instantiates the Emscripten WASM module with host imports (Node).
  *
  * @param options - Engine or standalone options with optional custom paths
  * @param hostImports - Map of host callback functions to inject
- * @returns Object containing the instantiated module and exports
+ * @returns The instantiated module and exports, and the time spent per phase
  */
 export async function loadModule(
   options: LoadOptions,
   hostImports: Record<string, HostImport>
-): Promise<{ module: WasmExports; exports: WasmExports }> {
-  const moduleFactory = await loadGlueFactory(options);
-  const wasmBinary = await loadWasmBinary(options);
-  return instantiate(moduleFactory, wasmBinary, hostImports);
+): Promise<{ module: WasmExports; exports: WasmExports; timings: StartupTimings }> {
+  const timings = emptyTimings();
+  const start = performance.now();
+  const moduleFactory = options.moduleFactory ?? (await loadGlueFactory(options));
+  timings.glueMs = performance.now() - start;
+  const wasm = await loadWasm(options, timings);
+  const loaded = await instantiate(moduleFactory, wasm, hostImports, timings);
+  return { ...loaded, timings };
+}
+
+/**
+ * Compiles the WASM binary once (from `options.wasmBytes` or the resolved
+ * path; `wasmCache` applies) so several engines can be instantiated from it
+ * via `wasmModule`.
+ */
+export async function compileWasm(options: LoadOptions = {}): Promise<WebAssembly.Module> {
+  const wasm = await loadWasm(options, emptyTimings());
+  return wasm instanceof WebAssembly.Module ? wasm : WebAssembly.compile(wasm);
 }
@@ -0,0 +1,84 @@
+/**
+ * @fileoverview Worker-thread entry point for {@link WorkerPool}.
+ *
+ * Instantiates the pool's shared compiled module, runs the warm-up scripts,
+ * reports `ready`, then serves the submission ring until the pool sets this
+ * worker's retire flag, closes the ring, or the engine traps (reported as
+ * `trapped`). Eval time, eval count, the time of the last eval and the ticket
+ * being served go to the shared stats array the pool samples.
+ *
+ * @module pool-worker
+ */
+
+import { parentPort, workerData } from "node:worker_threads";
+import { load } from "./engine.js";
+import {
+  STAT_BUSY_US,
+  STAT_EVALS,
+  STAT_LAST_ACTIVE_MS,
+  STAT_RETIRE,
+  STAT_TICKET,
+  STAT_WORDS,
+  type PoolWorkerData,
+} from "./pool.js";
+import { RingConsumer, type RingHandler } from "./ring.js";
+import type { RedisHost } from "./types.js";
+
+/** Imports `hostModule` and calls its default export to build the host. */
+async function importHost(specifier: string): Promise<RedisHost> {
+  const imported = await import(specifier);
+  return (await imported.default()) as RedisHost;
+}
+
+async function run(data: PoolWorkerData): Promise<void> {
+  const stats = new BigInt64Array(data.stats);
+  const base = data.index * STAT_WORDS;
+
+  const module = await load({ ...data.load, wasmModule: data.wasmModule });
+  const engine = data.hostModule
+    ? module.create(await importHost(data.hostModule))
+    : module.createStandalone();
+  for (const script of data.warmup) {
+    engine.eval(script);
+  }
+  parentPort!.postMessage({ type: "ready" });
+
+  // A trap (WebAssembly.RuntimeError) leaves the engine unusable: reply with the
+  // error, then stop serving.
+  let trapped = false;
+  const handler: RingHandler = (script, keys, args) => {
+    const start = performance.now();
+    try {
+      return engine.evalWithArgs(script, keys, args);
+    } catch (err) {
+      trapped ||= err instanceof WebAssembly.RuntimeError;
+      throw err;
+    } finally {
+      const us = BigInt(Math.round((performance.now() - start) * 1000));
+      Atomics.add(stats, base + STAT_BUSY_US, us);
+      Atomics.add(stats, base + STAT_EVALS, 1n);
+      Atomics.store(stats, base + STAT_LAST_ACTIVE_MS, BigInt(Date.now()));
+    }
+  };
+  const onClaim = (ticket: number) => {
+    Atomics.store(stats, base + STAT_TICKET, BigInt(ticket >>> 0) + 1n);
+  };
+  const consumer = new RingConsumer(data.ring);
+  while (!trapped && Atomics.load(stats, base + STAT_RETIRE) === 0n) {
+    const served = consumer.serveOnce(handler, data.pollMs, onClaim);
+    Atomics.store(stats, base + STAT_TICKET, 0n);
+    if (!served && consumer.closed) {
+      break;
+    }
+  }
+  if (trapped) {
+    parentPort!.postMessage({ type: "trapped" });
+  }
+}
+
+run(workerData as PoolWorkerData).catch((err: unknown) => {
+  parentPort!.postMessage({
+    type: "error",
+    message: err instanceof Error ? err.message : String(err),
+  });
+});
@@ -0,0 +1,20 @@
+/**
+ * @fileoverview Browser stand-in for `pool.ts`.
+ *
+ * The worker pool is built on `node:worker_threads`; rollup aliases this file
+ * in for the browser target so no Node builtin enters the browser graph. The
+ * submission ring (`createRing`, `RingProducer`, `RingConsumer`) works with Web
+ * Workers and remains available.
+ *
+ * @module pool.browser
+ */
+
+import type { WorkerPoolOptions } from "./pool.js";
+
+export class WorkerPool {
+  private constructor() {}
+
+  static async create(_options: WorkerPoolOptions = {}): Promise<WorkerPool> {
+    throw new Error("WorkerPool requires Node.js worker_threads");
+  }
+}
@@ -0,0 +1,509 @@
+/**
+ * @fileoverview Elastic pool of worker-thread engines (Node.js).
+ *
+ * Each worker hosts one engine and takes requests off a shared submission ring
+ * (see `ring.ts`), so callers never `postMessage` per eval. The pool grows and
+ * shrinks between `minWorkers` and `maxWorkers` from three measurements taken
+ * every `intervalMs`:
+ *
+ * - **utilization**: eval time reported by the workers over wall time, per
+ *   serving worker.
+ * - **queue wait**: mean round-trip latency minus mean eval time.
+ * - **p99 latency**: round trip seen by callers.
+ *
+ * New workers instantiate the pool's already-compiled `WebAssembly.Module` and
+ * run the `warmup` scripts before they start consuming, so a scale-up never
+ * serves a cold engine. A worker picked for retirement finishes the request it
+ * holds, stops taking new ones and exits. A worker whose engine traps retires
+ * itself the same way. A worker that dies mid-request has that request
+ * completed with an error reply, which frees its ring slot; the next scaling
+ * tick replaces the worker if the pool is short.
+ *
+ * The browser build aliases this module to `pool.browser.ts`.
+ *
+ * @module pool
+ */
+
+import type { Worker } from "node:worker_threads";
+import { DIAGNOSTICS, recycleChannel, type RecycleEvent } from "./diagnostics.js";
+import { compileWasm } from "./loader.js";
+import { createRing, RingProducer, type RingOptions } from "./ring.js";
+import type { LoadOptions, ReplyValue } from "./types.js";
+
+/** Per-worker words in the shared stats array (BigInt64). @internal */
+export const STAT_BUSY_US = 0;
+/** @internal */
+export const STAT_EVALS = 1;
+/** @internal */
+export const STAT_LAST_ACTIVE_MS = 2;
+/** @internal */
+export const STAT_RETIRE = 3;
+/**
+ * Ring ticket the worker is taking or serving, plus one (unsigned); 0 when idle.
+ * @internal
+ */
+export const STAT_TICKET = 4;
+/** @internal */
+export const STAT_WORDS = 5;
+
+/** How long an idle worker blocks on the ring before rechecking its retire flag. */
+const IDLE_POLL_MS = 100;
+const MAX_DECISIONS = 32;
+const MAX_LATENCY_SAMPLES = 4096;
+
+/** Data a pool worker starts with. @internal */
+export type PoolWorkerData = {
+  index: number;
+  ring: SharedArrayBuffer;
+  stats: SharedArrayBuffer;
+  wasmModule: WebAssembly.Module;
+  load: Omit<LoadOptions, "wasmModule">;
+  hostModule?: string;
+  warmup: string[];
+  pollMs: number;
+};
+
+/** Thresholds driving {@link WorkerPool} scaling. */
+export type PoolScaling = {
+  /** How often metrics are sampled and a scaling decision is made. Default: 1000. */
+  intervalMs?: number;
+
+  /** Add a worker when utilization reaches this fraction. Default: 0.75. */
+  scaleUpUtilization?: number;
+
+  /** Consider retiring a worker when utilization is at or below this. Default: 0.25. */
+  scaleDownUtilization?: number;
+
+  /** Add a worker when mean queue wait exceeds this. Default: 5. */
+  maxQueueWaitMs?: number;
+
+  /** Add a worker when p99 latency exceeds this while requests are queued. Default: off. */
+  p99TargetMs?: number;
+
+  /** Only retire a worker that has not run an eval for this long. Default: 30000. */
+  idleTimeoutMs?: number;
+};
+
+/** Options for {@link WorkerPool.create}. */
+export type WorkerPoolOptions = {
+  /** Workers kept even when idle. Default: 1. */
+  minWorkers?: number;
+
+  /** Upper bound on workers. Default: 4. */
+  maxWorkers?: number;
+
+  /**
+   * Options each worker passes to `load()`. Must be structured-cloneable. The
+   * WASM is compiled once by the pool and shared.
+   */
+  load?: LoadOptions;
+
+  /**
+   * Module URL or path imported by each worker; its default export is called
+   * (and awaited) to produce the worker's `RedisHost`. Standalone engines if
+   * omitted.
+   */
+  hostModule?: string;
+
+  /** Scripts each new worker evaluates before it starts serving. Default: `["return 1"]`. */
+  warmup?: string[];
+
+  /** Submission ring sizing (see {@link RingOptions}). */
+  ring?: RingOptions;
+
+  /** Scaling thresholds. */
+  scaling?: PoolScaling;
+
+  /** Worker entry point. Default: the co-located `pool-worker` module. */
+  workerUrl?: string | URL;
+};
+
+/** One scaling decision, as recorded in {@link PoolMetrics.decisions}. */
+export type PoolDecision = {
+  /** `Date.now()` when the decision was made. */
+  at: number;
+  action: "up" | "down";
+  /** The measurement that triggered it, e.g. `"utilization 0.91 >= 0.75"`. */
+  reason: string;
+  /** Serving workers after the decision took effect (including one warming up). */
+  workers: number;
+};
+
+/** Snapshot returned by {@link WorkerPool.metrics}. Rates cover the last interval. */
+export type PoolMetrics = {
+  /** Workers serving requests. */
+  workers: number;
+  /** Workers loading their engine; they serve once warm. */
+  warming: number;
+  /** Eval time over wall time per serving worker, 0..1. */
+  utilization: number;
+  /** Requests waiting in the ring when sampled. */
+  queueDepth: number;
+  /** Mean round trip minus mean eval time. */
+  queueWaitMs: number;
+  /** 99th percentile round trip. */
+  p99Ms: number;
+  /** Evals completed since the pool was created. */
+  evals: number;
+  scaleUps: number;
+  scaleDowns: number;
+  /** Most recent scaling decisions, oldest first (at most 32). */
+  decisions: PoolDecision[];
+};
+
+type PoolWorker = {
+  index: number;
+  thread: Worker;
+  state: "warming" | "serving" | "retiring";
+  lastBusyUs: bigint;
+  lastEvals: bigint;
+  exited: Promise<void>;
+};
+
+/**
+ * Resolves a co-located worker entry: the bundled `.mjs` in `dist/`, else the
+ * dev `.ts`. @internal
+ */
+export async function workerEntryUrl(name: string): Promise<URL> {
+  const fs = await import("node:fs");
+  const { fileURLToPath } = await import("node:url");
+  const built = new URL(`./${name}.mjs`, import.meta.url);
+  return fs.existsSync(fileURLToPath(built)) ? built : new URL(`./${name}.ts`, import.meta.url);
+}
+
+/** Turns a filesystem path into a `file://` URL workers can `import()`; URLs pass through. */
+async function moduleUrl(specifier: string): Promise<string> {
+  if (/^[a-z]+:\/\//i.test(specifier)) {
+    return specifier;
+  }
+  const { pathToFileURL } = await import("node:url");
+  return pathToFileURL(specifier).href;
+}
+
+function percentile(samples: number[], p: number): number {
+  if (samples.length === 0) {
+    return 0;
+  }
+  const sorted = [...samples].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+/**
+ * Elastic pool of worker-thread engines fed through a shared submission ring.
+ *
+ * ```typescript
+ * const pool = await WorkerPool.create({ minWorkers: 2, maxWorkers: 8 });
+ * const reply = await pool.evalWithArgs("return KEYS[1]", ["key:1"], []);
+ * console.log(pool.metrics());
+ * await pool.close();
+ * ```
+ */
+export class WorkerPool {
+  private readonly workers = new Set<PoolWorker>();
+  private readonly stats: BigInt64Array;
+  private readonly producer: RingProducer;
+  private readonly timer: ReturnType<typeof setInterval>;
+  private latencies: number[] = [];
+  private latencyCount = 0;
+  private lastTick = Date.now();
+  private totalEvals = 0;
+  private closed = false;
+  private current: Omit<PoolMetrics, "workers" | "warming" | "evals" | "decisions"> = {
+    utilization: 0,
+    queueDepth: 0,
+    queueWaitMs: 0,
+    p99Ms: 0,
+    scaleUps: 0,
+    scaleDowns: 0,
+  };
+  private readonly decisions: PoolDecision[] = [];
+
+  private constructor(
+    private readonly WorkerCtor: typeof Worker,
+    private readonly workerUrl: string | URL,
+    private readonly base: Omit<PoolWorkerData, "index">,
+    private readonly minWorkers: number,
+    private readonly maxWorkers: number,
+    private readonly scaling: Required<Omit<PoolScaling, "p99TargetMs">> & { p99TargetMs?: number },
+  ) {
+    this.stats = new BigInt64Array(base.stats);
+    this.producer = new RingProducer(base.ring);
+    this.timer = setInterval(() => this.tick(), scaling.intervalMs);
+    this.timer.unref?.();
+  }
+
+  /** Compiles the WASM once, starts `minWorkers` warm workers, and resolves when they serve. */
+  static async create(options: WorkerPoolOptions = {}): Promise<WorkerPool> {
+    const minWorkers = options.minWorkers ?? 1;
+    const maxWorkers = options.maxWorkers ?? Math.max(4, minWorkers);
+    if (!Number.isInteger(minWorkers) || minWorkers < 0 || !Number.isInteger(maxWorkers) ||
+        maxWorkers < Math.max(1, minWorkers)) {
+      throw new RangeError("WorkerPool needs 0 <= minWorkers <= maxWorkers and maxWorkers >= 1");
+    }
+    const { Worker } = await import("node:worker_threads");
+    const { wasmModule, ...load } = options.load ?? {};
+    const pool = new WorkerPool(
+      Worker,
+      options.workerUrl ?? (await workerEntryUrl("pool-worker")),
+      {
+        ring: createRing(options.ring),
+        stats: new SharedArrayBuffer(maxWorkers * STAT_WORDS * 8),
+        wasmModule: wasmModule ?? (await compileWasm(load)),
+        load,
+        hostModule: options.hostModule && (await moduleUrl(options.hostModule)),
+        warmup: options.warmup ?? ["return 1"],
+        pollMs: IDLE_POLL_MS,
+      },
+      minWorkers,
+      maxWorkers,
+      {
+        intervalMs: options.scaling?.intervalMs ?? 1000,
+        scaleUpUtilization: options.scaling?.scaleUpUtilization ?? 0.75,
+        scaleDownUtilization: options.scaling?.scaleDownUtilization ?? 0.25,
+        maxQueueWaitMs: options.scaling?.maxQueueWaitMs ?? 5,
+        p99TargetMs: options.scaling?.p99TargetMs,
+        idleTimeoutMs: options.scaling?.idleTimeoutMs ?? 30_000,
+      },
+    );
+    try {
+      await Promise.all(Array.from({ length: minWorkers }, () => pool.spawn()));
+    } catch (err) {
+      await pool.close();
+      throw err;
+    }
+    return pool;
+  }
+
+  /** Evaluates a script on whichever worker takes it first. */
+  eval(script: Buffer | Uint8Array | string): Promise<ReplyValue> {
+    return this.evalWithArgs(script);
+  }
+
+  /** Evaluates a script with KEYS/ARGV on whichever worker takes it first. */
+  async evalWithArgs(
+    script: Buffer | Uint8Array | string,
+    keys: Array<Buffer | Uint8Array | string> = [],
+    args: Array<Buffer | Uint8Array | string> = [],
+  ): Promise<ReplyValue> {
+    if (this.closed) {
+      throw new Error("WorkerPool is closed");
+    }
+    const start = performance.now();
+    const reply = await this.producer.submit(script, keys, args);
+    this.recordLatency(performance.now() - start);
+    this.totalEvals++;
+    return reply;
+  }
+
+  /** Current worker counts plus the measurements and decisions of the last interval. */
+  metrics(): PoolMetrics {
+    let warming = 0;
+    for (const w of this.workers) {
+      warming += w.state === "warming" ? 1 : 0;
+    }
+    return {
+      ...this.current,
+      workers: this.serving().length,
+      warming,
+      evals: this.totalEvals,
+      decisions: [...this.decisions],
+    };
+  }
+
+  /** Stops scaling, lets workers drain the ring, and resolves once all have exited. */
+  async close(): Promise<void> {
+    this.closed = true;
+    clearInterval(this.timer);
+    this.producer.close();
+    await Promise.all([...this.workers].map((w) => w.exited));
+  }
+
+  private serving(): PoolWorker[] {
+    return [...this.workers].filter((w) => w.state === "serving");
+  }
+
+  /** Starts a worker in a free stats slot; resolves once it is warm and serving. */
+  private spawn(): Promise<void> {
+    const used = new Set([...this.workers].map((w) => w.index));
+    let index = 0;
+    while (used.has(index)) {
+      index++;
+    }
+    const base = index * STAT_WORDS;
+    for (let word = 0; word < STAT_WORDS; word++) {
+      Atomics.store(this.stats, base + word, 0n);
+    }
+
+    const workerData: PoolWorkerData = { ...this.base, index };
+    const thread = new this.WorkerCtor(this.workerUrl, { workerData });
+    let onExit!: () => void;
+    const worker: PoolWorker = {
+      index,
+      thread,
+      state: "warming",
+      lastBusyUs: 0n,
+      lastEvals: 0n,
+      exited: new Promise((resolve) => (onExit = resolve)),
+    };
+    this.workers.add(worker);
+
+    return new Promise((resolve, reject) => {
+      thread.on("message", (msg: { type: string; message?: string }) => {
+        if (msg.type === "ready") {
+          worker.state = "serving";
+          Atomics.store(this.stats, base + STAT_LAST_ACTIVE_MS, BigInt(Date.now()));
+          this.publishRecycle("spawn", index);
+          resolve();
+        } else if (msg.type === "trapped") {
+          worker.state = "retiring";
+          this.publishRecycle("retire", index);
+        } else if (msg.type === "error") {
+          reject(new Error(`pool worker failed to start: ${msg.message}`));
+        }
+      });
+      thread.on("error", reject);
+      thread.on("exit", () => {
+        this.workers.delete(worker);
+        // The worker records a ticket before it takes it, so the ticket may
+        // instead have gone to a live worker that recorded it too.
+        const ticket = Atomics.load(this.stats, base + STAT_TICKET);
+        if (ticket !== 0n && !this.ticketHeld(ticket)) {
+          this.producer.fail(Number(ticket - 1n) | 0, "ERR pool worker exited during the eval");
+        }
+        this.publishRecycle("exit", index);
+        reject(new Error("pool worker exited before it was ready"));
+        onExit();
+      });
+    });
+  }
+
+  /** True if a live worker has `ticket` (plus one, as stored) recorded. */
+  private ticketHeld(ticket: bigint): boolean {
+    for (const w of this.workers) {
+      if (Atomics.load(this.stats, w.index * STAT_WORDS + STAT_TICKET) === ticket) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  private recordLatency(ms: number): void {
+    // Reservoir sample so a busy interval does not grow the window unboundedly.
+    this.latencyCount++;
+    if (this.latencies.length < MAX_LATENCY_SAMPLES) {
+      this.latencies.push(ms);
+    } else {
+      const slot = Math.floor(Math.random() * this.latencyCount);
+      if (slot < MAX_LATENCY_SAMPLES) {
+        this.latencies[slot] = ms;
+      }
+    }
+  }
+
+  private tick(): void {
+    const now = Date.now();
+    const elapsedMs = Math.max(1, now - this.lastTick);
+    this.lastTick = now;
+
+    const serving = this.serving();
+    let busyUs = 0n;
+    let evals = 0n;
+    for (const w of [...this.workers]) {
+      const base = w.index * STAT_WORDS;
+      const busy = Atomics.load(this.stats, base + STAT_BUSY_US);
+      const count = Atomics.load(this.stats, base + STAT_EVALS);
+      busyUs += busy - w.lastBusyUs;
+      evals += count - w.lastEvals;
+      w.lastBusyUs = busy;
+      w.lastEvals = count;
+    }
+
+    const samples = this.latencies;
+    this.latencies = [];
+    this.latencyCount = 0;
+    const meanLatency = samples.length ? samples.reduce((a, b) => a + b, 0) / samples.length : 0;
+    const meanEvalMs = evals > 0n ? Number(busyUs) / 1000 / Number(evals) : 0;
+
+    this.current.utilization = serving.length
+      ? Math.min(1, Number(busyUs) / 1000 / (elapsedMs * serving.length))
+      : 0;
+    this.current.queueDepth = this.producer.pending;
+    this.current.queueWaitMs = Math.max(0, meanLatency - meanEvalMs);
+    this.current.p99Ms = percentile(samples, 0.99);
+
+    if (!this.closed) {
+      this.decide(now, serving);
+    }
+  }
+
+  private decide(now: number, serving: PoolWorker[]): void {
+    const { utilization, queueWaitMs, p99Ms, queueDepth } = this.current;
+    const s = this.scaling;
+    if (this.workers.size > serving.length) {
+      return; // one scaling step at a time: wait for warming/retiring workers
+    }
+
+    let up: string | null = null;
+    if (serving.length < this.minWorkers) {
+      up = `workers ${serving.length} < minWorkers ${this.minWorkers}`;
+    } else if (serving.length === 0 && queueDepth > 0) {
+      up = `${queueDepth} queued with no workers`;
+    } else if (serving.length < this.maxWorkers) {
+      if (utilization >= s.scaleUpUtilization) {
+        up = `utilization ${utilization.toFixed(2)} >= ${s.scaleUpUtilization}`;
+      } else if (queueWaitMs > s.maxQueueWaitMs) {
+        up = `queue wait ${queueWaitMs.toFixed(2)}ms > ${s.maxQueueWaitMs}ms`;
+      } else if (s.p99TargetMs !== undefined && p99Ms > s.p99TargetMs && queueDepth > 0) {
+        up = `p99 ${p99Ms.toFixed(2)}ms > ${s.p99TargetMs}ms`;
+      }
+    }
+    if (up) {
+      this.current.scaleUps++;
+      this.record({ at: now, action: "up", reason: up, workers: serving.length + 1 });
+      this.spawn().catch(() => {
+        // A worker that fails to start just leaves the pool smaller; the next
+        // tick sees the shortfall and tries again.
+      });
+      return;
+    }
+
+    if (serving.length <= this.minWorkers || utilization > s.scaleDownUtilization) {
+      return;
+    }
+    let idlest: PoolWorker | null = null;
+    let idlestSince = Infinity;
+    for (const w of serving) {
+      const since = Number(Atomics.load(this.stats, w.index * STAT_WORDS + STAT_LAST_ACTIVE_MS));
+      if (since < idlestSince) {
+        idlest = w;
+        idlestSince = since;
+      }
+    }
+    if (idlest && now - idlestSince >= s.idleTimeoutMs) {
+      idlest.state = "retiring";
+      Atomics.store(this.stats, idlest.index * STAT_WORDS + STAT_RETIRE, 1n);
+      this.current.scaleDowns++;
+      this.record({
+        at: now,
+        action: "down",
+        reason: `utilization ${utilization.toFixed(2)} <= ${s.scaleDownUtilization}, ` +
+          `worker idle ${now - idlestSince}ms`,
+        workers: serving.length - 1,
+      });
+      this.publishRecycle("retire", idlest.index);
+    }
+  }
+
+  private publishRecycle(action: RecycleEvent["action"], worker: number): void {
+    if (DIAGNOSTICS && recycleChannel.hasSubscribers) {
+      recycleChannel.publish({ action, worker, workers: this.serving().length });
+    }
+  }
+
+  private record(decision: PoolDecision): void {
+    this.decisions.push(decision);
+    if (this.decisions.length > MAX_DECISIONS) {
+      this.decisions.shift();
+    }
+  }
+}
@@ -0,0 +1,228 @@
+/**
+ * @fileoverview Reply builder: host replies written straight into the wire
+ * format.
+ *
+ * `encodeReplyValue` takes `ReplyValue` object graphs and works out each
+ * node's type from its shape. For hosts returning large replies, that means
+ * allocating the graph, probing every object's properties, and concatenating
+ * one Buffer per node. A `ReplyBuilder` writes each reply into a single
+ * growable buffer as it is produced. `finish()` returns an `EncodedReply`,
+ * which `redisCall`/`redisPcall` can return as is:
+ *
+ * ```typescript
+ * const reply = new ReplyBuilder();
+ * redisCall(args) {
+ *   const rows = db.scan(args[1]);
+ *   reply.array(rows.length);
+ *   for (const row of rows) reply.bulk(row);
+ *   return reply.finish();
+ * }
+ * ```
+ *
+ * Aggregates are written as a header followed by their items: `array(n)` and
+ * `set(n)` take the next `n` replies, `map(n)` the next `n` key/value pairs.
+ * Counts are not checked; a short aggregate is rejected by the VM's decoder.
+ * A writer that throws (a non-integer `int`, a negative count) does so before
+ * writing anything, so the builder still holds the replies written before it.
+ *
+ * @module reply
+ */
+
+import {
+  EncodedReply,
+  encodeReplyValue,
+  REPLY_ARRAY,
+  REPLY_BIG_NUMBER,
+  REPLY_BOOL,
+  REPLY_BULK,
+  REPLY_DOUBLE,
+  REPLY_ERROR,
+  REPLY_INT,
+  REPLY_MAP,
+  REPLY_NULL,
+  REPLY_SET,
+  REPLY_STATUS,
+  REPLY_VERBATIM,
+} from "./codec.js";
+import type { ReplyValue } from "./types.js";
+
+type Bytes = Buffer | Uint8Array | string;
+
+const TWO_POW_32 = 2 ** 32;
+
+/**
+ * Writes replies into one growable buffer. A builder can be reused: `finish()`
+ * copies the reply out and starts over, keeping the buffer.
+ */
+export class ReplyBuilder {
+  private buf: Buffer;
+  private len = 0;
+
+  /** @param initialBytes - Starting capacity; the buffer doubles as needed. */
+  constructor(initialBytes = 256) {
+    this.buf = Buffer.allocUnsafe(Math.max(16, initialBytes));
+  }
+
+  /** Null (RESP2 nil bulk). */
+  null(): this {
+    this.header(REPLY_NULL, 0);
+    return this;
+  }
+
+  /**
+   * 64-bit signed integer. Throws on a non-integer number, like `BigInt()`, and
+   * a RangeError outside the int64 range.
+   */
+  int(value: number | bigint): this {
+    if (typeof value === "number" && Number.isSafeInteger(value)) {
+      const hi = Math.floor(value / TWO_POW_32);
+      const at = this.header(REPLY_INT, 8, 8) + 5;
+      this.buf.writeUInt32LE(value - hi * TWO_POW_32, at);
+      this.buf.writeInt32LE(hi, at + 4);
+      return this;
+    }
+    const big = BigInt(value);
+    if (BigInt.asIntN(64, big) !== big) {
+      throw new RangeError(`integer reply ${big} is outside the int64 range`);
+    }
+    this.buf.writeBigInt64LE(big, this.header(REPLY_INT, 8, 8) + 5);
+    return this;
+  }
+
+  /** Bulk string. Strings are written as UTF-8. */
+  bulk(value: Bytes): this {
+    return this.blob(REPLY_BULK, value);
+  }
+
+  /** Status reply (`+OK`). */
+  status(value: Bytes): this {
+    return this.blob(REPLY_STATUS, value);
+  }
+
+  /** Error reply; `code` (e.g. `"WRONGTYPE"`) is prepended as in `{ err, code }`. */
+  error(message: Bytes, code?: Bytes): this {
+    if (code === undefined) {
+      return this.blob(REPLY_ERROR, message);
+    }
+    const codeLen = byteLength(code);
+    const len = codeLen + 1 + byteLength(message);
+    const at = this.header(REPLY_ERROR, len, len) + 5;
+    this.put(code, at);
+    this.buf[at + codeLen] = 0x20;
+    this.put(message, at + codeLen + 1);
+    return this;
+  }
+
+  /** RESP3 boolean. */
+  bool(value: boolean): this {
+    const at = this.header(REPLY_BOOL, 1, 1);
+    this.buf[at + 5] = value ? 1 : 0;
+    return this;
+  }
+
+  /** RESP3 double. */
+  double(value: number): this {
+    const at = this.header(REPLY_DOUBLE, 8, 8);
+    this.buf.writeDoubleLE(value, at + 5);
+    return this;
+  }
+
+  /** RESP3 big number, as its decimal digits. */
+  bigNumber(digits: Bytes): this {
+    return this.blob(REPLY_BIG_NUMBER, digits);
+  }
+
+  /** RESP3 verbatim string with its three-letter format (e.g. `"txt"`). */
+  verbatim(format: Bytes, value: Bytes): this {
+    const formatLen = byteLength(format);
+    const len = 4 + formatLen + byteLength(value);
+    const at = this.header(REPLY_VERBATIM, len, len) + 5;
+    this.buf.writeUInt32LE(formatLen, at);
+    this.put(format, at + 4);
+    this.put(value, at + 4 + formatLen);
+    return this;
+  }
+
+  /** Array of the next `count` replies. */
+  array(count: number): this {
+    this.header(REPLY_ARRAY, count);
+    return this;
+  }
+
+  /** RESP3 set of the next `count` replies. */
+  set(count: number): this {
+    this.header(REPLY_SET, count);
+    return this;
+  }
+
+  /** RESP3 map of the next `pairs` key/value reply pairs. */
+  map(pairs: number): this {
+    this.header(REPLY_MAP, pairs);
+    return this;
+  }
+
+  /** Appends a `ReplyValue` or an already encoded reply. */
+  value(value: ReplyValue | EncodedReply): this {
+    const bytes = encodeReplyValue(value);
+    this.buf.set(bytes, this.reserve(bytes.length));
+    return this;
+  }
+
+  /** Bytes written since the last `finish()`. */
+  get length(): number {
+    return this.len;
+  }
+
+  /** Returns what was written as an `EncodedReply` and starts a new reply. */
+  finish(): EncodedReply {
+    const bytes = Buffer.from(this.buf.subarray(0, this.len));
+    this.len = 0;
+    return new EncodedReply(bytes);
+  }
+
+  /** Appends `n` bytes and returns where they start. */
+  private reserve(n: number): number {
+    const at = this.len;
+    const end = at + n;
+    if (end > this.buf.length) {
+      const grown = Buffer.allocUnsafe(Math.max(end, this.buf.length * 2));
+      this.buf.copy(grown, 0, 0, at);
+      this.buf = grown;
+    }
+    this.len = end;
+    return at;
+  }
+
+  /**
+   * Writes `[type][countOrLen: u32le]` and reserves a `payload`-byte body after
+   * it. Checks `countOrLen` first, so a bad count reserves nothing.
+   */
+  private header(type: number, countOrLen: number, payload = 0): number {
+    if (!Number.isInteger(countOrLen) || countOrLen < 0 || countOrLen >= TWO_POW_32) {
+      throw new RangeError(`reply count or length ${countOrLen} is not a u32`);
+    }
+    const at = this.reserve(5 + payload);
+    this.buf[at] = type;
+    this.buf.writeUInt32LE(countOrLen, at + 1);
+    return at;
+  }
+
+  private blob(type: number, value: Bytes): this {
+    const len = byteLength(value);
+    const at = this.header(type, len, len);
+    this.put(value, at + 5);
+    return this;
+  }
+
+  private put(value: Bytes, at: number): void {
+    if (typeof value === "string") {
+      this.buf.write(value, at, "utf8");
+    } else {
+      this.buf.set(value, at);
+    }
+  }
+}
+
+function byteLength(value: Bytes): number {
+  return typeof value === "string" ? Buffer.byteLength(value, "utf8") : value.byteLength;
+}
@@ -0,0 +1,433 @@
+/**
+ * @fileoverview SharedArrayBuffer submission/completion ring for engines hosted
+ * on worker threads.
+ *
+ * `postMessage` costs a structured clone plus an event-loop hop in each
+ * direction, which is often more than the eval itself. The ring keeps requests
+ * and replies in shared memory instead: callers claim a slot, write KEYS/ARGV
+ * and the script there, and bump a signal word; workers block on that word with
+ * `Atomics.wait`, run the script, write the encoded reply into the same slot and
+ * `Atomics.notify` the caller. No message crosses the thread boundary.
+ *
+ * ## Layout
+ *
+ * ```
+ * header   16 x i32   [head, tail, signal, slots, slotBytes, closed, space, ...]
+ * control  slots x 4 x i32   per slot: [seq, status, requestLen, replyLen]
+ * data     slots x slotBytes
+ * ```
+ *
+ * Slot hand-off follows a bounded MPMC queue with per-slot sequence numbers
+ * (Vyukov): for ticket `pos`, slot `pos & (slots - 1)` is free when
+ * `seq == pos`, submitted when `seq == pos + 1`, and released to the next lap
+ * with `seq = pos + slots`. `head` and `tail` are claimed with
+ * compare-and-swap, so any number of producers and consumers can share a ring.
+ *
+ * Request: `[keysCount: u32]` + ArgArray `[script, ...keys, ...args]`.
+ * Reply: the standard reply encoding (`encodeReplyValue`).
+ *
+ * A consumer that dies holding a ticket never completes it. Whoever supervises
+ * consumers learns the ticket from `serveOnce`'s `onClaim` hook, which runs
+ * before the compare-and-swap that takes it, so no claim goes unrecorded, and
+ * hands it to {@link RingProducer.fail}. That completes the request with an
+ * error reply, so that its submitter returns and releases the slot, provided
+ * the ticket was taken at all; when the consumer lost the race for it, the
+ * supervisor must not fail a ticket another live consumer recorded.
+ *
+ * Once the ring is closed, submissions throw. A producer that claimed a ticket
+ * just as the ring closed publishes it as cancelled instead of as a request:
+ * consumers still draining step over it, and its submitter throws at once
+ * rather than waiting on consumers that may already have stopped.
+ *
+ * @module ring
+ */
+
+import { decodeReply, encodeArgArray, encodeReplyValue } from "./codec.js";
+import { decodeArgs } from "./helpers.js";
+import type { ReplyValue } from "./types.js";
+
+const HEAD = 0;
+const TAIL = 1;
+const SIGNAL = 2;
+const SLOTS = 3;
+const SLOT_BYTES = 4;
+const CLOSED = 5;
+const SPACE = 6;
+const HEADER_WORDS = 16;
+
+const CTL_SEQ = 0;
+const CTL_STATUS = 1;
+const CTL_REQUEST_LEN = 2;
+const CTL_REPLY_LEN = 3;
+const CTL_WORDS = 4;
+
+const STATUS_PENDING = 0;
+const STATUS_DONE = 1;
+const STATUS_CANCELLED = 2;
+
+// Atomics.waitAsync is ES2024; the compile target's lib does not declare it.
+type WaitAsyncResult =
+  | { async: false; value: "not-equal" | "timed-out" }
+  | { async: true; value: Promise<"ok" | "timed-out"> };
+const waitAsync = (Atomics as unknown as {
+  waitAsync(typed: Int32Array, index: number, value: number): WaitAsyncResult;
+}).waitAsync;
+
+/** Options for {@link createRing}. */
+export type RingOptions = {
+  /** Number of slots (in-flight requests). Power of two, at least 2. Default: 64. */
+  slots?: number;
+
+  /** Bytes per slot; bounds both the request and the encoded reply. Default: 64 KiB. */
+  slotBytes?: number;
+};
+
+/**
+ * Handler run by a {@link RingConsumer} for each request, typically
+ * `(script, keys, args) => engine.evalWithArgs(script, keys, args)`.
+ */
+export type RingHandler = (script: Buffer, keys: Buffer[], args: Buffer[]) => ReplyValue;
+
+/**
+ * Allocates a ring. Pass `ring` (the SharedArrayBuffer) to workers via
+ * `workerData` or one `postMessage`; both sides then wrap it in a
+ * {@link RingProducer} or {@link RingConsumer}.
+ */
+export function createRing(options: RingOptions = {}): SharedArrayBuffer {
+  const slots = options.slots ?? 64;
+  const slotBytes = options.slotBytes ?? 64 * 1024;
+  // One slot would make "submitted" (pos + 1) and "free next lap" (pos + slots) equal.
+  if (!Number.isInteger(slots) || slots < 2 || (slots & (slots - 1)) !== 0) {
+    throw new RangeError("ring slots must be a power of two, at least 2");
+  }
+  if (!Number.isInteger(slotBytes) || slotBytes < 64 || slotBytes % 8 !== 0) {
+    throw new RangeError("ring slotBytes must be a multiple of 8, at least 64");
+  }
+  const ctlBytes = (HEADER_WORDS + slots * CTL_WORDS) * 4;
+  const buffer = new SharedArrayBuffer(ctlBytes + slots * slotBytes);
+  const i32 = new Int32Array(buffer, 0, HEADER_WORDS + slots * CTL_WORDS);
+  i32[SLOTS] = slots;
+  i32[SLOT_BYTES] = slotBytes;
+  for (let slot = 0; slot < slots; slot++) {
+    i32[HEADER_WORDS + slot * CTL_WORDS + CTL_SEQ] = slot;
+  }
+  return buffer;
+}
+
+/** Shared views over a ring buffer. */
+class RingView {
+  protected readonly i32: Int32Array;
+  protected readonly bytes: Uint8Array;
+  protected readonly slots: number;
+  protected readonly slotBytes: number;
+  private readonly dataOffset: number;
+
+  constructor(readonly buffer: SharedArrayBuffer) {
+    const header = new Int32Array(buffer, 0, HEADER_WORDS);
+    this.slots = header[SLOTS];
+    this.slotBytes = header[SLOT_BYTES];
+    this.i32 = new Int32Array(buffer, 0, HEADER_WORDS + this.slots * CTL_WORDS);
+    this.dataOffset = (HEADER_WORDS + this.slots * CTL_WORDS) * 4;
+    this.bytes = new Uint8Array(buffer);
+  }
+
+  protected ctl(slot: number, field: number): number {
+    return HEADER_WORDS + slot * CTL_WORDS + field;
+  }
+
+  protected data(slot: number): number {
+    return this.dataOffset + slot * this.slotBytes;
+  }
+
+  /** Requests submitted (or being submitted) that no consumer has taken yet. */
+  get pending(): number {
+    return (Atomics.load(this.i32, HEAD) - Atomics.load(this.i32, TAIL)) | 0;
+  }
+
+  /** True once {@link RingProducer.close} has been called. */
+  get closed(): boolean {
+    return Atomics.load(this.i32, CLOSED) !== 0;
+  }
+
+  /** Hands `slot` to the next lap and wakes a producer blocked on a full ring. */
+  protected recycle(pos: number, slot: number): void {
+    Atomics.store(this.i32, this.ctl(slot, CTL_SEQ), (pos + this.slots) | 0);
+    Atomics.add(this.i32, SPACE, 1);
+    Atomics.notify(this.i32, SPACE, 1);
+  }
+
+  /** Writes `reply` into `slot`, marks it done and wakes its submitter. */
+  protected complete(slot: number, reply: ReplyValue): void {
+    let encoded = encodeReplyValue(reply);
+    if (encoded.length > this.slotBytes) {
+      encoded = encodeReplyValue({ err: Buffer.from("ERR reply exceeds ring slot size") });
+    }
+    this.bytes.set(encoded, this.data(slot));
+    Atomics.store(this.i32, this.ctl(slot, CTL_REPLY_LEN), encoded.length);
+    Atomics.store(this.i32, this.ctl(slot, CTL_STATUS), STATUS_DONE);
+    Atomics.notify(this.i32, this.ctl(slot, CTL_STATUS));
+  }
+}
+
+/**
+ * Caller side: submits scripts and waits for their replies.
+ *
+ * ```typescript
+ * const ring = createRing();
+ * new Worker("./engine-worker.js", { workerData: { ring } });
+ * const producer = new RingProducer(ring);
+ * const reply = await producer.submit("return ARGV[1]", [], ["hi"]);
+ * ```
+ */
+export class RingProducer extends RingView {
+  /**
+   * Submits a request and resolves with its reply. Waits with
+   * `Atomics.waitAsync`, so it never blocks the calling thread.
+   *
+   * @throws RangeError if the encoded request does not fit in a slot.
+   * @throws Error if the ring is closed.
+   */
+  async submit(
+    script: Buffer | Uint8Array | string,
+    keys: Array<Buffer | Uint8Array | string> = [],
+    args: Array<Buffer | Uint8Array | string> = [],
+  ): Promise<ReplyValue> {
+    const request = this.encodeRequest(script, keys, args);
+    let pos: number | null = null;
+    while (pos === null) {
+      // Read the space word before claiming so a release in between is not missed.
+      const space = Atomics.load(this.i32, SPACE);
+      pos = this.tryClaim();
+      if (pos === null) {
+        await this.waitAsync(SPACE, space);
+      }
+    }
+    const slot = this.publish(pos, request);
+    const status = this.ctl(slot, CTL_STATUS);
+    while (Atomics.load(this.i32, status) !== STATUS_DONE) {
+      await this.waitAsync(status, STATUS_PENDING);
+    }
+    return this.release(pos, slot);
+  }
+
+  /**
+   * Like {@link submit}, but blocks the calling thread with `Atomics.wait`.
+   * Not allowed on a browser main thread.
+   *
+   * @throws RangeError if the encoded request does not fit in a slot.
+   * @throws Error if the ring is closed.
+   */
+  submitSync(
+    script: Buffer | Uint8Array | string,
+    keys: Array<Buffer | Uint8Array | string> = [],
+    args: Array<Buffer | Uint8Array | string> = [],
+  ): ReplyValue {
+    const request = this.encodeRequest(script, keys, args);
+    let pos: number | null = null;
+    while (pos === null) {
+      // Read the space word before claiming so a release in between is not missed.
+      const space = Atomics.load(this.i32, SPACE);
+      pos = this.tryClaim();
+      if (pos === null) {
+        Atomics.wait(this.i32, SPACE, space);
+      }
+    }
+    const slot = this.publish(pos, request);
+    const status = this.ctl(slot, CTL_STATUS);
+    while (Atomics.load(this.i32, status) !== STATUS_DONE) {
+      Atomics.wait(this.i32, status, STATUS_PENDING);
+    }
+    return this.release(pos, slot);
+  }
+
+  /**
+   * Completes `ticket` with an error reply for a consumer that claimed it and
+   * exited without replying. Its submitter then returns and releases the slot.
+   * Returns false, changing nothing, if the ticket is not in flight: no
+   * consumer has taken it yet (it stays queued), the reply was written, or the
+   * slot has moved on.
+   */
+  fail(ticket: number, message: string): boolean {
+    const slot = ticket & (this.slots - 1);
+    if (
+      ((Atomics.load(this.i32, TAIL) - ticket) | 0) <= 0 ||
+      Atomics.load(this.i32, this.ctl(slot, CTL_SEQ)) !== ((ticket + 1) | 0) ||
+      Atomics.load(this.i32, this.ctl(slot, CTL_STATUS)) !== STATUS_PENDING
+    ) {
+      return false;
+    }
+    this.complete(slot, { err: Buffer.from(message) });
+    return true;
+  }
+
+  /**
+   * Tells consumers to stop once the ring drains, and wakes idle ones.
+   * Producers waiting for a free slot wake and throw.
+   */
+  close(): void {
+    Atomics.store(this.i32, CLOSED, 1);
+    Atomics.add(this.i32, SIGNAL, 1);
+    Atomics.notify(this.i32, SIGNAL);
+    Atomics.add(this.i32, SPACE, 1);
+    Atomics.notify(this.i32, SPACE);
+  }
+
+  private encodeRequest(
+    script: Buffer | Uint8Array | string,
+    keys: Array<Buffer | Uint8Array | string>,
+    args: Array<Buffer | Uint8Array | string>,
+  ): Buffer {
+    const header = Buffer.alloc(4);
+    header.writeUInt32LE(keys.length, 0);
+    const request = Buffer.concat([header, encodeArgArray([script, ...keys, ...args])]);
+    if (request.length > this.slotBytes) {
+      throw new RangeError(
+        `ring request is ${request.length} bytes; slots hold ${this.slotBytes}`,
+      );
+    }
+    return request;
+  }
+
+  /**
+   * Claims the next ticket, or returns null while the ring is full.
+   *
+   * @throws Error if the ring is closed.
+   */
+  private tryClaim(): number | null {
+    for (;;) {
+      if (this.closed) {
+        throw new Error("ring is closed");
+      }
+      const pos = Atomics.load(this.i32, HEAD);
+      const seq = Atomics.load(this.i32, this.ctl(pos & (this.slots - 1), CTL_SEQ));
+      const diff = (seq - pos) | 0;
+      if (diff < 0) {
+        return null;
+      }
+      if (diff === 0 && Atomics.compareExchange(this.i32, HEAD, pos, (pos + 1) | 0) === pos) {
+        return pos;
+      }
+    }
+  }
+
+  /**
+   * Writes the request into the claimed slot and hands it to consumers.
+   *
+   * @throws Error if the ring closed since the claim; the slot is then
+   * published as cancelled, for a draining consumer to step over.
+   */
+  private publish(pos: number, request: Buffer): number {
+    const slot = pos & (this.slots - 1);
+    const closed = this.closed;
+    if (!closed) {
+      this.bytes.set(request, this.data(slot));
+    }
+    Atomics.store(this.i32, this.ctl(slot, CTL_REQUEST_LEN), closed ? 0 : request.length);
+    Atomics.store(
+      this.i32,
+      this.ctl(slot, CTL_STATUS),
+      closed ? STATUS_CANCELLED : STATUS_PENDING,
+    );
+    Atomics.store(this.i32, this.ctl(slot, CTL_SEQ), (pos + 1) | 0);
+    Atomics.add(this.i32, SIGNAL, 1);
+    Atomics.notify(this.i32, SIGNAL, 1);
+    if (closed) {
+      throw new Error("ring is closed");
+    }
+    return slot;
+  }
+
+  /** Reads the reply and hands the slot to the next lap. */
+  private release(pos: number, slot: number): ReplyValue {
+    const len = Atomics.load(this.i32, this.ctl(slot, CTL_REPLY_LEN));
+    const offset = this.data(slot);
+    const reply = Buffer.from(this.bytes.slice(offset, offset + len));
+    this.recycle(pos, slot);
+    return decodeReply(reply).value;
+  }
+
+  private async waitAsync(index: number, value: number): Promise<void> {
+    const result = waitAsync(this.i32, index, value);
+    if (result.async) {
+      await result.value;
+    }
+  }
+}
+
+/**
+ * Worker side: takes requests off the ring and writes replies back.
+ *
+ * ```typescript
+ * const consumer = new RingConsumer(workerData.ring);
+ * consumer.serve((script, keys, args) => engine.evalWithArgs(script, keys, args));
+ * ```
+ */
+export class RingConsumer extends RingView {
+  /**
+   * Serves one request, blocking up to `timeoutMs` (default: forever) for one
+   * to arrive. Returns false on timeout or once the ring is closed and empty.
+   * `onClaim` receives each ticket just before this consumer tries to take it,
+   * for {@link RingProducer.fail} should this consumer die. If another consumer
+   * takes the ticket first, `onClaim` runs again for the next one.
+   */
+  serveOnce(
+    handler: RingHandler,
+    timeoutMs = Infinity,
+    onClaim?: (ticket: number) => void,
+  ): boolean {
+    for (;;) {
+      const signal = Atomics.load(this.i32, SIGNAL);
+      const pos = Atomics.load(this.i32, TAIL);
+      const slot = pos & (this.slots - 1);
+      const seq = Atomics.load(this.i32, this.ctl(slot, CTL_SEQ));
+      const diff = (seq - ((pos + 1) | 0)) | 0;
+      if (diff === 0) {
+        // Record the ticket before taking it: a consumer that dies right after
+        // the swap must not leave a claimed ticket nobody knows about.
+        onClaim?.(pos);
+        if (Atomics.compareExchange(this.i32, TAIL, pos, (pos + 1) | 0) === pos) {
+          if (Atomics.load(this.i32, this.ctl(slot, CTL_STATUS)) === STATUS_CANCELLED) {
+            // Its submitter saw the ring close and is gone; nobody reads a reply.
+            this.recycle(pos, slot);
+            continue;
+          }
+          this.process(slot, handler);
+          return true;
+        }
+        continue;
+      }
+      if (diff > 0) {
+        continue; // another consumer took this ticket; reload tail
+      }
+      if (this.closed) {
+        return false;
+      }
+      if (Atomics.wait(this.i32, SIGNAL, signal, timeoutMs) === "timed-out") {
+        return false;
+      }
+    }
+  }
+
+  /** Serves requests until the producer closes the ring. */
+  serve(handler: RingHandler): void {
+    while (this.serveOnce(handler)) {
+      // keep serving
+    }
+  }
+
+  private process(slot: number, handler: RingHandler): void {
+    const offset = this.data(slot);
+    const len = Atomics.load(this.i32, this.ctl(slot, CTL_REQUEST_LEN));
+    const request = Buffer.from(this.bytes.slice(offset, offset + len));
+
+    let reply: ReplyValue;
+    try {
+      const keysCount = request.readUInt32LE(0);
+      const [script, ...rest] = decodeArgs(request.subarray(4));
+      reply = handler(script, rest.slice(0, keysCount), rest.slice(keysCount));
+    } catch (err) {
+      reply = { err: Buffer.from(err instanceof Error ? err.message : String(err)) };
+    }
+    this.complete(slot, reply);
+  }
+}
@@ -0,0 +1,234 @@
+/**
+ * @fileoverview Namespaced bookkeeping for an engine's script cache.
+ *
+ * The VM keeps one cache of compiled functions keyed by sha. On top of it, each
+ * namespace (a tenant id passed to `scriptLoad`/`installScript`/`evalSha`) has
+ * its own view: the shas loaded into it, least recently used first, with
+ * optional byte and entry quotas. A namespace over quota evicts its own least
+ * recently used scripts, never another namespace's. A script loaded into
+ * several namespaces leaves the VM only once none of them holds it, and while
+ * another namespace holds a sha it cannot be replaced with different bytecode
+ * (see `heldElsewhere`). `evalSha` in a namespace only finds scripts loaded
+ * into that namespace.
+ *
+ * Scripts preloaded with `LoadOptions.scripts` or `preloadScripts()` live in
+ * the default namespace (`""`) and are pinned there: they count towards its
+ * usage but quotas and memory pressure never evict them. Another namespace
+ * loading the same sha gets an ordinary, evictable entry.
+ *
+ * @module script-cache
+ */
+
+import type { ScriptCacheOptions, ScriptCacheQuota, ScriptCacheStats } from "./types.js";
+
+type Namespace = {
+  /** sha -> bytecode size, least recently used first. */
+  scripts: Map<string, number>;
+  bytes: number;
+  quota: ScriptCacheQuota;
+  hits: number;
+  misses: number;
+  loads: number;
+  evictions: number;
+};
+
+/** Which scripts each namespace holds, and its counters. @internal */
+export class ScriptNamespaces {
+  private namespaces = new Map<string, Namespace>();
+  /** sha -> number of namespaces holding it. */
+  private refs = new Map<string, number>();
+  /** Shas pinned in the default namespace. */
+  private pinned = new Set<string>();
+
+  constructor(private options: ScriptCacheOptions = {}) {}
+
+  /**
+   * Throws if `bytes` alone exceeds the namespace's byte quota, before anything
+   * is installed.
+   */
+  checkFits(namespace: string, bytes: number): void {
+    const maxBytes = this.quota(namespace).maxBytes;
+    if (maxBytes !== undefined && bytes > maxBytes) {
+      throw new Error(
+        `ERR script of ${bytes} bytes exceeds the ${maxBytes}-byte quota of namespace '${namespace}'`,
+      );
+    }
+  }
+
+  /**
+   * Records `sha` as loaded into `namespace`, evicting the namespace's least
+   * recently used scripts while it is over quota. Returns the evicted shas that
+   * no namespace holds any more, for removal from the VM.
+   */
+  add(namespace: string, sha: string, bytes: number): string[] {
+    const ns = this.namespace(namespace);
+    const previous = ns.scripts.get(sha);
+    if (previous !== undefined) {
+      ns.scripts.delete(sha);
+      ns.bytes -= previous;
+    } else {
+      this.refs.set(sha, (this.refs.get(sha) ?? 0) + 1);
+    }
+    ns.scripts.set(sha, bytes);
+    ns.bytes += bytes;
+    ns.loads++;
+
+    const { maxBytes = Infinity, maxEntries = Infinity } = ns.quota;
+    const unreferenced: string[] = [];
+    for (const [victim, size] of ns.scripts) {
+      if (ns.bytes <= maxBytes && ns.scripts.size <= maxEntries) {
+        break;
+      }
+      if (victim === sha || this.isPinned(namespace, victim)) {
+        continue;
+      }
+      this.drop(ns, victim, size, unreferenced);
+      ns.evictions++;
+    }
+    return unreferenced;
+  }
+
+  /** Exempts a default-namespace script from eviction. */
+  pin(sha: string): void {
+    this.pinned.add(sha);
+  }
+
+  /** True if a namespace other than `namespace` holds `sha`. */
+  heldElsewhere(namespace: string, sha: string): boolean {
+    return (this.refs.get(sha) ?? 0) > (this.has(namespace, sha) ? 1 : 0);
+  }
+
+  /** True if `namespace` holds `sha`. */
+  has(namespace: string, sha: string): boolean {
+    return this.namespaces.get(namespace)?.scripts.has(sha) ?? false;
+  }
+
+  /** `has`, counting a hit or miss and marking the script recently used. */
+  lookup(namespace: string, sha: string): boolean {
+    const ns = this.namespace(namespace);
+    const bytes = ns.scripts.get(sha);
+    if (bytes === undefined) {
+      ns.misses++;
+      return false;
+    }
+    ns.hits++;
+    ns.scripts.delete(sha);
+    ns.scripts.set(sha, bytes);
+    return true;
+  }
+
+  /** Empties one namespace. Returns the shas no namespace holds any more. */
+  flush(namespace: string): string[] {
+    const ns = this.namespaces.get(namespace);
+    const unreferenced: string[] = [];
+    if (ns) {
+      for (const [sha, size] of ns.scripts) {
+        this.drop(ns, sha, size, unreferenced);
+        if (namespace === "") {
+          this.pinned.delete(sha);
+        }
+      }
+    }
+    return unreferenced;
+  }
+
+  /**
+   * Removes `sha` from `namespace`, pinned or not. Returns it if no namespace
+   * holds it any more.
+   */
+  remove(namespace: string, sha: string): string[] {
+    const ns = this.namespaces.get(namespace);
+    const size = ns?.scripts.get(sha);
+    const unreferenced: string[] = [];
+    if (ns && size !== undefined) {
+      this.drop(ns, sha, size, unreferenced);
+      if (namespace === "") {
+        this.pinned.delete(sha);
+      }
+    }
+    return unreferenced;
+  }
+
+  /**
+   * Evicts every unpinned script from every namespace (memory pressure).
+   * Returns the shas no namespace holds any more.
+   */
+  shrink(): string[] {
+    const unreferenced: string[] = [];
+    for (const [name, ns] of this.namespaces) {
+      for (const [sha, size] of ns.scripts) {
+        if (!this.isPinned(name, sha)) {
+          this.drop(ns, sha, size, unreferenced);
+          ns.evictions++;
+        }
+      }
+    }
+    return unreferenced;
+  }
+
+  /** Forgets every script (the VM cache is gone); counters are kept. */
+  clear(): void {
+    for (const ns of this.namespaces.values()) {
+      ns.scripts.clear();
+      ns.bytes = 0;
+    }
+    this.refs.clear();
+    this.pinned.clear();
+  }
+
+  /** Per-namespace usage and counters. */
+  stats(): Record<string, ScriptCacheStats> {
+    const out: Record<string, ScriptCacheStats> = {};
+    for (const [name, ns] of this.namespaces) {
+      const lookups = ns.hits + ns.misses;
+      out[name] = {
+        entries: ns.scripts.size,
+        bytes: ns.bytes,
+        hits: ns.hits,
+        misses: ns.misses,
+        hitRate: lookups ? ns.hits / lookups : 0,
+        loads: ns.loads,
+        evictions: ns.evictions,
+        ...ns.quota,
+      };
+    }
+    return out;
+  }
+
+  private isPinned(namespace: string, sha: string): boolean {
+    return namespace === "" && this.pinned.has(sha);
+  }
+
+  private quota(namespace: string): ScriptCacheQuota {
+    return this.options.namespaces?.[namespace] ?? this.options.quota ?? {};
+  }
+
+  private namespace(name: string): Namespace {
+    let ns = this.namespaces.get(name);
+    if (!ns) {
+      ns = {
+        scripts: new Map(),
+        bytes: 0,
+        quota: this.quota(name),
+        hits: 0,
+        misses: 0,
+        loads: 0,
+        evictions: 0,
+      };
+      this.namespaces.set(name, ns);
+    }
+    return ns;
+  }
+
+  private drop(ns: Namespace, sha: string, size: number, unreferenced: string[]): void {
+    ns.scripts.delete(sha);
+    ns.bytes -= size;
+    const refs = (this.refs.get(sha) ?? 1) - 1;
+    if (refs > 0) {
+      this.refs.set(sha, refs);
+    } else {
+      this.refs.delete(sha);
+      unreferenced.push(sha);
+    }
+  }
+}
@@ -12,6 +12,30 @@
 
 /** Compute the SHA-1 digest of `bytes` as a 40-character lowercase hex string. */
 export function sha1Hex(bytes: Uint8Array): string {
+  let hex = "";
+  for (const byte of sha1(bytes)) {
+    hex += byte.toString(16).padStart(2, "0");
+  }
+  return hex;
+}
+
+/** Compute HMAC-SHA1 (RFC 2104) of `message` under `key`; 20 bytes. */
+export function hmacSha1(key: Uint8Array, message: Uint8Array): Uint8Array {
+  const block = new Uint8Array(64);
+  block.set(key.length > 64 ? sha1(key) : key);
+  const inner = new Uint8Array(64 + message.length);
+  const outer = new Uint8Array(64 + 20);
+  for (let i = 0; i < 64; i++) {
+    inner[i] = block[i] ^ 0x36;
+    outer[i] = block[i] ^ 0x5c;
+  }
+  inner.set(message, 64);
+  outer.set(sha1(inner), 64);
+  return sha1(outer);
+}
+
+/** Compute the 20-byte SHA-1 digest of `bytes`. */
+function sha1(bytes: Uint8Array): Uint8Array {
   let h0 = 0x67452301;
   let h1 = 0xefcdab89;
   let h2 = 0x98badcfe;
@@ -74,11 +98,12 @@ export function sha1Hex(bytes: Uint8Array): string {
     h4 = (h4 + e) >>> 0;
   }
 
-  return (
-    hex8(h0) + hex8(h1) + hex8(h2) + hex8(h3) + hex8(h4)
-  );
-}
-
-function hex8(n: number): string {
-  return (n >>> 0).toString(16).padStart(8, "0");
+  const digest = new Uint8Array(20);
+  const out = new DataView(digest.buffer);
+  out.setUint32(0, h0);
+  out.setUint32(4, h1);
+  out.setUint32(8, h2);
+  out.setUint32(12, h3);
+  out.setUint32(16, h4);
+  return digest;
 }
@@ -0,0 +1,154 @@
+/**
+ * @fileoverview Node startup-snapshot support (`node --build-snapshot`).
+ *
+ * A startup snapshot captures the JS heap after the snapshot entry script has
+ * run, so everything the engine needs from disk can be read at build time:
+ * `prepareSnapshot()` stores the `.wasm` bytes and the CommonJS Emscripten
+ * glue (`redis_lua.cjs`) in the heap. When a process starts from the snapshot,
+ * a deserialize callback immediately begins compiling and instantiating, and
+ * `snapshotEngine()` hands out the engine once that is done — no file reads,
+ * no module resolution.
+ *
+ * V8 does not allow WebAssembly while a snapshot is being built (the global is
+ * absent), so compilation, instantiation and `init()` cannot be captured; they
+ * run at process start, overlapping whatever the main function does first.
+ * Dynamic `import()` is unavailable in both phases, which is why this path
+ * uses the CommonJS glue and `process.getBuiltinModule` (Node >= 22.3).
+ *
+ * ```js
+ * // snapshot-entry.js (bundled to one CommonJS file)
+ * const { prepareSnapshot, snapshotEngine } = require("lua-redis-wasm");
+ * const v8 = require("node:v8");
+ * prepareSnapshot({ warmup: true });
+ * v8.startupSnapshot.setDeserializeMainFunction(async () => {
+ *   const engine = await snapshotEngine();
+ *   console.log(engine.eval("return 1 + 1"));
+ * });
+ * ```
+ *
+ * @module snapshot
+ */
+
+import { load, type LuaEngine, type LuaWasmModule } from "./engine.js";
+import type { EmscriptenModuleFactory } from "./loader-core.js";
+import type { LoadOptions, RedisHost } from "./types.js";
+
+/**
+ * Options for {@link prepareSnapshot}. Paths are read at snapshot-build time;
+ * pass `wasmPath` and `gluePath` when the entry is bundled somewhere the
+ * co-located assets cannot be found from.
+ */
+export type SnapshotOptions = Omit<
+  LoadOptions,
+  "wasmBytes" | "wasmModule" | "wasmCache" | "moduleFactory" | "modulePath"
+> & {
+  /** CommonJS Emscripten glue. Default: the co-located `redis_lua.cjs`. */
+  gluePath?: string;
+};
+
+type Captured = {
+  wasm: Uint8Array;
+  glue: string;
+  gluePath: string;
+  options: LoadOptions;
+};
+
+let captured: Captured | null = null;
+let factory: EmscriptenModuleFactory | null = null;
+let compiled: Promise<WebAssembly.Module> | null = null;
+let preloaded: Promise<LuaWasmModule> | null = null;
+
+function builtin<T>(id: string): T {
+  const getBuiltinModule = (process as { getBuiltinModule?: (id: string) => unknown })
+    .getBuiltinModule;
+  if (!getBuiltinModule) {
+    throw new Error("Startup snapshots require Node.js >= 22.3 (process.getBuiltinModule)");
+  }
+  return getBuiltinModule(id) as T;
+}
+
+/** Co-located asset: the built `dist/` layout, else the dev `wasm/build/` one. */
+function assetPath(file: string): string {
+  const fs = builtin<typeof import("node:fs")>("node:fs");
+  const path = builtin<typeof import("node:path")>("node:path");
+  const { fileURLToPath } = builtin<typeof import("node:url")>("node:url");
+  const here = path.dirname(fileURLToPath(import.meta.url));
+  for (const rel of [`./${file}`, `../wasm/build/${file}`]) {
+    const candidate = path.resolve(here, rel);
+    if (fs.existsSync(candidate)) {
+      return candidate;
+    }
+  }
+  return path.resolve(here, `./${file}`);
+}
+
+/** Evaluates the CommonJS glue source and returns its factory. */
+function glueFactory(source: string, filename: string): EmscriptenModuleFactory {
+  const vm = builtin<typeof import("node:vm")>("node:vm");
+  const path = builtin<typeof import("node:path")>("node:path");
+  const module = { exports: {} as Record<string, unknown> };
+  const run = vm.compileFunction(
+    source,
+    ["module", "exports", "require", "__filename", "__dirname"],
+    { filename },
+  );
+  run(module, module.exports, builtin, filename, path.dirname(filename));
+  const exported = module.exports as { default?: unknown };
+  return (exported.default ?? exported) as EmscriptenModuleFactory;
+}
+
+/** Loads a module from the captured glue and wasm, compiling the wasm once. */
+function loadCaptured(state: Captured): Promise<LuaWasmModule> {
+  factory ??= glueFactory(state.glue, state.gluePath);
+  compiled ??= WebAssembly.compile(state.wasm);
+  const moduleFactory = factory;
+  return compiled.then((wasmModule) =>
+    load({ ...state.options, wasmModule, moduleFactory }),
+  );
+}
+
+/**
+ * Call from the snapshot entry script while `node --build-snapshot` runs.
+ * Reads the wasm and glue into the heap and arranges for loading to start as
+ * soon as a process is deserialized from the snapshot.
+ *
+ * @throws Error when not building a snapshot
+ */
+export function prepareSnapshot(options: SnapshotOptions = {}): void {
+  const v8 = builtin<typeof import("node:v8")>("node:v8");
+  if (!v8.startupSnapshot.isBuildingSnapshot()) {
+    throw new Error("prepareSnapshot() must run under node --build-snapshot");
+  }
+  const fs = builtin<typeof import("node:fs")>("node:fs");
+  const { wasmPath, gluePath, ...rest } = options;
+  const resolvedGlue = gluePath ?? assetPath("redis_lua.cjs");
+  captured = {
+    wasm: new Uint8Array(fs.readFileSync(wasmPath ?? assetPath("redis_lua.wasm"))),
+    glue: fs.readFileSync(resolvedGlue, "utf8"),
+    gluePath: resolvedGlue,
+    options: rest,
+  };
+  v8.startupSnapshot.addDeserializeCallback(() => {
+    preloaded = loadCaptured(captured!);
+    // Surfaced by snapshotEngine(); keep an early failure from being unhandled.
+    preloaded.catch(() => {});
+  });
+}
+
+/**
+ * In a process started from the snapshot: resolves to an engine built from
+ * the captured wasm (standalone without `host`). The first call takes the
+ * module preloaded at startup; later calls load another from the same
+ * compiled wasm.
+ *
+ * @throws Error if the snapshot was not built with {@link prepareSnapshot}
+ */
+export async function snapshotEngine(host?: RedisHost): Promise<LuaEngine> {
+  if (!captured) {
+    throw new Error("No snapshot state; call prepareSnapshot() in the snapshot entry");
+  }
+  const pending = preloaded ?? loadCaptured(captured);
+  preloaded = null;
+  const module = await pending;
+  return host ? module.create(host) : module.createStandalone();
+}
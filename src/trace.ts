@@ -0,0 +1,109 @@
+/**
+ * @fileoverview Eval lifecycle tracing in Trace Event Format.
+ *
+ * A `Tracer` attached to an engine (`LoadOptions.tracer` or
+ * `engine.setTracer()`) records one complete ("X") event per phase of every
+ * eval: the eval itself, KEYS/ARGV encoding, and, from timestamps the WASM side
+ * takes, setting KEYS/ARGV, compiling, executing and encoding the reply. Host
+ * calls (`redis.call`/`redis.pcall`, with the command name and byte counts) and
+ * the JS-side reply decode nest inside by time. Events go into a bounded ring:
+ * once it is full the oldest are overwritten and counted in `dropped`.
+ *
+ * `JSON.stringify(tracer)` produces a file Perfetto (ui.perfetto.dev) and
+ * chrome://tracing load directly. Engines without a tracer take no timestamps.
+ *
+ * @module trace
+ */
+
+/** One complete event in Trace Event Format (timestamps in microseconds). */
+export type TraceEvent = {
+  name: string;
+  cat: string;
+  ph: "X";
+  ts: number;
+  dur: number;
+  pid: number;
+  tid: number;
+  args?: Record<string, string | number>;
+};
+
+/** Options for {@link Tracer}. */
+export type TracerOptions = {
+  /** Events kept before the oldest are overwritten. Default: 100000. */
+  capacity?: number;
+  /** `pid` written on every event, e.g. to tell processes apart. Default: 1. */
+  pid?: number;
+  /** `tid` written on every event, e.g. a worker's `threadId`. Default: 1. */
+  tid?: number;
+};
+
+const DEFAULT_CAPACITY = 100_000;
+
+/** Bounded in-memory buffer of trace events. */
+export class Tracer {
+  /** Events overwritten because the ring was full. */
+  dropped = 0;
+
+  private ring: TraceEvent[] = [];
+  private next = 0;
+  private readonly capacity: number;
+  private readonly pid: number;
+  private readonly tid: number;
+
+  constructor(options: TracerOptions = {}) {
+    this.capacity = Math.max(1, Math.floor(options.capacity ?? DEFAULT_CAPACITY));
+    this.pid = options.pid ?? 1;
+    this.tid = options.tid ?? 1;
+  }
+
+  /**
+   * Records a span between two `performance.now()` readings (ms).
+   */
+  span(
+    name: string,
+    cat: string,
+    startMs: number,
+    endMs: number,
+    args?: Record<string, string | number>,
+  ): void {
+    const event: TraceEvent = {
+      name,
+      cat,
+      ph: "X",
+      ts: startMs * 1000,
+      dur: Math.max(0, endMs - startMs) * 1000,
+      pid: this.pid,
+      tid: this.tid,
+    };
+    if (args) {
+      event.args = args;
+    }
+    if (this.ring.length < this.capacity) {
+      this.ring.push(event);
+    } else {
+      this.ring[this.next] = event;
+      this.dropped++;
+    }
+    this.next = (this.next + 1) % this.capacity;
+  }
+
+  /** Buffered events, oldest first. */
+  events(): TraceEvent[] {
+    if (this.ring.length < this.capacity) {
+      return this.ring.slice();
+    }
+    return [...this.ring.slice(this.next), ...this.ring.slice(0, this.next)];
+  }
+
+  /** Discards buffered events and the dropped count. */
+  clear(): void {
+    this.ring = [];
+    this.next = 0;
+    this.dropped = 0;
+  }
+
+  /** The JSON Object Format: `{ traceEvents, displayTimeUnit }`. */
+  toJSON(): { traceEvents: TraceEvent[]; displayTimeUnit: "ms" } {
+    return { traceEvents: this.events(), displayTimeUnit: "ms" };
+  }
+}
@@ -9,6 +9,11 @@
  * @module types
  */
 
+import type { EncodedReply } from "./codec.js";
+import type { EmscriptenModuleFactory } from "./loader-core.js";
+import type { MemoryGovernor } from "./governor.js";
+import type { Tracer } from "./trace.js";
+
 /**
  * Redis-compatible reply value type.
  *
@@ -104,7 +109,8 @@ export type ReplyValue =
  *
  * @param args - Command arguments as binary-safe Buffers.
  *               First element is the command name (e.g., "GET", "SET").
- * @returns Redis-compatible reply value
+ * @returns Redis-compatible reply value, or an `EncodedReply` from a
+ *          `ReplyBuilder` to skip shape-based encoding
  * @throws Error to return an error reply to Lua
  *
  * @example
@@ -117,7 +123,7 @@ export type ReplyValue =
  * };
  * ```
  */
-export type RedisCallHandler = (args: Buffer[]) => ReplyValue;
+export type RedisCallHandler = (args: Buffer[]) => ReplyValue | EncodedReply;
 
 /**
  * Handler function for redis.log() invocations from Lua.
@@ -210,6 +216,12 @@ export type RedisProp =
  */
 export type RedisProps = Record<string, RedisProp>;
 
+/**
+ * Changes for `engine.updateRedisProps()`: entries add or replace members, and
+ * `null` removes one.
+ */
+export type RedisPropsDelta = Record<string, RedisProp | null>;
+
 /**
  * Resource limits for the Lua engine.
  *
@@ -238,6 +250,220 @@ export type EngineLimits = {
 
   /** Maximum argument size in bytes. Enforced by host before passing to WASM. */
   maxArgBytes?: number;
+
+  /**
+   * Maximum script source size in bytes, checked before parsing. This and the
+   * limits below apply whenever a script is compiled (`eval`, `scriptLoad`,
+   * `compileScript`, preloading, `loadstring`/`load` in a script); a violation
+   * is a load error, like a syntax error. `installScript` checks the function,
+   * constant and nesting limits on bytecode. Enforced by WASM runtime.
+   */
+  maxScriptBytes?: number;
+
+  /** Maximum functions a script defines, its main chunk included. */
+  maxScriptFunctions?: number;
+
+  /** Maximum constants (strings and numbers) across a script's functions. */
+  maxScriptConstants?: number;
+
+  /** Maximum depth of nested function definitions (0: no nested functions). */
+  maxScriptNesting?: number;
+
+  /**
+   * Parse-time budget in milliseconds. Fuel does not run while parsing; this is
+   * checked before each 4 KB of source the parser reads.
+   */
+  maxParseMs?: number;
+};
+
+/**
+ * Execution histogram for one script, accumulated across its evals. Only
+ * collected by profiling WASM builds (`npm run build:wasm:profile`).
+ */
+export type ScriptProfile = {
+  /** Number of evals folded into this profile. */
+  evals: number;
+
+  /** VM opcode name (e.g. `GETTABLE`) -> times executed. */
+  opcodes: Record<string, number>;
+
+  /** C function name (e.g. `redis.call`, `cjson.encode`) -> times called. */
+  cfunctions: Record<string, number>;
+};
+
+/**
+ * Time spent getting an engine ready, by phase, in milliseconds. Reported by
+ * `LuaWasmModule.timings` (load phases, then `initMs`/`warmupMs` once an engine
+ * is created) and `engine.getStartupTimings()` (adds `firstEvalMs`).
+ */
+export type StartupTimings = {
+  /** Importing the Emscripten JS glue. */
+  glueMs: number;
+
+  /** Reading (Node) or fetching (browser) the `.wasm`. ~0 with `wasmBytes`/`wasmModule`. */
+  wasmReadMs: number;
+
+  /** Compiling the WASM (baseline tier; optimized code is produced later). 0 with `wasmModule`. */
+  compileMs: number;
+
+  /** Instantiating the module and running the Emscripten runtime start-up. */
+  instantiateMs: number;
+
+  /** `init()` (creating the Lua state, loading the bundled libraries) and preloading `scripts`. */
+  initMs: number;
+
+  /** Running the `warmup` corpus. 0 without `warmup`. */
+  warmupMs: number;
+
+  /** The first eval after the engine was handed out; absent until it has run. */
+  firstEvalMs?: number;
+};
+
+/** Lua object types an {@link AllocationSnapshot} breaks live objects down by. */
+export type AllocationClass =
+  | "string"
+  | "table"
+  | "function"
+  | "proto"
+  | "userdata"
+  | "thread"
+  | "upvalue";
+
+/** Number and total size of objects. */
+export type AllocationCount = {
+  count: number;
+  bytes: number;
+};
+
+/**
+ * Lua heap usage attributed to one owner (a script sha, or the engine itself).
+ * Allocation counters run from the creation of the Lua state (load or
+ * `reset()`); live figures are as of the snapshot.
+ */
+export type AllocationStats = {
+  /** Bytes of Lua heap blocks this owner allocated that are still allocated. */
+  liveBytes: number;
+
+  /** Number of those blocks. */
+  liveBlocks: number;
+
+  /** Blocks allocated, including ones since freed. */
+  allocations: number;
+
+  /** Bytes allocated, including freed blocks and growth of reallocated ones. */
+  allocatedBytes: number;
+
+  /**
+   * Live objects by type. A table's array and hash parts count towards the
+   * table and its owner.
+   */
+  objects: Record<AllocationClass, AllocationCount>;
+
+  /** Reply buffers copied out of WASM memory for this owner's evals. */
+  replyBuffers: AllocationCount;
+
+  /** Encoded KEYS/ARGV buffers copied into WASM memory for this owner's evals. */
+  argBuffers: AllocationCount;
+};
+
+/**
+ * Lua heap usage by script and object type, from `engine.getAllocationSnapshot()`
+ * (requires {@link LoadOptions.trackAllocations}). Plain data, so it can be
+ * serialized with `JSON.stringify` and diffed against a later snapshot.
+ */
+export type AllocationSnapshot = {
+  /** Live bytes across all owners. */
+  liveBytes: number;
+
+  /**
+   * Everything allocated outside an eval: `init()`, the bundled libraries,
+   * host calls between evals, and evals past the per-engine script limit.
+   */
+  engine: AllocationStats;
+
+  /**
+   * Per script sha: allocated while the script was compiled, installed or
+   * running. Includes every script the engine has run since the state was
+   * created, even if nothing it allocated is still live.
+   */
+  scripts: Record<string, AllocationStats>;
+
+  /**
+   * Evals and installs of scripts that found no slot because the engine
+   * already tracks 1023 scripts (see {@link LoadOptions.trackAllocations}).
+   * Their allocations are counted in `engine`; nonzero means `scripts` is
+   * incomplete.
+   */
+  untrackedEvals: number;
+};
+
+/** Limits for one script cache namespace. Unset fields are unlimited. */
+export type ScriptCacheQuota = {
+  /** Bytecode bytes the namespace may hold. */
+  maxBytes?: number;
+  /** Scripts the namespace may hold. */
+  maxEntries?: number;
+};
+
+/** Script cache namespaces (see {@link LoadOptions.scriptCache}). */
+export type ScriptCacheOptions = {
+  /** Quota for every namespace without its own entry, the default `""` included. */
+  quota?: ScriptCacheQuota;
+  /** Quotas by namespace name. */
+  namespaces?: Record<string, ScriptCacheQuota>;
+};
+
+/** One namespace's usage and counters, from `engine.getScriptCacheStats()`. */
+export type ScriptCacheStats = ScriptCacheQuota & {
+  entries: number;
+  /** Bytecode bytes held. */
+  bytes: number;
+  /** `evalSha` calls that found the script in the namespace. */
+  hits: number;
+  /** `evalSha` calls that replied `NOSCRIPT`. */
+  misses: number;
+  /** `hits / (hits + misses)`, 0 before the first lookup. */
+  hitRate: number;
+  loads: number;
+  /** Scripts evicted for the quota or under memory pressure. */
+  evictions: number;
+};
+
+/** One engine's memory, from `engine.getMemoryUsage()`. */
+export type EngineMemoryUsage = {
+  /** Bytes the Lua allocator holds, cached scripts included; 0 while hibernated. */
+  luaHeapBytes: number;
+  /** Bytecode size of the scripts in the engine's script cache. */
+  scriptCacheBytes: number;
+  cachedScripts: number;
+  /** The WASM instance's linear memory. It grows with the heap and never shrinks. */
+  wasmMemoryBytes: number;
+  /** True once a governor closed the Lua state; the next eval rebuilds it. */
+  hibernated: boolean;
+  /** Time since the last eval. */
+  idleMs: number;
+};
+
+/**
+ * A script to preload into every engine's script cache (see
+ * {@link LoadOptions.scripts}): Lua source, or bytecode from
+ * `engine.compileScript()` with the sha of the source it was compiled from.
+ * Bytecode is only accepted from `compileScript` in the same process, sealed
+ * for that sha; raw or foreign bytecode is rejected (see `installScript`).
+ */
+export type PreloadScript =
+  | string
+  | Buffer
+  | Uint8Array
+  | { sha: string; bytecode: Buffer | Uint8Array };
+
+/**
+ * Persistent store for the compiled WASM module, keyed by the hex SHA-256 of
+ * the `.wasm` bytes (see {@link LoadOptions.wasmCache}).
+ */
+export type WasmModuleCache = {
+  get(key: string): Promise<WebAssembly.Module | undefined>;
+  put(key: string, module: WebAssembly.Module): Promise<void>;
 };
 
 /**
@@ -296,6 +522,15 @@ export type EngineOptions = {
   /** Optional pre-loaded WASM binary. Takes precedence over wasmPath. */
   wasmBytes?: Uint8Array;
 
+  /** Optional pre-compiled WASM module (see {@link LoadOptions.wasmModule}). */
+  wasmModule?: WebAssembly.Module;
+
+  /** Persistent compiled-module cache (see {@link LoadOptions.wasmCache}). */
+  wasmCache?: boolean | WasmModuleCache;
+
+  /** Pre-loaded Emscripten glue factory (see {@link LoadOptions.moduleFactory}). */
+  moduleFactory?: EmscriptenModuleFactory;
+
   /** Optional path to the Emscripten JS module. Uses bundled module if not provided. */
   modulePath?: string;
 
@@ -310,6 +545,38 @@ export type EngineOptions = {
 
   /** Per-flag compatibility overrides, merged over `profile` (or the default). */
   compat?: CompatOverrides;
+
+  /** More profiles evals can select with `useProfile` (see {@link LoadOptions.profiles}). */
+  profiles?: CompatProfile[];
+
+  /**
+   * Seed for a full-coverage string hash (see {@link LoadOptions.hashSeed}).
+   * Default: Lua's stock sampled hash.
+   */
+  hashSeed?: number;
+
+  /**
+   * Experimental per-eval region size in bytes (see {@link LoadOptions.evalArenaBytes}).
+   * Default: disabled.
+   */
+  evalArenaBytes?: number;
+  /** Scripts run before the engine is returned (see {@link LoadOptions.warmup}). */
+  warmup?: boolean | string[];
+
+  /** Scripts installed in the script cache at creation (see {@link LoadOptions.scripts}). */
+  scripts?: PreloadScript[];
+
+  /** Attribute Lua heap usage to scripts (see {@link LoadOptions.trackAllocations}). */
+  trackAllocations?: boolean;
+
+  /** Record eval lifecycle spans (see {@link LoadOptions.tracer}). */
+  tracer?: Tracer;
+
+  /** Register with a process-wide memory governor (see {@link LoadOptions.governor}). */
+  governor?: MemoryGovernor;
+
+  /** Per-namespace script cache quotas (see {@link LoadOptions.scriptCache}). */
+  scriptCache?: ScriptCacheOptions;
 };
 
 /**
@@ -335,6 +602,15 @@ export type StandaloneOptions = {
   /** Optional pre-loaded WASM binary. */
   wasmBytes?: Uint8Array;
 
+  /** Optional pre-compiled WASM module (see {@link LoadOptions.wasmModule}). */
+  wasmModule?: WebAssembly.Module;
+
+  /** Persistent compiled-module cache (see {@link LoadOptions.wasmCache}). */
+  wasmCache?: boolean | WasmModuleCache;
+
+  /** Pre-loaded Emscripten glue factory (see {@link LoadOptions.moduleFactory}). */
+  moduleFactory?: EmscriptenModuleFactory;
+
   /** Optional path to the Emscripten JS module. */
   modulePath?: string;
 
@@ -349,6 +625,38 @@ export type StandaloneOptions = {
 
   /** Per-flag compatibility overrides, merged over `profile` (or the default). */
   compat?: CompatOverrides;
+
+  /** More profiles evals can select with `useProfile` (see {@link LoadOptions.profiles}). */
+  profiles?: CompatProfile[];
+
+  /**
+   * Seed for a full-coverage string hash (see {@link LoadOptions.hashSeed}).
+   * Default: Lua's stock sampled hash.
+   */
+  hashSeed?: number;
+
+  /**
+   * Experimental per-eval region size in bytes (see {@link LoadOptions.evalArenaBytes}).
+   * Default: disabled.
+   */
+  evalArenaBytes?: number;
+  /** Scripts run before the engine is returned (see {@link LoadOptions.warmup}). */
+  warmup?: boolean | string[];
+
+  /** Scripts installed in the script cache at creation (see {@link LoadOptions.scripts}). */
+  scripts?: PreloadScript[];
+
+  /** Attribute Lua heap usage to scripts (see {@link LoadOptions.trackAllocations}). */
+  trackAllocations?: boolean;
+
+  /** Record eval lifecycle spans (see {@link LoadOptions.tracer}). */
+  tracer?: Tracer;
+
+  /** Register with a process-wide memory governor (see {@link LoadOptions.governor}). */
+  governor?: MemoryGovernor;
+
+  /** Per-namespace script cache quotas (see {@link LoadOptions.scriptCache}). */
+  scriptCache?: ScriptCacheOptions;
 };
 
 /**
@@ -373,6 +681,31 @@ export type LoadOptions = {
   /** Optional pre-loaded WASM binary. */
   wasmBytes?: Uint8Array;
 
+  /**
+   * Optional pre-compiled WASM module. Takes precedence over `wasmBytes` and
+   * `wasmPath` and skips compilation, so many engines (e.g. one per worker
+   * thread; modules can be posted to workers) share one compile.
+   */
+  wasmModule?: WebAssembly.Module;
+
+  /**
+   * Reuse the compiled module across page loads (or processes), keyed by the
+   * SHA-256 of the `.wasm` bytes. `true` stores it in IndexedDB where the
+   * global exists and the browser accepts modules there; otherwise it is a
+   * no-op, and the browser loader keeps compiling while streaming. A
+   * {@link WasmModuleCache} supplies the store. With a working cache the
+   * browser loader reads the whole response to hash it instead of compiling
+   * while streaming. Default: off.
+   */
+  wasmCache?: boolean | WasmModuleCache;
+
+  /**
+   * Already-loaded Emscripten glue factory; `modulePath` is then not imported.
+   * Lets environments without dynamic `import()` (Node startup snapshots, see
+   * `snapshot.ts`) load the engine.
+   */
+  moduleFactory?: EmscriptenModuleFactory;
+
   /** Optional path to the Emscripten JS module. */
   modulePath?: string;
 
@@ -387,4 +720,98 @@ export type LoadOptions = {
 
   /** Per-flag compatibility overrides, merged over `profile` (or the default). */
   compat?: CompatOverrides;
+
+  /**
+   * More profiles scripts can run under, selected per eval with
+   * `engine.useProfile()`. Each gets its own protected global environment,
+   * differing from the engine's only in `print`, `os` and `server`, built at
+   * init and on every reset; KEYS/ARGV handling, libraries and the script cache
+   * are shared, so clients emulating different versions can share one engine.
+   * Profiles not listed here are built on first use. Default: none.
+   */
+  profiles?: CompatProfile[];
+
+  /**
+   * Seed for a full-coverage string hash (u32). Lua 5.1 hashes at most ~32
+   * sampled bytes of a string, so long keys that differ only in skipped bytes
+   * collide in the string table and in table lookups. Setting a seed hashes
+   * every byte with HalfSipHash-1-3 keyed from the seed instead. Colliding keys
+   * cannot be crafted without knowing the seed, so pick it at random per process
+   * and keep it secret; at 32 bits it is a weaker key than full SipHash's.
+   * Changes `pairs()` iteration order.
+   * Default: Lua's stock sampled hash.
+   */
+  hashSeed?: number;
+
+  /**
+   * Experimental: size in bytes of a region that objects allocated during an
+   * eval are bump-allocated from. The GC is paused while a script runs. The
+   * region fills across evals; the eval that runs it out continues on the
+   * regular heap and ends with one full collection, which rewinds the region.
+   * An object that survives that collection (one a C function keeps) pins the
+   * region: evals use the regular heap until the object is freed.
+   * Default: disabled.
+   */
+  evalArenaBytes?: number;
+  /**
+   * Scripts run on each engine before `create()`/`createStandalone()` return,
+   * so the first real requests run on optimized code instead of the baseline
+   * tier. `true` runs a built-in corpus (recursion, string ops, tables, cjson,
+   * and host calls: `redis.pcall('PING')` and `redis.sha1hex`); an array runs
+   * those scripts instead. Each script runs several times. `redis.call` and
+   * `redis.pcall` reply `+OK` from a stub rather than reaching the host, evals
+   * publish no diagnostics events and are not attributed allocations, error
+   * replies are ignored, and profiles collected during warm-up are discarded.
+   * Default: off.
+   */
+  warmup?: boolean | string[];
+
+  /**
+   * Scripts compiled into the engine's script cache when it is created, ready
+   * for `evalSha` before the first request. Sources are cached under their
+   * SHA1; bytecode entries under the given sha, which must be the one
+   * `compileScript` in this process sealed them for: untrusted bytecode could
+   * corrupt the VM, so anything else fails to install. Creation throws listing
+   * every script that failed to compile or install. `engine.reset()`
+   * re-installs the set from its compiled form.
+   */
+  scripts?: PreloadScript[];
+
+  /**
+   * Attribute Lua heap usage to the script that allocated it, for
+   * `engine.getAllocationSnapshot()`. Every Lua heap block carries an 8-byte
+   * header recording its owner, and each eval makes two extra WASM calls to set
+   * it. The first 1023 distinct scripts since the Lua state was created get
+   * their own slot; later ones count towards the engine, and the snapshot's
+   * `untrackedEvals` says how often that happened. `reset()` frees the slots.
+   * Default: off.
+   */
+  trackAllocations?: boolean;
+
+  /**
+   * Records each eval's lifecycle (KEYS/ARGV encoding, compile, execution,
+   * host calls, reply encoding and decode) as Trace Event Format spans, for
+   * Perfetto or chrome://tracing. Warm-up evals are not traced. Can also be
+   * set later with `engine.setTracer()`. Default: none.
+   */
+  tracer?: Tracer;
+
+  /**
+   * A `MemoryGovernor` shared with other engines. The engine reports its Lua
+   * heap after each eval; past the governor's thresholds it may have cached
+   * scripts evicted, be garbage-collected or hibernated, and have evals refused
+   * with an `OOM` error. Can also be set later with
+   * `engine.setMemoryGovernor()`. Default: none.
+   */
+  governor?: MemoryGovernor;
+
+  /**
+   * Quotas for script cache namespaces. `scriptLoad`, `installScript`,
+   * `evalSha`, `scriptExists`, `scriptEvict` and `scriptFlush` take an optional
+   * namespace (e.g. a tenant id; default `""`). `evalSha` only finds scripts
+   * loaded into its namespace, and a namespace over its quota evicts its own
+   * least recently used scripts. Preloaded scripts are never evicted.
+   * Default: no quotas.
+   */
+  scriptCache?: ScriptCacheOptions;
 };
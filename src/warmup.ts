@@ -0,0 +1,76 @@
+/**
+ * @fileoverview Built-in warm-up corpus for the `warmup` load option.
+ *
+ * V8 compiles WASM with its baseline tier first and only re-compiles hot
+ * functions with the optimizing tier after they have run for a while. These
+ * scripts drive the interpreter paths production scripts hit most (calls and
+ * returns, string builtins, table access and sorting, cjson, the host
+ * `redis.*` bridge, KEYS/ARGV marshalling) so that happens before the engine
+ * serves. Each script only touches locals and leaves no state behind. During
+ * warm-up `redis.call`/`redis.pcall` are answered by a stub (`+OK`), never by
+ * the engine's host, and evals publish no diagnostics and own no allocations.
+ *
+ * @module warmup
+ */
+
+/** Times each warm-up script is evaluated. */
+export const WARMUP_ROUNDS = 10;
+
+/** One warm-up eval: a script plus the KEYS and ARGV it runs with. */
+export type WarmupEntry = {
+  script: string;
+  keys: string[];
+  args: string[];
+};
+
+export const WARMUP_CORPUS: WarmupEntry[] = [
+  {
+    // Recursion: CALL/RETURN, arithmetic, comparisons.
+    script:
+      "local function fib(n) if n < 2 then return n end return fib(n - 1) + fib(n - 2) end " +
+      "return fib(tonumber(ARGV[1]))",
+    keys: [],
+    args: ["16"],
+  },
+  {
+    // String ops: format, rep, concat, sub, upper, gsub, find.
+    script:
+      "local parts = {} " +
+      "for i = 1, 200 do parts[#parts + 1] = string.format('%d:%s', i, string.rep('x', i % 16)) end " +
+      "local s = table.concat(parts, ',') " +
+      "local _, n = string.gsub(s, 'x+', '') " +
+      "return {#s, string.upper(string.sub(s, 1, 32)), n, string.find(s, '199:', 1, true)}",
+    keys: [],
+    args: [],
+  },
+  {
+    // Tables: array and hash parts, sort with a Lua comparator, pairs/ipairs.
+    script:
+      "local rows = {} " +
+      "for i = 1, 300 do rows[i] = {id = i, name = 'k' .. i} end " +
+      "table.sort(rows, function(a, b) return a.id > b.id end) " +
+      "local sum = 0 for _, row in ipairs(rows) do sum = sum + row.id end " +
+      "local map = {} for i = 1, 200 do map['f' .. i] = i end " +
+      "local total = 0 for _, v in pairs(map) do total = total + v end " +
+      "return {sum, total, rows[1].name}",
+    keys: [],
+    args: [],
+  },
+  {
+    // cjson round trips over nested objects and arrays.
+    script:
+      "local doc = {id = 1, tags = {'a', 'b', 'c'}, nested = {x = 1.5, flags = {true, false}}} " +
+      "for i = 1, 20 do doc = cjson.decode(cjson.encode(doc)) end " +
+      "return cjson.encode(doc)",
+    keys: [],
+    args: [],
+  },
+  {
+    // Host bridge and KEYS/ARGV: redis.pcall, redis.sha1hex, reply conversion.
+    script:
+      "local r = redis.pcall('PING') " +
+      "return {KEYS[1], redis.sha1hex(ARGV[1]), type(r)}",
+    keys: ["warmup:key"],
+    args: ["warmup"],
+  },
+];
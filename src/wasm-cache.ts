@@ -0,0 +1,142 @@
+/**
+ * @fileoverview Persistent cache of the compiled WASM module.
+ *
+ * The key is the SHA-256 of the `.wasm` bytes via Web Crypto, and the default
+ * store is IndexedDB when the global exists. A `WasmModuleCache` can be passed instead, e.g. to back it
+ * with something else or to test it.
+ *
+ * Browsers differ in whether a `WebAssembly.Module` may be written to
+ * IndexedDB (Chromium and Firefox currently refuse). The IndexedDB cache
+ * probes this once by storing an empty module; if the browser refuses, or any
+ * later write is refused, the cache turns itself off for the rest of the page
+ * and the browser loader goes back to compileStreaming, whose own code cache,
+ * keyed by URL, still applies there.
+ *
+ * @module wasm-cache
+ */
+
+import type { StartupTimings, WasmModuleCache } from "./types.js";
+
+const DB_NAME = "lua-redis-wasm";
+const STORE = "modules";
+const PROBE_KEY = "probe";
+/** The smallest valid module: magic and version. */
+const EMPTY_MODULE = new Uint8Array([0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00]);
+
+/** A cache that can tell whether it is able to store modules at all. */
+type ProbedCache = WasmModuleCache & { usable(): Promise<boolean> };
+
+/** Hex SHA-256 of the WASM bytes, used as the cache key. */
+export async function wasmHash(bytes: Uint8Array): Promise<string> {
+  const digest = new Uint8Array(await crypto.subtle.digest("SHA-256", bytes));
+  return Array.from(digest, (b) => b.toString(16).padStart(2, "0")).join("");
+}
+
+function request<T>(req: IDBRequest<T>): Promise<T> {
+  return new Promise((resolve, reject) => {
+    req.onsuccess = () => resolve(req.result);
+    req.onerror = () => reject(req.error);
+  });
+}
+
+/**
+ * A {@link WasmModuleCache} over IndexedDB. Failures (no database, a refused
+ * write) are swallowed: a cache that cannot store only costs a compile.
+ */
+export function indexedDbCache(factory: IDBFactory, dbName = DB_NAME): WasmModuleCache {
+  let db: Promise<IDBDatabase> | null = null;
+  let probe: Promise<void> | null = null;
+  let disabled = false;
+  const open = () => {
+    db ??= new Promise((resolve, reject) => {
+      const req = factory.open(dbName, 1);
+      req.onupgradeneeded = () => req.result.createObjectStore(STORE);
+      req.onsuccess = () => resolve(req.result);
+      req.onerror = () => reject(req.error);
+    });
+    return db;
+  };
+  const cache: ProbedCache = {
+    usable() {
+      probe ??= (async () => {
+        try {
+          const store = (await open()).transaction(STORE, "readwrite").objectStore(STORE);
+          await request(store.put(new WebAssembly.Module(EMPTY_MODULE), PROBE_KEY));
+        } catch {
+          disabled = true;
+        }
+      })();
+      return probe.then(() => !disabled);
+    },
+    async get(key) {
+      if (disabled) {
+        return undefined;
+      }
+      try {
+        const store = (await open()).transaction(STORE, "readonly").objectStore(STORE);
+        const value = await request(store.get(key));
+        return value instanceof WebAssembly.Module ? value : undefined;
+      } catch {
+        return undefined;
+      }
+    },
+    async put(key, module) {
+      if (disabled) {
+        return;
+      }
+      try {
+        const store = (await open()).transaction(STORE, "readwrite").objectStore(STORE);
+        await request(store.put(module, key));
+      } catch {
+        disabled = true;
+      }
+    },
+  };
+  return cache;
+}
+
+/**
+ * False if `cache` cannot store modules (the IndexedDB cache in a browser that
+ * refuses them), so loading should not give up streaming compilation for it.
+ * Caches passed in by the caller are assumed to work.
+ */
+export function canStoreModules(cache: WasmModuleCache): Promise<boolean> {
+  return (cache as Partial<ProbedCache>).usable?.() ?? Promise.resolve(true);
+}
+
+let defaultCache: WasmModuleCache | undefined;
+
+/** Resolves the `wasmCache` option: `true` means IndexedDB where it exists. */
+export function resolveWasmCache(
+  option: boolean | WasmModuleCache | undefined,
+): WasmModuleCache | undefined {
+  if (!option) {
+    return undefined;
+  }
+  if (option === true) {
+    const factory = (globalThis as { indexedDB?: IDBFactory }).indexedDB;
+    defaultCache ??= factory && indexedDbCache(factory);
+    return defaultCache;
+  }
+  return option;
+}
+
+/**
+ * Returns the cached module for `bytes`, or compiles and stores it. Lookup
+ * and store time go to `timings.compileMs` along with the compile.
+ */
+export async function compileCached(
+  bytes: Uint8Array,
+  cache: WasmModuleCache,
+  timings: StartupTimings,
+): Promise<WebAssembly.Module> {
+  const start = performance.now();
+  const key = await wasmHash(bytes);
+  let module = await cache.get(key);
+  if (!module) {
+    module = await WebAssembly.compile(bytes);
+    await cache.put(key, module);
+  }
+  timings.compileMs = performance.now() - start;
+  return module;
+}
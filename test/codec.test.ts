@@ -9,6 +9,8 @@ import {
   decodeReply,
   encodeArgArray,
   encodeRedisProps,
+  decodeAllocationSnapshot,
+  decodeProfile,
   packPtrLen,
   unpackPtrLen
 } from "../src/codec.js";
@@ -522,6 +524,14 @@ test("encodeRedisProps: encodes a noop stub (returns null) with vtype none and n
   assert.equal(buf.length, k + 2); // no payload after vtype
 });
 
+test("encodeRedisProps: encodes a null delta entry as a field with vtype none", () => {
+  const buf = encodeRedisProps({ OLD: null });
+  const k = 4 + 4 + "OLD".length;
+  assert.equal(buf[k], 0); // kind field
+  assert.equal(buf[k + 1], 0); // vtype none
+  assert.equal(buf.length, k + 2);
+});
+
 test("encodeRedisProps: throws when an entry has neither value nor returns", () => {
   assert.throws(() => encodeRedisProps({ X: {} as never }), TypeError);
 });
@@ -532,3 +542,79 @@ test("encodeRedisProps: throws when an entry has both value and returns", () =>
     TypeError,
   );
 });
+
+// -----------------------------------------------------------------------------
+// decodeProfile tests
+// -----------------------------------------------------------------------------
+
+function profileSection(entries: Array<[string, bigint]>): Buffer {
+  const parts: Buffer[] = [];
+  const count = Buffer.alloc(4);
+  count.writeUInt32LE(entries.length, 0);
+  parts.push(count);
+  for (const [name, calls] of entries) {
+    const nameBuf = Buffer.from(name, "utf8");
+    const head = Buffer.alloc(4);
+    head.writeUInt32LE(nameBuf.length, 0);
+    const tail = Buffer.alloc(8);
+    tail.writeBigUInt64LE(calls, 0);
+    parts.push(head, nameBuf, tail);
+  }
+  return Buffer.concat(parts);
+}
+
+test("decodeProfile: reads opcode and C-function sections", () => {
+  const blob = Buffer.concat([
+    profileSection([["GETTABLE", 12n], ["CALL", 3n]]),
+    profileSection([["redis.call", 2n]]),
+  ]);
+  assert.deepEqual(decodeProfile(blob), {
+    opcodes: { GETTABLE: 12, CALL: 3 },
+    cfunctions: { "redis.call": 2 },
+  });
+});
+
+test("decodeProfile: empty sections", () => {
+  const blob = Buffer.concat([profileSection([]), profileSection([])]);
+  assert.deepEqual(decodeProfile(blob), { opcodes: {}, cfunctions: {} });
+});
+
+// -----------------------------------------------------------------------------
+// decodeAllocationSnapshot tests
+// -----------------------------------------------------------------------------
+
+function allocationEntry(owner: number, stats: bigint[], classes: Array<[bigint, bigint]>): Buffer {
+  const head = Buffer.alloc(4 + 8 * stats.length);
+  head.writeUInt32LE(owner, 0);
+  stats.forEach((value, i) => head.writeBigUInt64LE(value, 4 + 8 * i));
+  const objects = Buffer.alloc(16 * classes.length);
+  classes.forEach(([count, bytes], i) => {
+    objects.writeBigUInt64LE(count, 16 * i);
+    objects.writeBigUInt64LE(bytes, 16 * i + 8);
+  });
+  return Buffer.concat([head, objects]);
+}
+
+test("decodeAllocationSnapshot: reads owners, counters and object classes", () => {
+  const header = Buffer.alloc(8);
+  header.writeUInt32LE(2, 0);
+  header.writeUInt32LE(8, 4);
+  const classes: Array<[bigint, bigint]> = [[1n, 20n], [2n, 64n], [0n, 0n], [0n, 0n],
+    [0n, 0n], [0n, 0n], [3n, 48n], [9n, 9n]];
+  const blob = Buffer.concat([
+    header,
+    allocationEntry(0, [100n, 5n, 7n, 140n], classes),
+    allocationEntry(3, [0n, 0n, 4n, 32n], classes.map(() => [0n, 0n])),
+  ]);
+  const [engine, script] = decodeAllocationSnapshot(blob);
+  assert.deepEqual(
+    { ...engine, objects: undefined },
+    { owner: 0, liveBytes: 100, liveBlocks: 5, allocations: 7, allocatedBytes: 140, objects: undefined },
+  );
+  assert.deepEqual(engine.objects.string, { count: 1, bytes: 20 });
+  assert.deepEqual(engine.objects.upvalue, { count: 3, bytes: 48 });
+  assert.equal(Object.keys(engine.objects).length, 7);
+  assert.equal(script.owner, 3);
+  assert.equal(script.allocations, 4);
+  assert.deepEqual(script.objects.table, { count: 0, bytes: 0 });
+});
@@ -2,14 +2,25 @@
  * Comprehensive unit tests for LuaEngine.
  * Tests cover: basic eval, evalWithArgs, host callbacks, error handling, limits, and standalone mode.
  */
+import { createHash } from "node:crypto";
+import diagnosticsChannel from "node:diagnostics_channel";
 import fs from "node:fs/promises";
 import path from "node:path";
 import test from "node:test";
 import assert from "node:assert/strict";
-import { load, LuaWasmModule, LuaEngine } from "../src/index.js";
+import {
+  load,
+  compile,
+  LuaWasmModule,
+  LuaEngine,
+  ScriptCompiler,
+  WorkerPool,
+  DIAGNOSTICS_CHANNELS,
+} from "../src/index.js";
 import { LuaWasmEngine, makePropsHandler } from "../src/engine.js";
 import { encodeRedisProps } from "../src/codec.js";
-import type { ReplyValue, RedisHost } from "../src/types.js";
+import { sealBytecode } from "../src/helpers.js";
+import type { ReplyValue, RedisHost, ReplyErrorMeta } from "../src/types.js";
 import type { WasmExports } from "../src/loader-core.js";
 
 // Helper to resolve WASM path (checks dist/ first, then wasm/build/)
@@ -917,6 +928,102 @@ test("limits: small args pass validation", async () => {
   assert.ok(Buffer.isBuffer(result));
 });
 
+test("limits: maxFuel charges string.rep by bytes produced", async () => {
+  const module = await load({ limits: { maxFuel: 100000 } });
+  const engine = module.create(createTestHost());
+  const result = engine.eval("local s = string.rep('x', 5e7) return #s");
+  assert.ok(result && typeof result === "object" && "err" in result);
+  assert.ok((result as { err: Buffer }).err.toString().includes("Script killed by fuel limit"));
+  // Small calls stay well inside the budget.
+  assert.equal(engine.eval("return #string.rep('x', 1000)"), 1000);
+});
+
+test("limits: maxFuel charges cjson.encode and table.sort", async () => {
+  const module = await load({ limits: { maxFuel: 200000 } });
+  const engine = module.create(createTestHost());
+  // Built with string.rep-free table ops so the charge comes from encode itself.
+  const encode = engine.eval(`
+    local t = {}
+    local big = cjson.decode('"' .. ('y'):rep(1000) .. '"')
+    for i = 1, 20 do t[i] = big end
+    for _ = 1, 200 do cjson.encode(t) end
+    return 1
+  `);
+  assert.ok((encode as { err: Buffer }).err.toString().includes("Script killed by fuel limit"));
+  const sort = engine.eval("local t = {} for i = 1, 20000 do t[i] = -i end table.sort(t) return 1");
+  assert.ok((sort as { err: Buffer }).err.toString().includes("Script killed by fuel limit"));
+});
+
+test("limits: fuel wrappers keep argument errors naming the function", async () => {
+  const engine = (await load()).create(createTestHost());
+  const result = engine.eval("return string.rep()");
+  assert.ok((result as { err: Buffer }).err.toString().includes("bad argument #1 to 'rep'"));
+});
+
+test("limits: compile-time limits fail the load like a syntax error", async () => {
+  const engine = (await load({
+    limits: { maxScriptBytes: 200, maxScriptFunctions: 3, maxScriptConstants: 4, maxScriptNesting: 1 },
+  })).create(createTestHost());
+  const loadError = (script: string) => {
+    const reply = engine.eval(script) as { err: Buffer; code: Buffer; meta: ReplyErrorMeta };
+    assert.equal(reply.code.toString(), "ERR");
+    assert.equal(reply.meta.line, 1);
+    return reply.err.toString();
+  };
+  const big = `return '${"x".repeat(300)}'`;
+  assert.match(loadError(big), /of 309 bytes exceeds maxScriptBytes \(200\)/);
+  assert.match(
+    loadError("local f = function() end local g = function() end local h = function() end"),
+    /defines 4 functions, over maxScriptFunctions \(3\)/,
+  );
+  assert.match(loadError("return {'a', 'b', 'c', 'd', 'e'}"), /has 5 constants, over maxScriptConstants \(4\)/);
+  assert.match(
+    loadError("local f = function() return function() end end"),
+    /nests functions 2 deep, over maxScriptNesting \(1\)/,
+  );
+  assert.throws(() => engine.compileScript(big), /maxScriptBytes/);
+  assert.deepEqual(engine.eval("local f = function() return 'ok' end return f()"), Buffer.from("ok"));
+});
+
+test("limits: loadstring, load and installed bytecode are held to the load limits", async () => {
+  const wasmModule = await compile();
+  const engine = (await load({
+    wasmModule,
+    limits: { maxScriptBytes: 200, maxScriptFunctions: 3 },
+  })).create(createTestHost());
+  const many = "local f = function() end local g = function() end local h = function() end";
+  const viaLoadstring = "local f, err = loadstring(ARGV[1]) return {tostring(f), err}";
+  assert.deepEqual(engine.eval(viaLoadstring, [], [many]), [
+    Buffer.from("nil"),
+    Buffer.from("ERR script defines 4 functions, over maxScriptFunctions (3)"),
+  ]);
+  const [, tooBig] = engine.eval(viaLoadstring, [], [`return '${"x".repeat(300)}'`]) as Buffer[];
+  assert.match(tooBig.toString(), /exceeds maxScriptBytes \(200\)/);
+  const viaLoad =
+    "local done = false " +
+    "local f, err = load(function() if done then return nil end done = true return ARGV[1] end) " +
+    "return err";
+  assert.match((engine.eval(viaLoad, [], [many]) as Buffer).toString(), /over maxScriptFunctions/);
+  const [failedLoad, readerErr] = engine.eval(
+    "local f, err = load(function() error('reader broke') end) return {tostring(f), err}",
+  ) as Buffer[];
+  assert.equal(failedLoad.toString(), "nil");
+  assert.match(readerErr.toString(), /reader broke/);
+  assert.equal(engine.eval("return loadstring('return 1 + 1')()"), 2);
+
+  const sha = createHash("sha1").update(many).digest("hex");
+  const bytecode = (await load({ wasmModule })).createStandalone().compileScript(many);
+  assert.throws(() => engine.installScript(sha, bytecode), /over maxScriptFunctions \(3\)/);
+  assert.equal(engine.scriptExists(sha), false);
+});
+
+test("limits: maxParseMs stops the parser on large sources", async () => {
+  const engine = (await load({ limits: { maxParseMs: 1 } })).create(createTestHost());
+  const reply = engine.eval(`return 1${" + 1".repeat(1_000_000)}`) as { err: Buffer };
+  assert.match(reply.err.toString(), /parse exceeded maxParseMs \(1\)/);
+  assert.equal(engine.eval("return 1 + 1"), 2);
+});
+
 test("getLimits: returns configured limits", async () => {
   await resolveWasmPath();
   const limits = {
@@ -1059,6 +1166,49 @@ test("cjson: roundtrip", async () => {
   assert.equal(result, 42);
 });
 
+test("cjson: decode of a large document with escapes, unicode and literals", async () => {
+  const engine = (await load()).create(createTestHost());
+  const json =
+    '{"s":"a\\"b\\\\c\\n\\u00e9\\ud83d\\ude00/","n":[0,-1.5,1e21,3.25e-3],' +
+    '"t":true,"f":false,"z":null,"pad":"' + "x".repeat(100) + '"}';
+  const result = engine.evalWithArgs(
+    `local d = cjson.decode(ARGV[1])
+     return {d.s, tostring(d.n[2]), tostring(d.n[3]), tostring(d.n[4]),
+             tostring(d.z == cjson.null), tostring(d.t), tostring(d.f), #d.pad}`,
+    [],
+    [json],
+  );
+  assert.deepEqual(result, [
+    Buffer.from('a"b\\c\né😀/'),
+    Buffer.from("-1.5"),
+    Buffer.from("1e+21"),
+    Buffer.from("0.00325"),
+    Buffer.from("true"),
+    Buffer.from("true"),
+    Buffer.from("false"),
+    100,
+  ]);
+});
+
+test("cjson: decode errors on large malformed documents", async () => {
+  const engine = (await load()).create(createTestHost());
+  const json = '{"a":[1,2,3,,4],"pad":"' + "x".repeat(100) + '"}';
+  const result = engine.evalWithArgs("return cjson.decode(ARGV[1])", [], [json]);
+  assert.ok(result && typeof result === "object" && "err" in result);
+  assert.ok((result as { err: Buffer }).err.toString().includes("Expected"));
+});
+
+test("cjson: decode of deeply nested arrays", async () => {
+  const engine = (await load()).create(createTestHost());
+  const json = "[".repeat(100) + "7" + "]".repeat(100);
+  const result = engine.evalWithArgs(
+    "local v = cjson.decode(ARGV[1]) for _ = 1, 100 do v = v[1] end return v",
+    [],
+    [json],
+  );
+  assert.equal(result, 7);
+});
+
 // =============================================================================
 // cmsgpack library tests
 // =============================================================================
@@ -1108,6 +1258,67 @@ test("bit: operations", async () => {
   assert.equal(engine.eval("return bit.rshift(16, 2)"), 4);
 });
 
+// =============================================================================
+// redis.strbuf tests
+// =============================================================================
+
+test("redis.strbuf: appends strings and numbers and returns the assembled string", async () => {
+  const engine = (await load()).create(createTestHost());
+  const result = engine.eval(`
+    local b = redis.strbuf()
+    for i = 1, 3 do b:append("row", ","):append_number(i * 1.5):append("\\n") end
+    return b:tostring()
+  `);
+  assert.equal((result as Buffer).toString(), "row,1.5\nrow,3\nrow,4.5\n");
+});
+
+test("redis.strbuf: returning the builder yields a bulk reply", async () => {
+  const engine = (await load()).create(createTestHost());
+  const result = engine.eval("local b = redis.strbuf() b:append('a\\0b') return {b, #b}");
+  assert.deepEqual(result, [Buffer.from("a\0b"), 3]);
+});
+
+test("redis.strbuf: builder can be passed to redis.call", async () => {
+  let seen: Buffer[] = [];
+  const engine = (await load()).create(
+    createTestHost({
+      redisCall(args) {
+        seen = args;
+        return { ok: Buffer.from("OK") };
+      },
+    }),
+  );
+  engine.eval("local b = redis.strbuf() b:append('v', 1) return redis.call('SET', 'k', b)");
+  assert.deepEqual(seen.map((b) => b.toString()), ["SET", "k", "v1"]);
+});
+
+test("redis.strbuf: metatable is hidden and input is type-checked", async () => {
+  const engine = (await load()).create(createTestHost());
+  assert.deepEqual(engine.eval("return getmetatable(redis.strbuf())"), Buffer.from("redis.strbuf"));
+  const bad = engine.eval("redis.strbuf():append({})") as { err: Buffer };
+  assert.ok(bad && typeof bad === "object" && "err" in bad);
+});
+
+test("redis.strbuf: the buffer is Lua heap and the cap is a Lua error", async () => {
+  const engine = (await load()).create(createTestHost());
+  const grown = engine.eval(`
+    local chunk = string.rep('x', 4096)
+    local before = collectgarbage('count')
+    local b = redis.strbuf()
+    for i = 1, 256 do b:append(chunk) end
+    return math.floor(collectgarbage('count') - before)
+  `) as number;
+  assert.ok(grown >= 1024, `heap grew by ${grown} KB`);
+  const capped = engine.eval(`
+    local chunk = string.rep('x', 1048576)
+    local b = redis.strbuf()
+    for i = 1, 17 do b:append(chunk) end
+    return #b
+  `) as { err: Buffer };
+  assert.match(capped.err.toString(), /strbuf exceeds maximum size/);
+  assert.deepEqual(engine.eval("return redis.strbuf():append('ok'):tostring()"), Buffer.from("ok"));
+});
+
 // =============================================================================
 // Multiple script executions
 // =============================================================================
@@ -1342,6 +1553,25 @@ test("redisProps integration: makes injected props readonly under globals protec
   assert.ok(r && typeof r === "object" && "err" in r);
 });
 
+test("redisProps integration: updateRedisProps changes props live and keeps them across reset", async () => {
+  const engine = await LuaWasmEngine.create({
+    host: noopHost,
+    redisProps: { REDIS_VERSION: { value: "7.4.0" }, OLD: { value: 1 } },
+  });
+  const sha = engine.scriptLoad("return redis.REDIS_VERSION");
+  engine.updateRedisProps({ REDIS_VERSION: { value: "7.4.1" }, OLD: null });
+  assert.deepEqual(engine.evalSha(sha), Buffer.from("7.4.1"));
+  assert.deepEqual(engine.eval("return server.REDIS_VERSION"), Buffer.from("7.4.1"));
+  assert.equal(engine.eval("return redis.OLD"), null);
+  const r = engine.eval("redis.REDIS_VERSION = 'x' return 1") as { err: Buffer };
+  assert.ok(r && typeof r === "object" && "err" in r);
+
+  engine.reset();
+  assert.deepEqual(engine.eval("return redis.REDIS_VERSION"), Buffer.from("7.4.1"));
+  assert.equal(engine.eval("return redis.OLD"), null);
+  assert.throws(() => engine.updateRedisProps({ X: {} as never }), TypeError);
+});
+
 // =============================================================================
 // Compatibility profiles (print / os / server alias differ across versions)
 // =============================================================================
@@ -1403,3 +1633,488 @@ test("compat: default (no profile) keeps historical behavior", async () => {
   assert.equal(engine.eval("return server == redis"), 1);
   assertGlobalAbsent(engine, "print");
 });
+
+test("compat: useProfile switches globals per eval on one engine and script cache", async () => {
+  const module = await load({ profile: "redis-7.2", profiles: ["valkey-8.0"] });
+  const engine = module.create(createTestHost());
+  const sha = engine.scriptLoad(
+    "return {type(rawget(_G, 'os')), type(rawget(_G, 'server')), KEYS[1]}",
+  );
+  const types = () => engine.evalSha(sha, ["k"]);
+
+  assert.deepEqual(types(), [Buffer.from("nil"), Buffer.from("nil"), Buffer.from("k")]);
+  engine.useProfile("valkey-8.0");
+  assert.deepEqual(types(), [Buffer.from("table"), Buffer.from("table"), Buffer.from("k")]);
+  assert.equal(engine.eval("return server == redis"), 1);
+  assert.equal(engine.eval("return _G == loadstring('return _G')()"), 1);
+  assertGlobalAbsent(engine, "print");
+
+  engine.useProfile("redis-6.2"); // built on first use
+  assert.equal(engine.eval("return type(print)").toString(), "function");
+  assertGlobalAbsent(engine, "os");
+  const r = engine.eval("print = nil return 1") as { err: Buffer };
+  assert.ok(r && typeof r === "object" && "err" in r);
+
+  engine.reset();
+  assert.equal(engine.eval("return type(print)").toString(), "function");
+  engine.useProfile();
+  assertGlobalAbsent(engine, "print");
+  assertGlobalAbsent(engine, "server");
+});
+
+// =============================================================================
+// Seeded string hash (hashSeed)
+// =============================================================================
+
+test("hashSeed: long keys differing only in unsampled bytes stay distinct", async () => {
+  const module = await load({ hashSeed: 0x9e3779b9 });
+  const engine = module.create(createTestHost());
+  const prefix = "k".repeat(1000);
+  const args = Array.from({ length: 64 }, (_, i) => `${prefix}${String(i).padStart(4, "0")}`);
+  const result = engine.evalWithArgs(
+    `local t, n = {}, 0
+     for i = 1, #ARGV do t[ARGV[i]] = i end
+     for _, v in pairs(t) do n = n + 1 end
+     return {n, t[ARGV[17]], ARGV[5] == ARGV[5] .. ""}`,
+    [],
+    args,
+  );
+  assert.deepEqual(result, [64, 17, 1]);
+});
+
+test("hashSeed: library code runs unchanged under the seeded hash", async () => {
+  const module = await load({ hashSeed: 1 });
+  const engine = module.create(createTestHost());
+  assert.equal(engine.eval("return cjson.encode({a = 'x' .. string.rep('y', 40)})").toString(),
+    `{"a":"x${"y".repeat(40)}"}`);
+  assert.equal(engine.eval("return redis.sha1hex('')").toString(), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+});
+
+// =============================================================================
+// Experimental per-eval arena (evalArenaBytes)
+// =============================================================================
+
+test("evalArenaBytes: repeated evals see fresh state and correct results", async () => {
+  const module = await load({ evalArenaBytes: 1024 * 1024 });
+  const engine = module.create(createTestHost());
+  for (let i = 0; i < 50; i++) {
+    const result = engine.evalWithArgs(
+      "local t = {} for j = 1, 100 do t[j] = ARGV[1] .. j end return {#t, t[100], #KEYS}",
+      [`k${i}`],
+      [`v${i}-`],
+    );
+    assert.deepEqual(result, [100, Buffer.from(`v${i}-100`), 1]);
+  }
+  assert.equal(engine.eval("return #KEYS + #ARGV"), 0);
+});
+
+test("evalArenaBytes: scripts larger than the region fall back to the heap", async () => {
+  const module = await load({ evalArenaBytes: 16 * 1024 });
+  const engine = module.create(createTestHost());
+  const script = "local t = {} for i = 1, 20000 do t[i] = tostring(i) end return #table.concat(t)";
+  const expected = Array.from({ length: 20000 }, (_, i) => String(i + 1)).join("").length;
+  for (let i = 0; i < 3; i++) {
+    assert.equal(engine.eval(script), expected);
+  }
+});
+
+// =============================================================================
+// Startup timings and warm-up
+// =============================================================================
+
+test("timings: load phases, init and first eval are reported", async () => {
+  const module = await load();
+  const { glueMs, wasmReadMs, compileMs, instantiateMs } = module.timings;
+  for (const ms of [glueMs, wasmReadMs, compileMs, instantiateMs]) {
+    assert.ok(Number.isFinite(ms) && ms >= 0);
+  }
+  assert.ok(compileMs > 0);
+  const engine = module.createStandalone();
+  assert.ok(engine.getStartupTimings().initMs > 0);
+  assert.equal(engine.getStartupTimings().warmupMs, 0);
+  assert.equal(engine.getStartupTimings().firstEvalMs, undefined);
+  engine.eval("return 1");
+  const first = engine.getStartupTimings().firstEvalMs;
+  assert.ok(first !== undefined && first >= 0);
+  engine.eval("return 2");
+  assert.equal(engine.getStartupTimings().firstEvalMs, first);
+  assert.equal(module.timings.firstEvalMs, first);
+});
+
+test("timings: a precompiled wasmModule skips compilation", async () => {
+  const module = await load({ wasmModule: await compile() });
+  assert.ok(module.timings.compileMs < 1);
+});
+
+test("warmup: built-in corpus runs before the engine is returned, off the host", async () => {
+  const calls: string[] = [];
+  const host = createTestHost({
+    redisPcall(args) {
+      calls.push(args[0].toString());
+      return { ok: Buffer.from("PONG") };
+    },
+  });
+  const events: string[] = [];
+  const listeners = Object.entries(DIAGNOSTICS_CHANNELS).map(([name, channel]) => {
+    const listener = () => events.push(name);
+    diagnosticsChannel.subscribe(channel, listener);
+    return [channel, listener] as const;
+  });
+  try {
+    const engine = (await load({ warmup: true, trackAllocations: true })).create(host);
+    const timings = engine.getStartupTimings();
+    assert.ok(timings.warmupMs > 0);
+    assert.equal(timings.firstEvalMs, undefined);
+    assert.deepEqual(calls, []);
+    assert.deepEqual(events, []);
+    assert.deepEqual(engine.getAllocationSnapshot().scripts, {});
+    assert.equal(engine.getProfile().size, 0);
+    assert.deepEqual(engine.evalWithArgs("return KEYS[1]", ["k"]), Buffer.from("k"));
+    assert.deepEqual(engine.eval("return redis.pcall('PING')"), { ok: Buffer.from("PONG") });
+    assert.deepEqual(calls, ["PING"]);
+  } finally {
+    for (const [channel, listener] of listeners) {
+      diagnosticsChannel.unsubscribe(channel, listener);
+    }
+  }
+});
+
+test("warmup: custom scripts run and their errors are ignored", async () => {
+  const engine = (await load({ warmup: ["return 1", "error('boom')"] })).createStandalone();
+  assert.ok(engine.getStartupTimings().warmupMs > 0);
+  assert.equal(engine.eval("return 3"), 3);
+});
+
+// =============================================================================
+// Shared compiled module (compile / wasmModule)
+// =============================================================================
+
+test("wasmModule: engines instantiated from one compile are independent", async () => {
+  const wasmModule = await compile();
+  const a = (await load({ wasmModule })).createStandalone();
+  const b = (await load({ wasmModule })).createStandalone();
+  a.eval("x = 1");
+  assert.equal(a.eval("return x"), 1);
+  assert.equal(b.eval("return x"), null);
+});
+
+// =============================================================================
+// WorkerPool
+// =============================================================================
+
+test("WorkerPool: evaluates scripts on warm workers", async () => {
+  const pool = await WorkerPool.create({ minWorkers: 2, maxWorkers: 2 });
+  try {
+    assert.equal(pool.metrics().workers, 2);
+    const replies = await Promise.all(
+      Array.from({ length: 20 }, (_, i) => pool.evalWithArgs("return {KEYS[1], ARGV[1]}", [`k${i}`], [`v${i}`])),
+    );
+    replies.forEach((reply, i) => assert.deepEqual(reply, [Buffer.from(`k${i}`), Buffer.from(`v${i}`)]));
+    assert.deepEqual(await pool.eval("return redis.call('PING')"), {
+      err: Buffer.from("ERR redis.call is not available in standalone mode"),
+    });
+  } finally {
+    await pool.close();
+  }
+});
+
+test("WorkerPool: scales up under load and back down when idle", async () => {
+  const pool = await WorkerPool.create({
+    minWorkers: 1,
+    maxWorkers: 2,
+    scaling: { intervalMs: 50, idleTimeoutMs: 0 },
+  });
+  try {
+    const busy = "local x = 0 for i = 1, 3e5 do x = x + i end return x";
+    const deadline = Date.now() + 10_000;
+    while (pool.metrics().scaleUps === 0 && Date.now() < deadline) {
+      await Promise.all(Array.from({ length: 8 }, () => pool.eval(busy)));
+    }
+    const up = pool.metrics().decisions.find((d) => d.action === "up");
+    assert.ok(up, "expected a scale-up decision");
+    assert.equal(up.workers, 2);
+
+    while (pool.metrics().scaleDowns === 0 && Date.now() < deadline) {
+      await new Promise((resolve) => setTimeout(resolve, 50));
+    }
+    const metrics = pool.metrics();
+    assert.equal(metrics.decisions.at(-1)?.action, "down");
+    assert.ok(metrics.evals > 0);
+    assert.equal(await pool.eval("return 7"), 7);
+  } finally {
+    await pool.close();
+  }
+});
+
+// =============================================================================
+// Script cache (scriptLoad / installScript / evalSha / ScriptCompiler)
+// =============================================================================
+
+test("scriptLoad: evalSha runs the cached script with KEYS and ARGV", async () => {
+  const engine = (await load()).createStandalone();
+  const sha = engine.scriptLoad("return {KEYS[1], ARGV[1], #KEYS}");
+  assert.match(sha, /^[0-9a-f]{40}$/);
+  assert.ok(engine.scriptExists(sha.toUpperCase()));
+  assert.deepEqual(engine.evalSha(sha, ["k"], ["v"]), [Buffer.from("k"), Buffer.from("v"), 1]);
+  assert.deepEqual(engine.evalSha(sha.toUpperCase(), ["a", "b"]), [Buffer.from("a"), null, 2]);
+});
+
+test("evalSha: unknown or flushed scripts reply NOSCRIPT", async () => {
+  const engine = (await load()).createStandalone();
+  const noscript = {
+    err: Buffer.from("No matching script. Please use EVAL."),
+    code: Buffer.from("NOSCRIPT"),
+  };
+  assert.deepEqual(engine.evalSha("0".repeat(40)), noscript);
+  assert.deepEqual(engine.evalSha("not-a-sha"), noscript);
+  const sha = engine.scriptLoad("return 1");
+  engine.scriptFlush();
+  assert.equal(engine.scriptExists(sha), false);
+  assert.deepEqual(engine.evalSha(sha), noscript);
+});
+
+test("compileScript: syntax errors throw; bad bytecode is rejected", async () => {
+  const engine = (await load()).createStandalone();
+  assert.throws(() => engine.compileScript("return +"), /user_script/);
+  const sha = createHash("sha1").update("return 1").digest("hex");
+  const bytecode = engine.compileScript("return 1");
+  assert.throws(() => engine.installScript(sha, Buffer.from("return 1")), /not compiled by this process/);
+  assert.throws(() => engine.installScript(sha, bytecode.subarray(0, bytecode.length >> 1)), /not compiled/);
+  assert.throws(() => engine.installScript("a".repeat(40), bytecode), /not compiled by this process/);
+  assert.throws(() => engine.installScript("xyz", bytecode), /invalid script sha/);
+  // The VM still checks what passes the seal.
+  const sealed = sealBytecode(Buffer.from(sha), Buffer.from("return 1"));
+  assert.throws(() => engine.installScript(sha, sealed), /not a compiled script/);
+  engine.installScript(sha, bytecode);
+  assert.equal(engine.evalSha(sha), 1);
+});
+
+test("installScript: bytecode from one engine runs on another", async () => {
+  const wasmModule = await compile();
+  const compiler = (await load({ wasmModule })).createStandalone();
+  const serving = (await load({ wasmModule })).create(createTestHost());
+  const script = "redis.call('SET', KEYS[1], ARGV[1]) return redis.call('GET', KEYS[1])";
+  const sha = createHash("sha1").update(script).digest("hex");
+  serving.installScript(sha, compiler.compileScript(script));
+  assert.deepEqual(serving.evalSha(sha, ["k"], ["v"]), Buffer.from("value:k"));
+});
+
+test("ScriptCompiler: scripts are pending until installed in attached engines", async () => {
+  const compiler = await ScriptCompiler.create();
+  try {
+    const engine = (await load()).createStandalone();
+    compiler.attach(engine);
+    const sha = compiler.load("return ARGV[1] .. '!'");
+    assert.equal(compiler.status(sha), "pending");
+    assert.equal((engine.evalSha(sha) as { code: Buffer }).code.toString(), "NOSCRIPT");
+    await compiler.ready(sha);
+    assert.equal(compiler.status(sha), "ready");
+    assert.deepEqual(engine.evalSha(sha, [], ["hi"]), Buffer.from("hi!"));
+
+    const late = (await load()).createStandalone();
+    compiler.attach(late);
+    assert.deepEqual(late.evalSha(sha, [], ["x"]), Buffer.from("x!"));
+
+    const bad = compiler.load("return +");
+    await assert.rejects(compiler.ready(bad), /user_script/);
+    assert.equal(compiler.status(bad), "failed");
+  } finally {
+    await compiler.close();
+  }
+});
+
+test("ScriptCompiler: a script one engine refuses is installed in none", async () => {
+  const compiler = await ScriptCompiler.create();
+  try {
+    const roomy = (await load()).createStandalone();
+    const tight = (await load({ scriptCache: { quota: { maxBytes: 1 } } })).createStandalone();
+    compiler.attach(roomy);
+    compiler.attach(tight);
+    const sha = compiler.load("return 'too big for tight'");
+    await assert.rejects(compiler.ready(sha), /quota/);
+    assert.equal(compiler.status(sha), "failed");
+    assert.equal(roomy.scriptExists(sha), false);
+    assert.equal((roomy.evalSha(sha) as { code: Buffer }).code.toString(), "NOSCRIPT");
+  } finally {
+    await compiler.close();
+  }
+});
+
+// =============================================================================
+// Preloaded scripts (LoadOptions.scripts / reset)
+// =============================================================================
+
+test("scripts: sources and bytecode are installed at creation", async () => {
+  const bytecode = (await load()).createStandalone().compileScript("return 'from bytecode'");
+  const sha = createHash("sha1").update("return 'from bytecode'").digest("hex");
+  const engine = (await load({
+    scripts: ["return ARGV[1]", Buffer.from("return #KEYS"), { sha, bytecode }],
+  })).createStandalone();
+  const sourceSha = createHash("sha1").update("return ARGV[1]").digest("hex");
+  assert.deepEqual(engine.evalSha(sourceSha, [], ["x"]), Buffer.from("x"));
+  assert.ok(engine.scriptExists(createHash("sha1").update("return #KEYS").digest("hex")));
+  assert.deepEqual(engine.evalSha(sha), Buffer.from("from bytecode"));
+});
+
+test("scripts: creation reports every script that fails to compile", async () => {
+  const module = await load({ scripts: ["return 1", "return +", "local = 2"] });
+  assert.throws(() => module.createStandalone(), (err: Error) => {
+    assert.match(err.message, /2 preloaded script\(s\) failed/);
+    return true;
+  });
+});
+
+test("reset: clears state and re-installs preloaded scripts", async () => {
+  const source = "return redis.call('GET', KEYS[1])";
+  const preloaded = createHash("sha1").update(source).digest("hex");
+  const engine = (await load({ scripts: [source] })).create(createTestHost());
+  const [sha] = engine.preloadScripts(["return 'added'"]);
+  const extra = engine.scriptLoad("return 'not preloaded'");
+  engine.reset();
+  assert.deepEqual(engine.evalSha(preloaded, ["k"]), Buffer.from("value:k"));
+  assert.deepEqual(engine.evalSha(sha), Buffer.from("added"));
+  assert.equal(engine.scriptExists(extra), false);
+  assert.equal((engine.evalSha(extra) as { code: Buffer }).code.toString(), "NOSCRIPT");
+  assert.equal(engine.eval("return 1"), 1);
+});
+
+test("reset: a script preloaded twice is kept and re-installed once", async () => {
+  const engine = (await load()).createStandalone();
+  const source = "return 'twice'";
+  const sha = createHash("sha1").update(source).digest("hex");
+  engine.preloadScripts([source]);
+  assert.deepEqual(engine.preloadScripts([source, { sha, bytecode: engine.compileScript(source) }]), [sha, sha]);
+  const resets: Array<{ preloaded: number }> = [];
+  const listener = (message: unknown) => resets.push(message as { preloaded: number });
+  diagnosticsChannel.subscribe(DIAGNOSTICS_CHANNELS.reset, listener);
+  try {
+    engine.reset();
+  } finally {
+    diagnosticsChannel.unsubscribe(DIAGNOSTICS_CHANNELS.reset, listener);
+  }
+  assert.equal(resets[0].preloaded, 1);
+  assert.equal(engine.getMemoryUsage().cachedScripts, 1);
+  assert.deepEqual(engine.evalSha(sha), Buffer.from("twice"));
+});
+
+test("scripts: bytecode entries must carry the sha they were compiled for", async () => {
+  const bytecode = (await load()).createStandalone().compileScript("return 1");
+  const module = await load({ scripts: [{ sha: "b".repeat(40), bytecode }] });
+  assert.throws(() => module.createStandalone(), /not compiled by this process for this sha/);
+});
+
+// =============================================================================
+// Allocation tracking (trackAllocations)
+// =============================================================================
+
+test("trackAllocations: heap usage is attributed to scripts and object types", async () => {
+  const engine = (await load({ trackAllocations: true })).create(createTestHost());
+  const script = "local t = {} for i = 1, 200 do t[i] = ARGV[1] .. i end return #t";
+  const sha = createHash("sha1").update(script).digest("hex");
+  assert.equal(engine.evalWithArgs(script, ["k"], ["v"]), 200);
+  assert.equal(engine.evalWithArgs(script, ["k"], ["v"]), 200);
+  const cached = engine.scriptLoad(`return '${"x".repeat(500)}'`);
+
+  const snapshot = engine.getAllocationSnapshot();
+  const run = snapshot.scripts[sha];
+  assert.ok(run.allocations >= 400);
+  assert.ok(run.allocatedBytes > run.liveBytes);
+  assert.equal(run.argBuffers.count, 2);
+  assert.equal(run.replyBuffers.count, 2);
+  assert.ok(snapshot.scripts[cached].objects.proto.count >= 1);
+  assert.ok(snapshot.scripts[cached].objects.function.count >= 1);
+  assert.ok(snapshot.engine.objects.table.count > 0);
+  assert.ok(snapshot.engine.objects.function.count > 0);
+  assert.equal(
+    snapshot.liveBytes,
+    snapshot.engine.liveBytes +
+      Object.values(snapshot.scripts).reduce((sum, s) => sum + s.liveBytes, 0),
+  );
+  assert.doesNotThrow(() => JSON.stringify(snapshot));
+});
+
+test("trackAllocations: reset starts over; works with the eval arena", async () => {
+  const engine = (await load({ trackAllocations: true, evalArenaBytes: 64 * 1024 }))
+    .createStandalone();
+  for (let i = 0; i < 20; i++) {
+    assert.equal(engine.eval("local t = {} for i = 1, 100 do t[i] = {i} end return #t"), 100);
+  }
+  assert.equal(Object.keys(engine.getAllocationSnapshot().scripts).length, 1);
+  engine.reset();
+  const snapshot = engine.getAllocationSnapshot();
+  assert.deepEqual(snapshot.scripts, {});
+  assert.ok(snapshot.engine.liveBytes > 0);
+});
+
+test("trackAllocations: scripts past the slot limit are reported as untracked", async () => {
+  const engine = (await load({ trackAllocations: true })).createStandalone();
+  for (let i = 0; i < 1025; i++) {
+    assert.equal(engine.eval(`return ${i}`), i);
+  }
+  assert.equal(engine.eval("return 1024"), 1024);
+  const snapshot = engine.getAllocationSnapshot(false);
+  assert.equal(Object.keys(snapshot.scripts).length, 1023);
+  assert.equal(snapshot.untrackedEvals, 3);
+  engine.reset();
+  assert.equal(engine.getAllocationSnapshot(false).untrackedEvals, 0);
+});
+
+test("trackAllocations: snapshots require the option", async () => {
+  const engine = (await load()).createStandalone();
+  assert.throws(() => engine.getAllocationSnapshot(), /trackAllocations/);
+});
+
+// =============================================================================
+// node:diagnostics_channel events
+// =============================================================================
+
+test("diagnostics: evals, host calls, compiles and resets are published", async () => {
+  const events: Array<[string, Record<string, unknown>]> = [];
+  const listeners = Object.entries(DIAGNOSTICS_CHANNELS).map(([name, channel]) => {
+    const listener = (message: unknown) => {
+      events.push([name, message as Record<string, unknown>]);
+    };
+    diagnosticsChannel.subscribe(channel, listener);
+    return [channel, listener] as const;
+  });
+  try {
+    const engine = (await load({ limits: { maxFuel: 1_000_000 } })).create(createTestHost());
+    const script = "local v = redis.call('get', KEYS[1]) for i = 1, 5000 do end return v";
+    const sha = createHash("sha1").update(script).digest("hex");
+    assert.deepEqual(engine.evalWithArgs(script, ["k"], []), Buffer.from("value:k"));
+
+    const names = events.map(([name]) => name);
+    assert.deepEqual(names, ["evalStart", "hostCallStart", "hostCallEnd", "evalEnd"]);
+    const end = events[3][1];
+    assert.equal(end.engine, engine);
+    assert.equal(end.kind, "evalWithArgs");
+    assert.equal(end.sha, sha);
+    assert.equal(end.keys, 1);
+    assert.equal(end.error, false);
+    assert.ok((end.fuelUsed as number) >= 5000);
+    assert.ok((end.replyBytes as number) > 0);
+    const call = events[2][1];
+    assert.equal(call.command, "GET");
+    assert.equal(call.kind, "call");
+    assert.ok((call.durationMs as number) >= 0);
+
+    events.length = 0;
+    const loaded = engine.scriptLoad("return 1");
+    assert.deepEqual(engine.evalSha(loaded), 1);
+    assert.throws(() => engine.compileScript("return ("));
+    engine.reset();
+    assert.deepEqual(
+      events.map(([name]) => name),
+      ["compile", "evalStart", "evalEnd", "compile", "reset"],
+    );
+    assert.equal(events[0][1].sha, loaded);
+    assert.ok((events[0][1].bytecodeBytes as number) > 0);
+    assert.equal(events[2][1].kind, "evalSha");
+    assert.equal(events[3][1].bytecodeBytes, 0);
+    assert.match(events[3][1].error as string, /user_script/);
+  } finally {
+    for (const [channel, listener] of listeners) {
+      diagnosticsChannel.unsubscribe(channel, listener);
+    }
+  }
+});
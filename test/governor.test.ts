@@ -0,0 +1,173 @@
+/**
+ * Unit tests for governor.ts - the process-wide memory governor - with stub
+ * engines for the policy and real ones for eviction, hibernation and OOM.
+ */
+import test from "node:test";
+import assert from "node:assert/strict";
+import { load, MemoryGovernor, LuaEngine } from "../src/index.js";
+import type { EngineMemoryUsage } from "../src/types.js";
+
+/** Records the policy calls a governor makes. */
+class StubEngine {
+  calls: string[] = [];
+  constructor(
+    public heap: number,
+    public cache = 0,
+    public idleMs = 0,
+    public hibernated = false,
+  ) {}
+  getMemoryUsage(): EngineMemoryUsage {
+    return {
+      luaHeapBytes: this.heap,
+      scriptCacheBytes: this.cache,
+      cachedScripts: this.cache ? 1 : 0,
+      wasmMemoryBytes: 16 * 1024 * 1024,
+      hibernated: this.hibernated,
+      idleMs: this.idleMs,
+    };
+  }
+  shrinkScriptCache(): number {
+    if (this.cache) {
+      this.calls.push("shrink");
+    }
+    const dropped = this.cache;
+    this.cache = 0;
+    return dropped;
+  }
+  collectGarbage(): number {
+    this.calls.push("collect");
+    this.heap = Math.floor(this.heap / 2);
+    return this.heap;
+  }
+  hibernate(): number {
+    this.calls.push("hibernate");
+    const freed = this.heap;
+    this.heap = 0;
+    this.hibernated = true;
+    return freed;
+  }
+}
+
+function governed(governor: MemoryGovernor, ...engines: StubEngine[]): StubEngine[] {
+  for (const engine of engines) {
+    governor.register(engine as unknown as LuaEngine);
+  }
+  return engines;
+}
+
+test("MemoryGovernor: below the first threshold nothing happens", () => {
+  const governor = new MemoryGovernor({ limitBytes: 1000 });
+  const [a, b] = governed(governor, new StubEngine(200, 50), new StubEngine(300));
+  const usage = governor.enforce();
+  assert.deepEqual([a.calls, b.calls], [[], []]);
+  assert.equal(usage.luaHeapBytes, 500);
+  assert.equal(usage.scriptCacheBytes, 50);
+  assert.equal(usage.wasmMemoryBytes, 32 * 1024 * 1024);
+  assert.equal(usage.engines, 2);
+  assert.equal(usage.rejecting, false);
+});
+
+test("MemoryGovernor: steps apply in order, largest engines first, until under", () => {
+  const governor = new MemoryGovernor({ limitBytes: 1000, idleMs: 1000 });
+  const [small, large, busy] = governed(
+    governor,
+    new StubEngine(200, 10, 5000),
+    new StubEngine(500, 100, 5000),
+    new StubEngine(300, 0, 0),
+  );
+  // 1000 -> shrink large (900) and small (890) -> collect large (640) -> under 0.8.
+  const usage = governor.enforce();
+  assert.deepEqual(large.calls, ["shrink", "collect"]);
+  assert.deepEqual(small.calls, ["shrink"]);
+  assert.deepEqual(busy.calls, []);
+  assert.equal(usage.actions.shrinkCache, 2);
+  assert.equal(usage.actions.collect, 1);
+  assert.equal(usage.actions.hibernate, 0);
+  assert.equal(usage.rejecting, false);
+});
+
+test("MemoryGovernor: idle engines hibernate; busy ones are never hibernated", () => {
+  const governor = new MemoryGovernor({ limitBytes: 1000, collectAt: 2, idleMs: 1000 });
+  const [idle, busy] = governed(governor, new StubEngine(400, 0, 5000), new StubEngine(600));
+  const usage = governor.enforce();
+  assert.deepEqual(idle.calls, ["hibernate"]);
+  assert.deepEqual(busy.calls, []);
+  assert.equal(usage.hibernated, 1);
+  assert.equal(usage.luaHeapBytes, 600);
+});
+
+test("MemoryGovernor: over rejectAt evals are refused until usage drops", () => {
+  const governor = new MemoryGovernor({
+    limitBytes: 1000,
+    collectAt: 2,
+    hibernateAt: 2,
+    enforceIntervalMs: 0,
+  });
+  const [engine] = governed(governor, new StubEngine(1200));
+  governor.report(engine as unknown as LuaEngine, 1200);
+  assert.equal(governor.admit(), false);
+  engine.heap = 100;
+  assert.equal(governor.admit(), true);
+  assert.equal(governor.usage().actions.reject, 1);
+});
+
+test("MemoryGovernor: reports update the total; unregistered engines drop out", () => {
+  const governor = new MemoryGovernor({ limitBytes: 1000 });
+  const [a, b] = governed(governor, new StubEngine(100, 50), new StubEngine(100));
+  a.heap = 900;
+  governor.report(a as unknown as LuaEngine, 900);
+  assert.deepEqual(a.calls, ["shrink", "collect"]);
+  governor.unregister(b as unknown as LuaEngine);
+  assert.equal(governor.usage().engines, 1);
+  assert.throws(() => new MemoryGovernor({ limitBytes: 0 }), /limitBytes/);
+});
+
+test("engine memory: usage, cache eviction keeps preloaded scripts", async () => {
+  const engine = (await load()).createStandalone();
+  const [preloaded] = engine.preloadScripts(["return 'preloaded'"]);
+  const loaded = engine.scriptLoad("return 'loaded'");
+  const usage = engine.getMemoryUsage();
+  assert.ok(usage.luaHeapBytes > 0);
+  assert.ok(usage.scriptCacheBytes > 0);
+  assert.equal(usage.cachedScripts, 2);
+  assert.ok(usage.wasmMemoryBytes >= usage.luaHeapBytes);
+  assert.equal(usage.hibernated, false);
+
+  assert.ok(engine.shrinkScriptCache() > 0);
+  assert.equal(engine.scriptExists(preloaded), true);
+  assert.equal(engine.scriptExists(loaded), false);
+  assert.deepEqual(engine.evalSha(preloaded), Buffer.from("preloaded"));
+  const noscript = engine.evalSha(loaded) as { code: Buffer };
+  assert.equal(noscript.code.toString(), "NOSCRIPT");
+  assert.ok(engine.collectGarbage() > 0);
+});
+
+test("engine memory: hibernation frees the heap; the next eval rebuilds the state", async () => {
+  const engine = (await load()).createStandalone();
+  const sha = engine.preloadScripts(["return 'preloaded'"])[0];
+  const loaded = engine.scriptLoad(`return '${"x".repeat(100_000)}'`);
+  const before = engine.getMemoryUsage().luaHeapBytes;
+  assert.ok(before > 100_000);
+  assert.equal(engine.hibernate(), before);
+  assert.equal(engine.getMemoryUsage().luaHeapBytes, 0);
+  assert.equal(engine.getMemoryUsage().hibernated, true);
+  assert.equal(engine.hibernate(), 0);
+
+  assert.equal(engine.eval("return 1"), 1);
+  assert.equal(engine.getMemoryUsage().hibernated, false);
+  assert.ok(engine.getMemoryUsage().luaHeapBytes < before);
+  assert.deepEqual(engine.evalSha(sha), Buffer.from("preloaded"));
+  assert.equal((engine.evalSha(loaded) as { code: Buffer }).code.toString(), "NOSCRIPT");
+});
+
+test("engine memory: a governed engine refuses evals with OOM past the limit", async () => {
+  const governor = new MemoryGovernor({ limitBytes: 1, enforceIntervalMs: 0 });
+  const engine = (await load({ governor })).createStandalone();
+  assert.equal(engine.eval("return 1"), 1);
+  const reply = engine.eval("return 1") as { err: Buffer; code: Buffer };
+  assert.equal(reply.code.toString(), "OOM");
+  assert.match(reply.err.toString(), /maxmemory/);
+  engine.setMemoryGovernor(null);
+  assert.equal(engine.eval("return 1"), 1);
+  assert.equal(governor.usage().engines, 0);
+});
@@ -0,0 +1,201 @@
+/**
+ * Browser loader tests, run in Node against a local static server: streaming
+ * compilation for `application/wasm` responses, the byte fallback for other
+ * content types, and the persistent module cache.
+ */
+
+import fs from "node:fs/promises";
+import http from "node:http";
+import path from "node:path";
+import { pathToFileURL } from "node:url";
+import test from "node:test";
+import assert from "node:assert/strict";
+import { load } from "../src/index.js";
+import { compileWasm, loadModule } from "../src/loader.browser.js";
+import { indexedDbCache, wasmHash } from "../src/wasm-cache.js";
+import type { WasmModuleCache } from "../src/types.js";
+
+async function resolveBuildFile(file: string): Promise<string> {
+  const candidates = [
+    path.resolve(process.cwd(), `dist/${file}`),
+    path.resolve(process.cwd(), `wasm/build/${file}`)
+  ];
+  for (const candidate of candidates) {
+    try {
+      await fs.access(candidate);
+      return candidate;
+    } catch {
+      continue;
+    }
+  }
+  throw new Error(`${file} not found. Checked: ${candidates.join(", ")}`);
+}
+
+/** Serves the wasm as `/wasm` (application/wasm) and `/bin` (octet-stream). */
+async function serveWasm(): Promise<{ base: string; bytes: Buffer; close: () => Promise<void> }> {
+  const bytes = await fs.readFile(await resolveBuildFile("redis_lua.wasm"));
+  const server = http.createServer((req, res) => {
+    const type = req.url === "/wasm" ? "application/wasm" : "application/octet-stream";
+    res.writeHead(req.url === "/missing" ? 404 : 200, { "content-type": type });
+    res.end(req.url === "/missing" ? "" : bytes);
+  });
+  await new Promise<void>((resolve) => server.listen(0, "127.0.0.1", resolve));
+  const { port } = server.address() as { port: number };
+  return {
+    base: `http://127.0.0.1:${port}`,
+    bytes,
+    close: () => new Promise((resolve) => server.close(() => resolve())),
+  };
+}
+
+/** Counts calls to WebAssembly.compileStreaming while `fn` runs. */
+async function countStreaming<T>(fn: () => Promise<T>): Promise<{ result: T; calls: number }> {
+  const original = WebAssembly.compileStreaming;
+  let calls = 0;
+  WebAssembly.compileStreaming = (source) => {
+    calls++;
+    return original(source);
+  };
+  try {
+    return { result: await fn(), calls };
+  } finally {
+    WebAssembly.compileStreaming = original;
+  }
+}
+
+function memoryCache(): WasmModuleCache & { gets: number; puts: number; keys: string[] } {
+  const store = new Map<string, WebAssembly.Module>();
+  const cache = {
+    gets: 0,
+    puts: 0,
+    keys: [] as string[],
+    async get(key: string) {
+      cache.gets++;
+      return store.get(key);
+    },
+    async put(key: string, module: WebAssembly.Module) {
+      cache.puts++;
+      cache.keys.push(key);
+      store.set(key, module);
+    },
+  };
+  return cache;
+}
+
+test("browser loader: application/wasm compiles while streaming", async () => {
+  const server = await serveWasm();
+  try {
+    const { result: wasmModule, calls } = await countStreaming(() =>
+      compileWasm({ wasmPath: `${server.base}/wasm` }),
+    );
+    assert.equal(calls, 1);
+    const engine = (await load({ wasmModule })).createStandalone();
+    assert.equal(engine.eval("return 6 * 7"), 42);
+  } finally {
+    await server.close();
+  }
+});
+
+test("browser loader: other content types fall back to compiling bytes", async () => {
+  const server = await serveWasm();
+  try {
+    const { result, calls } = await countStreaming(() =>
+      compileWasm({ wasmPath: `${server.base}/bin` }),
+    );
+    assert.equal(calls, 0);
+    assert.ok(result instanceof WebAssembly.Module);
+    await assert.rejects(compileWasm({ wasmPath: `${server.base}/missing` }), /404/);
+  } finally {
+    await server.close();
+  }
+});
+
+test("browser loader: loadModule reports fetch and streaming compile time", async () => {
+  const server = await serveWasm();
+  try {
+    const modulePath = pathToFileURL(await resolveBuildFile("redis_lua.mjs")).href;
+    const { exports, timings } = await loadModule(
+      { wasmPath: `${server.base}/wasm`, modulePath },
+      {},
+    );
+    assert.equal(typeof exports._init, "function");
+    assert.ok(timings.glueMs > 0);
+    assert.ok(timings.compileMs > 0);
+    assert.ok(timings.instantiateMs > 0);
+  } finally {
+    await server.close();
+  }
+});
+
+test("wasmCache: the second load reuses the module stored under the wasm hash", async () => {
+  const server = await serveWasm();
+  try {
+    const cache = memoryCache();
+    const first = await compileWasm({ wasmPath: `${server.base}/wasm`, wasmCache: cache });
+    assert.deepEqual(cache.keys, [await wasmHash(server.bytes)]);
+    const { result: second, calls } = await countStreaming(() =>
+      compileWasm({ wasmPath: `${server.base}/wasm`, wasmCache: cache }),
+    );
+    assert.equal(calls, 0);
+    assert.equal(second, first);
+    assert.equal(cache.puts, 1);
+    assert.equal(cache.gets, 2);
+  } finally {
+    await server.close();
+  }
+});
+
+/** An IndexedDB stand-in whose store refuses modules, like Chromium's and Firefox's. */
+function refusingIndexedDb(): IDBFactory & { puts: number } {
+  const fire = (result: unknown) => {
+    const req: { result: unknown; onsuccess?: () => void } = { result };
+    queueMicrotask(() => req.onsuccess?.());
+    return req;
+  };
+  const factory = {
+    puts: 0,
+    open: () => fire(db),
+  };
+  const store = {
+    get: () => fire(undefined),
+    put: () => {
+      factory.puts++;
+      throw new DOMException("The object can not be cloned.", "DataCloneError");
+    },
+  };
+  const db = { transaction: () => ({ objectStore: () => store }) };
+  return factory as unknown as IDBFactory & { puts: number };
+}
+
+test("wasmCache: a store that refuses modules leaves streaming compilation on", async () => {
+  const server = await serveWasm();
+  try {
+    const idb = refusingIndexedDb();
+    const cache = indexedDbCache(idb);
+    for (let i = 0; i < 2; i++) {
+      const { result, calls } = await countStreaming(() =>
+        compileWasm({ wasmPath: `${server.base}/wasm`, wasmCache: cache }),
+      );
+      assert.equal(calls, 1);
+      assert.ok(result instanceof WebAssembly.Module);
+    }
+    assert.equal(idb.puts, 1);
+  } finally {
+    await server.close();
+  }
+});
+
+test("wasmCache: also applies to the Node loader and to wasmBytes", async () => {
+  const cache = memoryCache();
+  const wasmPath = await resolveBuildFile("redis_lua.wasm");
+  const a = (await load({ wasmBytes: await fs.readFile(wasmPath), wasmCache: cache })).createStandalone();
+  const b = (await load({ wasmPath, wasmCache: cache })).createStandalone();
+  assert.equal(cache.puts, 1);
+  assert.equal(a.eval("return 1"), 1);
+  assert.equal(b.eval("return 2"), 2);
+});
+
+test("wasmCache: true without IndexedDB is a no-op", async () => {
+  const engine = (await load({ wasmCache: true })).createStandalone();
+  assert.deepEqual(engine.eval("return 'ok'"), Buffer.from("ok"));
+});
@@ -0,0 +1,101 @@
+/**
+ * Unit tests for reply.ts - the ReplyBuilder - and hosts returning its
+ * EncodedReply.
+ */
+import test from "node:test";
+import assert from "node:assert/strict";
+import { load, ReplyBuilder, EncodedReply } from "../src/index.js";
+import { encodeReplyValue } from "../src/codec.js";
+import type { RedisHost, ReplyValue } from "../src/types.js";
+
+function same(built: EncodedReply, value: ReplyValue): void {
+  assert.deepEqual(built.bytes, encodeReplyValue(value));
+}
+
+test("ReplyBuilder: scalars match encodeReplyValue", () => {
+  const b = new ReplyBuilder();
+  same(b.null().finish(), null);
+  same(b.int(42).finish(), 42);
+  same(b.int(-1).finish(), -1);
+  same(b.int(-(2 ** 40) - 7).finish(), -(2 ** 40) - 7);
+  same(b.int(9007199254740993n).finish(), 9007199254740993n);
+  same(b.bulk("héllo").finish(), Buffer.from("héllo"));
+  same(b.bulk(new Uint8Array([0, 1, 2])).finish(), Buffer.from([0, 1, 2]));
+  same(b.status("OK").finish(), { ok: Buffer.from("OK") });
+  same(b.error("no such key").finish(), { err: Buffer.from("no such key") });
+  same(
+    b.error("wrong kind", "WRONGTYPE").finish(),
+    { err: Buffer.from("wrong kind"), code: Buffer.from("WRONGTYPE") },
+  );
+  same(b.bool(true).finish(), true);
+  same(b.double(1.5).finish(), { double: 1.5 });
+  same(b.bigNumber("123456789012345678901").finish(), {
+    big_number: Buffer.from("123456789012345678901"),
+  });
+  same(b.verbatim("txt", "body").finish(), {
+    verbatim_string: { format: Buffer.from("txt"), string: Buffer.from("body") },
+  });
+  assert.throws(() => b.int(1.5));
+});
+
+test("ReplyBuilder: aggregates, nesting and growth", () => {
+  const b = new ReplyBuilder(16);
+  b.array(3).int(1).array(2).bulk("a").null().map(1).status("k").set(1).bool(false);
+  same(b.finish(), [
+    1,
+    [Buffer.from("a"), null],
+    { map: [[{ ok: Buffer.from("k") }, { set: [false] }]] },
+  ]);
+
+  const big = Buffer.alloc(10_000, 7);
+  b.array(2).bulk(big).value([5, Buffer.from("x")]);
+  assert.equal(b.length, 5 + 5 + big.length + encodeReplyValue([5, Buffer.from("x")]).length);
+  same(b.finish(), [big, [5, Buffer.from("x")]]);
+  assert.equal(b.length, 0);
+});
+
+test("ReplyBuilder: a writer that throws leaves the reply as it was", () => {
+  const b = new ReplyBuilder();
+  b.array(1);
+  assert.throws(() => b.int(1.5), RangeError);
+  assert.throws(() => b.int(2n ** 63n), RangeError);
+  assert.throws(() => b.array(-1), RangeError);
+  assert.throws(() => b.map(0.5), RangeError);
+  assert.equal(b.length, 5);
+  same(b.int(7).finish(), [7]);
+});
+
+test("EncodedReply: encoded as is; isError reads the tag", () => {
+  const reply = new ReplyBuilder().error("boom").finish();
+  assert.equal(encodeReplyValue(reply), reply.bytes);
+  assert.equal(reply.isError, true);
+  assert.equal(new ReplyBuilder().int(1).finish().isError, false);
+});
+
+test("engine: hosts can return EncodedReply from redis.call and redis.pcall", async () => {
+  const builder = new ReplyBuilder();
+  const host: RedisHost = {
+    redisCall(args) {
+      const n = Number(args[1]?.toString() ?? "0");
+      builder.array(n);
+      for (let i = 1; i <= n; i++) {
+        builder.bulk(`m${i}`);
+      }
+      return builder.finish();
+    },
+    redisPcall() {
+      return builder.error("nope", "WRONGTYPE").finish();
+    },
+    log() {},
+  };
+  const engine = (await load()).create(host);
+  assert.deepEqual(engine.eval("return redis.call('SMEMBERS', 3)"), [
+    Buffer.from("m1"),
+    Buffer.from("m2"),
+    Buffer.from("m3"),
+  ]);
+  assert.deepEqual(
+    engine.eval("return redis.pcall('GET', 'k')['err']"),
+    Buffer.from("WRONGTYPE nope"),
+  );
+});
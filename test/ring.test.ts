@@ -0,0 +1,194 @@
+/**
+ * Unit tests for ring.ts - SharedArrayBuffer submission/completion ring.
+ *
+ * Producer and consumer share one thread here: submit() publishes its request
+ * synchronously before awaiting, so serveOnce() can pick it up right after.
+ */
+import test from "node:test";
+import assert from "node:assert/strict";
+import { createRing, RingConsumer, RingProducer } from "../src/ring.js";
+import type { RingHandler } from "../src/ring.js";
+import type { ReplyValue } from "../src/types.js";
+
+const echo: RingHandler = (script, keys, args) => [script, keys.length, ...args];
+
+// Atomics.waitAsync wakeups settle on a later task, so a request published by a
+// woken producer shows up after a few turns of the event loop.
+async function serveEventually(consumer: RingConsumer, handler: RingHandler): Promise<void> {
+  for (let attempt = 0; attempt < 100; attempt++) {
+    if (consumer.serveOnce(handler, 0)) {
+      return;
+    }
+    await new Promise((resolve) => setTimeout(resolve, 1));
+  }
+  assert.fail("no request arrived");
+}
+
+// -----------------------------------------------------------------------------
+// createRing tests
+// -----------------------------------------------------------------------------
+
+test("createRing: rejects a slot count that is not a power of two", () => {
+  assert.throws(() => createRing({ slots: 3 }), RangeError);
+  assert.throws(() => createRing({ slots: 1 }), RangeError);
+});
+
+test("createRing: rejects tiny or unaligned slots", () => {
+  assert.throws(() => createRing({ slotBytes: 32 }), RangeError);
+  assert.throws(() => createRing({ slotBytes: 100 }), RangeError);
+});
+
+// -----------------------------------------------------------------------------
+// submit / serveOnce tests
+// -----------------------------------------------------------------------------
+
+test("ring: round-trips script, KEYS and ARGV", async () => {
+  const ring = createRing({ slots: 4, slotBytes: 256 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+
+  const pending = producer.submit("return 1", ["k1", "k2"], ["a\x00b"]);
+  assert.equal(consumer.serveOnce(echo, 0), true);
+  assert.deepEqual(await pending, [
+    Buffer.from("return 1"),
+    2,
+    Buffer.from("a\x00b")
+  ]);
+});
+
+test("ring: serveOnce times out on an empty ring", () => {
+  const consumer = new RingConsumer(createRing({ slots: 2, slotBytes: 64 }));
+  assert.equal(consumer.serveOnce(echo, 0), false);
+});
+
+test("ring: handler errors become error replies", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 128 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+
+  const pending = producer.submit("x");
+  consumer.serveOnce(() => {
+    throw new Error("ERR boom");
+  }, 0);
+  assert.deepEqual(await pending, { err: Buffer.from("ERR boom") });
+});
+
+test("ring: oversized request throws RangeError", async () => {
+  const producer = new RingProducer(createRing({ slots: 2, slotBytes: 64 }));
+  await assert.rejects(producer.submit("x".repeat(100)), RangeError);
+});
+
+test("ring: oversized reply becomes an error reply", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 64 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+
+  const pending = producer.submit("x");
+  consumer.serveOnce(() => Buffer.alloc(200), 0);
+  assert.deepEqual(await pending, { err: Buffer.from("ERR reply exceeds ring slot size") });
+});
+
+test("ring: serves in-flight submissions in order and wraps around", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 128 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+  const handler: RingHandler = (script) => ({ ok: script });
+
+  for (let lap = 0; lap < 3; lap++) {
+    const a = producer.submit(`a${lap}`);
+    const b = producer.submit(`b${lap}`);
+    assert.equal(consumer.serveOnce(handler, 0), true);
+    assert.equal(consumer.serveOnce(handler, 0), true);
+    assert.deepEqual(await Promise.all([a, b]), [
+      { ok: Buffer.from(`a${lap}`) },
+      { ok: Buffer.from(`b${lap}`) }
+    ]);
+  }
+});
+
+test("ring: submit waits for a free slot when the ring is full", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 128 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+  const handler: RingHandler = (script) => script;
+
+  const first = producer.submit("first");
+  const second = producer.submit("second");
+  const third = producer.submit("third");
+  assert.equal(consumer.serveOnce(handler, 0), true);
+  assert.equal(consumer.serveOnce(handler, 0), true);
+  assert.equal(consumer.serveOnce(handler, 0), false);
+  assert.deepEqual(await first, Buffer.from("first"));
+  // Releasing `first` wakes `third`, which claims the freed slot.
+  await serveEventually(consumer, handler);
+  assert.deepEqual(await Promise.all([second, third]), [
+    Buffer.from("second"),
+    Buffer.from("third")
+  ]);
+});
+
+test("ring: close stops an idle consumer", () => {
+  const ring = createRing({ slots: 2, slotBytes: 64 });
+  new RingProducer(ring).close();
+  const consumer = new RingConsumer(ring);
+  assert.equal(consumer.closed, true);
+  assert.equal(consumer.serveOnce(echo), false);
+  const seen: ReplyValue[] = [];
+  consumer.serve((script) => {
+    seen.push(script);
+    return null;
+  });
+  assert.deepEqual(seen, []);
+});
+
+test("ring: submissions after close throw, including producers waiting for a slot", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 128 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+
+  const first = producer.submit("first");
+  const second = producer.submit("second");
+  const waiting = producer.submit("third");
+  producer.close();
+  await assert.rejects(waiting, /ring is closed/);
+  await assert.rejects(producer.submit("late"), /ring is closed/);
+  assert.throws(() => producer.submitSync("late"), /ring is closed/);
+  // Requests submitted before close still drain.
+  consumer.serve((script) => script);
+  assert.deepEqual(await Promise.all([first, second]), [
+    Buffer.from("first"),
+    Buffer.from("second")
+  ]);
+});
+
+test("ring: fail completes a ticket whose consumer died, and frees its slot", async () => {
+  const ring = createRing({ slots: 2, slotBytes: 128 });
+  const producer = new RingProducer(ring);
+  const consumer = new RingConsumer(ring);
+
+  const pending = producer.submit("lost");
+  let ticket = -1;
+  // Dies before taking the ticket: it stays queued and fail() leaves it alone.
+  assert.throws(() =>
+    consumer.serveOnce(echo, 0, (claimed) => {
+      ticket = claimed;
+      throw new Error("worker died");
+    }),
+  );
+  assert.equal(producer.fail(ticket, "ERR worker exited"), false);
+  // Dies after taking it: an error whose message cannot be read escapes
+  // serveOnce between the claim and the reply.
+  const dying: RingHandler = () => {
+    throw { toString: () => { throw new Error("worker died"); } };
+  };
+  assert.throws(() => consumer.serveOnce(dying, 0, (claimed) => (ticket = claimed)));
+  assert.equal(producer.fail(ticket, "ERR worker exited"), true);
+  assert.deepEqual(await pending, { err: Buffer.from("ERR worker exited") });
+  assert.equal(producer.fail(ticket, "ERR worker exited"), false);
+
+  for (let i = 0; i < 2; i++) {
+    const next = producer.submit(`next${i}`);
+    assert.equal(consumer.serveOnce((script) => script, 0), true);
+    assert.deepEqual(await next, Buffer.from(`next${i}`));
+  }
+});
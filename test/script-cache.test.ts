@@ -0,0 +1,165 @@
+/**
+ * Unit tests for script-cache.ts - namespaced script cache bookkeeping - and
+ * engines with per-namespace quotas.
+ */
+import test from "node:test";
+import assert from "node:assert/strict";
+import { load } from "../src/index.js";
+import { ScriptNamespaces } from "../src/script-cache.js";
+import { sealBytecode } from "../src/helpers.js";
+
+const sha = (c: string) => c.repeat(40);
+
+test("ScriptNamespaces: a namespace over quota evicts its own LRU scripts", () => {
+  const cache = new ScriptNamespaces({ namespaces: { a: { maxEntries: 2 }, b: { maxBytes: 100 } } });
+  assert.deepEqual(cache.add("a", sha("1"), 10), []);
+  assert.deepEqual(cache.add("a", sha("2"), 10), []);
+  assert.deepEqual(cache.add("b", sha("3"), 60), []);
+  assert.equal(cache.lookup("a", sha("1")), true);
+  assert.deepEqual(cache.add("a", sha("4"), 10), [sha("2")]);
+  assert.deepEqual(cache.add("b", sha("5"), 60), [sha("3")]);
+  assert.equal(cache.has("a", sha("1")), true);
+  assert.equal(cache.has("a", sha("2")), false);
+  assert.equal(cache.has("b", sha("5")), true);
+  assert.throws(() => cache.checkFits("b", 101), /exceeds the 100-byte quota of namespace 'b'/);
+  cache.checkFits("a", 10_000);
+
+  const stats = cache.stats();
+  assert.equal(stats.a.entries, 2);
+  assert.equal(stats.a.evictions, 1);
+  assert.equal(stats.a.maxEntries, 2);
+  assert.equal(stats.b.bytes, 60);
+  assert.equal(stats.b.maxBytes, 100);
+});
+
+test("ScriptNamespaces: shared scripts leave the VM with their last namespace", () => {
+  const cache = new ScriptNamespaces({ quota: { maxEntries: 1 } });
+  cache.add("a", sha("1"), 10);
+  cache.add("b", sha("1"), 10);
+  assert.deepEqual(cache.add("a", sha("2"), 10), []);
+  assert.equal(cache.has("b", sha("1")), true);
+  assert.deepEqual(cache.flush("b"), [sha("1")]);
+  assert.deepEqual(cache.flush("missing"), []);
+});
+
+test("ScriptNamespaces: remove drops one script, pinned or not", () => {
+  const cache = new ScriptNamespaces();
+  cache.add("", sha("1"), 10);
+  cache.pin(sha("1"));
+  cache.add("a", sha("1"), 10);
+  assert.deepEqual(cache.remove("", sha("1")), []);
+  assert.equal(cache.has("", sha("1")), false);
+  assert.deepEqual(cache.remove("a", sha("1")), [sha("1")]);
+  assert.deepEqual(cache.remove("a", sha("1")), []);
+});
+
+test("ScriptNamespaces: pinned scripts survive quotas and shrinking", () => {
+  const cache = new ScriptNamespaces({ quota: { maxEntries: 1 } });
+  cache.add("", sha("1"), 10);
+  cache.pin(sha("1"));
+  assert.deepEqual(cache.add("", sha("2"), 10), []);
+  assert.deepEqual(cache.add("t", sha("3"), 10), []);
+  assert.deepEqual(cache.shrink().sort(), [sha("2"), sha("3")]);
+  assert.equal(cache.has("", sha("1")), true);
+  // The pin is the default namespace's; another tenant's copy is evictable.
+  cache.add("t", sha("1"), 10);
+  assert.deepEqual(cache.add("t", sha("4"), 10), []);
+  assert.equal(cache.has("t", sha("1")), false);
+  cache.add("t", sha("1"), 10);
+  assert.deepEqual(cache.shrink(), []);
+  assert.equal(cache.has("t", sha("1")), false);
+  assert.equal(cache.has("", sha("1")), true);
+  cache.clear();
+  assert.equal(cache.has("", sha("1")), false);
+  assert.equal(cache.stats()[""].loads, 2);
+});
+
+test("ScriptNamespaces: heldElsewhere sees other namespaces only", () => {
+  const cache = new ScriptNamespaces();
+  cache.add("a", sha("1"), 10);
+  assert.equal(cache.heldElsewhere("a", sha("1")), false);
+  assert.equal(cache.heldElsewhere("b", sha("1")), true);
+  cache.add("b", sha("1"), 10);
+  assert.equal(cache.heldElsewhere("a", sha("1")), true);
+  cache.flush("b");
+  assert.equal(cache.heldElsewhere("a", sha("1")), false);
+  assert.equal(cache.heldElsewhere("a", sha("2")), false);
+});
+
+test("ScriptNamespaces: lookups count hits and misses per namespace", () => {
+  const cache = new ScriptNamespaces();
+  cache.add("a", sha("1"), 10);
+  cache.lookup("a", sha("1"));
+  cache.lookup("a", sha("1"));
+  cache.lookup("a", sha("2"));
+  cache.lookup("b", sha("1"));
+  const stats = cache.stats();
+  assert.deepEqual([stats.a.hits, stats.a.misses], [2, 1]);
+  assert.equal(stats.a.hitRate, 2 / 3);
+  assert.deepEqual([stats.b.hits, stats.b.misses, stats.b.hitRate], [0, 1, 0]);
+  assert.equal(stats.a.maxBytes, undefined);
+});
+
+test("engine: namespaces isolate evalSha, quotas and flushes", async () => {
+  const engine = (await load({
+    scriptCache: { namespaces: { small: { maxEntries: 1 } } },
+  })).createStandalone();
+  const [preloaded] = engine.preloadScripts(["return 'preloaded'"]);
+  const one = engine.scriptLoad("return 1", "small");
+  const two = engine.scriptLoad("return 2", "big");
+  engine.scriptLoad("return 2", "small");
+
+  assert.equal(engine.scriptExists(one, "small"), false);
+  assert.equal(engine.scriptExists(two, "small"), true);
+  assert.equal(engine.scriptExists(two), false);
+  assert.equal((engine.evalSha(one, [], [], "small") as { code: Buffer }).code.toString(), "NOSCRIPT");
+  assert.equal((engine.evalSha(preloaded, [], [], "big") as { code: Buffer }).code.toString(), "NOSCRIPT");
+  assert.equal(engine.evalSha(two, [], [], "big"), 2);
+  assert.deepEqual(engine.evalSha(preloaded), Buffer.from("preloaded"));
+  assert.equal(engine.getMemoryUsage().cachedScripts, 2);
+
+  engine.scriptFlush("small");
+  assert.equal(engine.evalSha(two, [], [], "big"), 2);
+  engine.scriptFlush("big");
+  assert.equal(engine.getMemoryUsage().cachedScripts, 1);
+
+  const stats = engine.getScriptCacheStats();
+  assert.equal(stats.small.evictions, 1);
+  assert.deepEqual([stats.small.hits, stats.small.misses], [0, 1]);
+  assert.deepEqual([stats.big.hits, stats.big.misses], [2, 1]);
+  assert.equal(stats[""].entries, 1);
+});
+
+test("engine: a sha another namespace holds cannot be replaced with other bytecode", async () => {
+  const engine = (await load()).createStandalone();
+  const victim = engine.scriptLoad("return 'a'", "a");
+  const bytes = engine.getScriptCacheStats().a.bytes;
+  const other = engine.compileScript("return 'b' .. 'b'");
+  const forged = sealBytecode(Buffer.from(victim), other.subarray(0, other.length - 20));
+  assert.throws(() => engine.installScript(victim, forged, "b"), /different bytecode in another namespace/);
+  assert.deepEqual(engine.evalSha(victim, [], [], "a"), Buffer.from("a"));
+
+  // The same bytecode is shared, and sizes stay consistent across namespaces.
+  engine.scriptLoad("return 'a'", "b");
+  assert.equal(engine.getScriptCacheStats().b.bytes, bytes);
+  assert.equal(engine.getMemoryUsage().scriptCacheBytes, bytes);
+  // Without another holder, a namespace may replace its own entry.
+  engine.scriptFlush("b");
+  engine.installScript(victim, forged, "a");
+  assert.deepEqual(engine.evalSha(victim, [], [], "a"), Buffer.from("bb"));
+  assert.equal(engine.getScriptCacheStats().a.bytes, other.length - 20);
+});
+
+test("engine: preloaded scripts are pinned only in the default namespace", async () => {
+  const engine = (await load({
+    scriptCache: { namespaces: { t: { maxEntries: 1 } } },
+  })).createStandalone();
+  const [preloaded] = engine.preloadScripts(["return 'preloaded'"]);
+  engine.scriptLoad("return 'preloaded'", "t");
+  engine.scriptLoad("return 1", "t");
+  assert.equal(engine.scriptExists(preloaded, "t"), false);
+  engine.scriptLoad("return 'preloaded'", "t");
+  engine.shrinkScriptCache();
+  assert.equal(engine.scriptExists(preloaded, "t"), false);
+  assert.deepEqual(engine.evalSha(preloaded), Buffer.from("preloaded"));
+});
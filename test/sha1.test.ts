@@ -1,7 +1,7 @@
 import { test } from "node:test";
 import assert from "node:assert";
-import { createHash } from "node:crypto";
-import { sha1Hex } from "../src/sha1.js";
+import { createHash, createHmac } from "node:crypto";
+import { hmacSha1, sha1Hex } from "../src/sha1.js";
 
 function nodeSha1(data: Uint8Array): string {
   return createHash("sha1").update(data).digest("hex");
@@ -27,3 +27,12 @@ test("sha1Hex matches node:crypto across sizes incl. block boundaries", () => {
     assert.strictEqual(sha1Hex(data), nodeSha1(data), `len ${len}`);
   }
 });
+
+test("hmacSha1 matches node:crypto for short and long keys", () => {
+  const message = new TextEncoder().encode("what do ya want for nothing?");
+  for (const keyLen of [0, 4, 20, 64, 65, 80]) {
+    const key = new Uint8Array(keyLen).fill(0xaa);
+    const expected = createHmac("sha1", key).update(message).digest("hex");
+    assert.strictEqual(Buffer.from(hmacSha1(key, message)).toString("hex"), expected, `key ${keyLen}`);
+  }
+});
@@ -0,0 +1,64 @@
+/**
+ * Node startup-snapshot tests. The end-to-end test builds a snapshot from the
+ * CommonJS bundle, so it only runs after `npm run build` (dist/ present).
+ */
+
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { spawnSync } from "node:child_process";
+import test from "node:test";
+import assert from "node:assert/strict";
+import { prepareSnapshot, snapshotEngine } from "../src/index.js";
+
+const bundle = path.resolve(process.cwd(), "dist/index.node.cjs");
+const built = fs.existsSync(bundle) && fs.existsSync(path.resolve(process.cwd(), "dist/redis_lua.cjs"));
+
+test("snapshot: prepareSnapshot only runs while building a snapshot", () => {
+  assert.throws(() => prepareSnapshot(), /--build-snapshot/);
+});
+
+test("snapshot: snapshotEngine needs a prepared snapshot", async () => {
+  await assert.rejects(snapshotEngine(), /prepareSnapshot/);
+});
+
+test("snapshot: a process started from the snapshot gets a ready engine", { skip: !built && "dist/ not built" }, () => {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "lua-snapshot-"));
+  const entry = path.join(dir, "entry.js");
+  const blob = path.join(dir, "snapshot.blob");
+  // Snapshot entries are single scripts that may only require builtins, so the
+  // bundle is evaluated from source the way a bundler would inline it.
+  fs.writeFileSync(
+    entry,
+    `
+const v8 = require("node:v8");
+const vm = require("node:vm");
+const fs = require("node:fs");
+const filename = ${JSON.stringify(bundle)};
+const lib = { exports: {} };
+vm.compileFunction(fs.readFileSync(filename, "utf8"),
+  ["module", "exports", "require", "__filename", "__dirname"], { filename })(
+  lib, lib.exports, require, filename, ${JSON.stringify(path.dirname(bundle))});
+lib.exports.prepareSnapshot();
+v8.startupSnapshot.setDeserializeMainFunction(async () => {
+  const engine = await lib.exports.snapshotEngine();
+  const reply = engine.eval("return 6 * 7");
+  process.stdout.write(JSON.stringify({ reply, timings: engine.getStartupTimings() }));
+});
+`,
+  );
+  try {
+    const build = spawnSync(process.execPath, ["--snapshot-blob", blob, "--build-snapshot", entry], {
+      encoding: "utf8",
+    });
+    assert.equal(build.status, 0, build.stderr);
+    const run = spawnSync(process.execPath, ["--snapshot-blob", blob], { encoding: "utf8" });
+    assert.equal(run.status, 0, run.stderr);
+    const { reply, timings } = JSON.parse(run.stdout);
+    assert.equal(reply, 42);
+    assert.equal(timings.wasmReadMs, 0);
+    assert.ok(timings.initMs > 0);
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+});
@@ -0,0 +1,100 @@
+/**
+ * Unit tests for trace.ts - the bounded Trace Event Format buffer - and the
+ * spans an engine records into it.
+ */
+import test from "node:test";
+import assert from "node:assert/strict";
+import { load, Tracer } from "../src/index.js";
+import type { RedisHost } from "../src/types.js";
+
+const host: RedisHost = {
+  redisCall(args) {
+    return Buffer.from(`value:${args[1]?.toString() ?? ""}`);
+  },
+  redisPcall(args) {
+    return this.redisCall(args);
+  },
+  log() {},
+};
+
+test("Tracer: records complete events in microseconds", () => {
+  const tracer = new Tracer({ pid: 7, tid: 3 });
+  tracer.span("EVAL", "eval", 1.5, 2, { sha: "abc" });
+  assert.deepEqual(tracer.events(), [
+    {
+      name: "EVAL", cat: "eval", ph: "X", ts: 1500, dur: 500, pid: 7, tid: 3,
+      args: { sha: "abc" },
+    },
+  ]);
+});
+
+test("Tracer: a full ring overwrites the oldest events and counts them", () => {
+  const tracer = new Tracer({ capacity: 3 });
+  for (let i = 0; i < 5; i++) {
+    tracer.span(`e${i}`, "js", i, i + 1);
+  }
+  assert.deepEqual(tracer.events().map((e) => e.name), ["e2", "e3", "e4"]);
+  assert.equal(tracer.dropped, 2);
+  tracer.clear();
+  assert.deepEqual(tracer.events(), []);
+  assert.equal(tracer.dropped, 0);
+});
+
+test("Tracer: JSON.stringify yields the trace file format", () => {
+  const tracer = new Tracer();
+  tracer.span("x", "js", 0, 1);
+  const file = JSON.parse(JSON.stringify(tracer));
+  assert.equal(file.displayTimeUnit, "ms");
+  assert.equal(file.traceEvents.length, 1);
+});
+
+test("engine tracing: eval phases and host calls nest inside the eval span", async () => {
+  const tracer = new Tracer();
+  const engine = (await load({ tracer })).create(host);
+  assert.equal(engine.getTracer(), tracer);
+  const reply = engine.evalWithArgs("return redis.call('GET', KEYS[1])", ["k"], []);
+  assert.deepEqual(reply, Buffer.from("value:k"));
+
+  const events = tracer.events();
+  const byName = new Map(events.map((e) => [e.name, e]));
+  const evalSpan = byName.get("EVAL")!;
+  assert.equal(evalSpan.args?.keys, 1);
+  for (const name of ["encode args", "wasm", "set KEYS/ARGV", "compile", "execute",
+    "encode reply", "decode reply", "redis.call"]) {
+    const span = byName.get(name);
+    assert.ok(span, `missing ${name}`);
+    assert.ok(span.ts >= evalSpan.ts && span.ts + span.dur <= evalSpan.ts + evalSpan.dur + 1,
+      `${name} is outside the eval span`);
+  }
+  const call = byName.get("redis.call")!;
+  const execute = byName.get("execute")!;
+  assert.ok(call.ts >= execute.ts && call.ts + call.dur <= execute.ts + execute.dur + 1);
+  assert.equal(call.args?.command, "GET");
+  assert.ok(Number(call.args?.replyBytes) > 0);
+});
+
+test("engine tracing: compile errors stop at the phase that failed; null detaches", async () => {
+  const tracer = new Tracer();
+  const engine = (await load()).createStandalone();
+  assert.equal(engine.getTracer(), null);
+  engine.setTracer(tracer);
+  engine.eval("return +");
+  const names = tracer.events().map((e) => e.name);
+  assert.ok(names.includes("set KEYS/ARGV"));
+  assert.ok(!names.includes("execute"));
+  engine.setTracer(null);
+  engine.eval("return 1");
+  assert.equal(tracer.events().length, names.length);
+});
+
+test("engine tracing: evalSha records an EVALSHA span with its sha", async () => {
+  const tracer = new Tracer();
+  const engine = (await load({ tracer })).create(host);
+  const sha = engine.scriptLoad("return redis.call('GET', KEYS[1])");
+  assert.deepEqual(engine.evalSha(sha, ["k"], ["a"]), Buffer.from("value:k"));
+  const span = tracer.events().find((e) => e.name === "EVALSHA");
+  assert.ok(span);
+  assert.equal(span.args?.sha, sha);
+  assert.equal(span.args?.keys, 1);
+  assert.ok(tracer.events().some((e) => e.name === "execute"));
+});
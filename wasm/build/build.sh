@@ -17,8 +17,27 @@ fi
 
 REDIS_LUA_DEPS="$ROOT_DIR/vendor/redis/deps/lua/src"
 REDIS_SRC="$ROOT_DIR/vendor/redis/src"
+
+# COMPACT_TVALUE=1 (experimental) builds the VM with 4-byte-aligned lua_Number,
+# which packs TValue into 12 bytes instead of 16 on wasm32. Only luaconf.h
+# changes, but the Lua sources include it by relative path, so the build works
+# on a patched copy of the tree.
+COMPACT_FLAGS=""
+if [ "${COMPACT_TVALUE:-0}" = "1" ]; then
+  COMPACT_DIR="$OUT_DIR/lua-compact"
+  rm -rf "$COMPACT_DIR"
+  cp -R "$REDIS_LUA_DEPS" "$COMPACT_DIR"
+  sed -E -i 's/^#define[[:space:]]+LUA_NUMBER[[:space:]]+double[[:space:]]*$/typedef double __attribute__((aligned(4))) lua_CompactNumber;\n#define LUA_NUMBER\tlua_CompactNumber/' \
+    "$COMPACT_DIR/luaconf.h"
+  if ! grep -q "lua_CompactNumber" "$COMPACT_DIR/luaconf.h"; then
+    echo "COMPACT_TVALUE: LUA_NUMBER definition not found in luaconf.h"
+    exit 1
+  fi
+  REDIS_LUA_DEPS="$COMPACT_DIR"
+  COMPACT_FLAGS="-DREDIS_LUA_WASM_COMPACT_TVALUE"
+fi
 LUA_SRC_DIR="$REDIS_LUA_DEPS"
-LUA_CORE="lapi.c lcode.c ldebug.c ldo.c ldump.c lfunc.c lgc.c llex.c lmem.c lobject.c lopcodes.c lparser.c lstate.c lstring.c ltable.c ltm.c lundump.c lvm.c lzio.c"
+LUA_CORE="lapi.c lcode.c ldebug.c ldo.c ldump.c lfunc.c lgc.c llex.c lmem.c lobject.c lopcodes.c lparser.c lstate.c ltm.c lundump.c lvm.c lzio.c"
 LUA_LIBS="lauxlib.c lbaselib.c ltablib.c lstrlib.c lmathlib.c loslib.c"
 REDIS_LUA_MODULES="lua_cjson.c lua_cmsgpack.c lua_struct.c lua_bit.c strbuf.c fpconv.c"
 
@@ -37,16 +56,62 @@ for file in $REDIS_LUA_MODULES; do
   MODULE_FILES="$MODULE_FILES $REDIS_LUA_DEPS/$file"
 done
 
-emcc -O2 -DENABLE_CJSON_GLOBAL \
-  -sERROR_ON_UNDEFINED_SYMBOLS=0 -sWARN_ON_UNDEFINED_SYMBOLS=0 \
-  -sMODULARIZE=1 -sEXPORT_ES6=1 -sENVIRONMENT=web,worker,node -sNO_EXIT_RUNTIME=1 -sSTRICT=1 \
-  -sWASM_BIGINT=1 \
-  -sEXPORTED_RUNTIME_METHODS="['HEAPU8']" \
-  -sINCOMING_MODULE_JS_API="['locateFile','instantiateWasm']" \
-  -sINITIAL_MEMORY=67108864 -sMAXIMUM_MEMORY=67108864 \
-  -sEXPORTED_FUNCTIONS="['_init','_reset','_eval','_eval_with_args','_alloc','_free_mem','_set_limits','_set_compat']" \
-  -I"$ROOT_DIR/wasm/include" -I"$LUA_SRC_DIR" -I"$REDIS_LUA_DEPS" -I"$REDIS_SRC" \
-  "$SRC_DIR/runtime.c" "$SRC_DIR/redis_api.c" $CORE_FILES $LIB_FILES $MODULE_FILES \
-  -o "$OUT_DIR/redis_lua.mjs"
+# PROFILE=1 builds the opcode / C-function histogram instrumentation (profile.c)
+# and exports _profile_take. Release builds compile none of it.
+PROFILE_FLAGS=""
+PROFILE_SRC=""
+PROFILE_EXPORTS=""
+if [ "${PROFILE:-0}" = "1" ]; then
+  PROFILE_FLAGS="-DREDIS_LUA_WASM_PROFILE"
+  PROFILE_SRC="$SRC_DIR/profile.c"
+  PROFILE_EXPORTS=",'_profile_take'"
+fi
+
+# SIMD=1 builds with wasm simd128 and swaps cjson.decode for the structural-index
+# decoder in json_simd.c (falls back to lua_cjson for anything it does not take).
+SIMD_FLAGS=""
+SIMD_SRC=""
+if [ "${SIMD:-0}" = "1" ]; then
+  SIMD_FLAGS="-msimd128 -DREDIS_LUA_WASM_SIMD_JSON"
+  SIMD_SRC="$SRC_DIR/json_simd.c"
+fi
+
+# lstring.c and ltable.c are compiled on their own with some entry points
+# renamed: wasm/src/string_hash.c provides luaS_newlstr (stock sampled hash
+# unless a seed is configured), and wasm/src/arena_resize.c the resize paths that
+# must not allocate from the eval arena.
+OBJ_DIR="$OUT_DIR/obj"
+mkdir -p "$OBJ_DIR"
+emcc -O2 -c -DluaS_newlstr=luaS_newlstr_sampled -DluaS_resize=luaS_resize_stock \
+  $COMPACT_FLAGS -I"$LUA_SRC_DIR" "$LUA_SRC_DIR/lstring.c" -o "$OBJ_DIR/lstring.o"
+emcc -O2 -c -DluaH_set=luaH_set_stock -DluaH_setnum=luaH_setnum_stock \
+  -DluaH_setstr=luaH_setstr_stock -DluaH_resizearray=luaH_resizearray_stock \
+  $COMPACT_FLAGS -I"$LUA_SRC_DIR" "$LUA_SRC_DIR/ltable.c" -o "$OBJ_DIR/ltable.o"
+
+LINK_ARGS=(
+  -O2 -DENABLE_CJSON_GLOBAL $PROFILE_FLAGS $SIMD_FLAGS $COMPACT_FLAGS
+  -sERROR_ON_UNDEFINED_SYMBOLS=0 -sWARN_ON_UNDEFINED_SYMBOLS=0
+  -sMODULARIZE=1 -sENVIRONMENT=web,worker,node -sNO_EXIT_RUNTIME=1 -sSTRICT=1
+  -sWASM_BIGINT=1
+  -sEXPORTED_RUNTIME_METHODS="['HEAPU8']"
+  -sINCOMING_MODULE_JS_API="['locateFile','instantiateWasm']"
+  -sINITIAL_MEMORY=67108864 -sMAXIMUM_MEMORY=67108864
+  -sEXPORTED_FUNCTIONS="['_init','_reset','_eval','_eval_with_args','_alloc','_free_mem','_set_limits','_set_load_limits','_set_compat','_set_compat_envs','_use_compat','_set_string_hash','_set_eval_arena','_script_compile','_script_install','_eval_sha','_script_flush','_set_alloc_tracking','_set_alloc_owner','_alloc_snapshot','_set_trace','_trace_marks','_fuel_used','_script_evict','_heap_bytes','_gc_step','_hibernate','_update_redis_props'$PROFILE_EXPORTS]"
+  -I"$ROOT_DIR/wasm/include" -I"$LUA_SRC_DIR" -I"$REDIS_LUA_DEPS" -I"$REDIS_SRC"
+  "$SRC_DIR/runtime.c" "$SRC_DIR/redis_api.c" "$SRC_DIR/fuel.c" "$SRC_DIR/eval_arena.c" "$SRC_DIR/alloc_track.c" "$SRC_DIR/script_cache.c" "$SRC_DIR/load_limits.c" "$SRC_DIR/string_hash.c" "$SRC_DIR/arena_resize.c" "$OBJ_DIR/lstring.o" "$OBJ_DIR/ltable.o" $PROFILE_SRC $SIMD_SRC
+  $CORE_FILES $LIB_FILES $MODULE_FILES
+)
+
+emcc "${LINK_ARGS[@]}" -sEXPORT_ES6=1 -o "$OUT_DIR/redis_lua.mjs"
 
 echo "Built $OUT_DIR/redis_lua.mjs"
+
+# CommonJS glue for Node startup snapshots (src/snapshot.ts): a snapshot cannot
+# dynamic-import the ES module glue. Same link, so it pairs with redis_lua.wasm;
+# the second .wasm is discarded.
+CJS_DIR="$OBJ_DIR/cjs"
+mkdir -p "$CJS_DIR"
+emcc "${LINK_ARGS[@]}" -sEXPORT_ES6=0 -o "$CJS_DIR/redis_lua.js"
+cp "$CJS_DIR/redis_lua.js" "$OUT_DIR/redis_lua.cjs"
+
+echo "Built $OUT_DIR/redis_lua.cjs"
@@ -10,5 +10,5 @@ IMAGE_NAME="emscripten/emsdk:6.0.1"
 PLATFORM="${DOCKER_PLATFORM:-}"
 
 # Run the build inside Docker, mounting the repo.
-docker run $PLATFORM --rm -v "$ROOT_DIR":/work -w /work "$IMAGE_NAME" \
+docker run $PLATFORM --rm -e PROFILE="${PROFILE:-0}" -e SIMD="${SIMD:-0}" -e COMPACT_TVALUE="${COMPACT_TVALUE:-0}" -v "$ROOT_DIR":/work -w /work "$IMAGE_NAME" \
   /bin/sh -c "./wasm/build/build.sh"
@@ -8,5 +8,5 @@ IMAGE_NAME="emscripten/emsdk:3.1.56"
 PLATFORM="${DOCKER_PLATFORM:---platform=linux/amd64}"
 
 # Run smoke tests inside Docker.
-docker run $PLATFORM --rm -v "$ROOT_DIR":/work -w /work "$IMAGE_NAME" \
+docker run $PLATFORM --rm -e COMPACT_TVALUE="${COMPACT_TVALUE:-0}" -e SIMD="${SIMD:-0}" -v "$ROOT_DIR":/work -w /work "$IMAGE_NAME" \
   /bin/sh -c "./wasm/build/run-smoke-tests.sh"
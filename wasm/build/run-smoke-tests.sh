@@ -6,9 +6,35 @@ OUT_DIR="$ROOT_DIR/wasm/build/tests"
 
 REDIS_LUA_DEPS="$ROOT_DIR/vendor/redis/deps/lua/src"
 REDIS_SRC="$ROOT_DIR/vendor/redis/src"
+
+mkdir -p "$OUT_DIR"
+
+# COMPACT_TVALUE=1 runs the smoke tests against the compact VM, patched the
+# same way as in build.sh.
+COMPACT_FLAGS=""
+if [ "${COMPACT_TVALUE:-0}" = "1" ]; then
+  COMPACT_DIR="$OUT_DIR/lua-compact"
+  rm -rf "$COMPACT_DIR"
+  cp -R "$REDIS_LUA_DEPS" "$COMPACT_DIR"
+  sed -E -i 's/^#define[[:space:]]+LUA_NUMBER[[:space:]]+double[[:space:]]*$/typedef double __attribute__((aligned(4))) lua_CompactNumber;\n#define LUA_NUMBER\tlua_CompactNumber/' \
+    "$COMPACT_DIR/luaconf.h"
+  if ! grep -q "lua_CompactNumber" "$COMPACT_DIR/luaconf.h"; then
+    echo "COMPACT_TVALUE: LUA_NUMBER definition not found in luaconf.h"
+    exit 1
+  fi
+  REDIS_LUA_DEPS="$COMPACT_DIR"
+  COMPACT_FLAGS="-DREDIS_LUA_WASM_COMPACT_TVALUE"
+fi
 LUA_SRC_DIR="$REDIS_LUA_DEPS"
 
-LUA_CORE="lapi.c lcode.c ldebug.c ldo.c ldump.c lfunc.c lgc.c llex.c lmem.c lobject.c lopcodes.c lparser.c lstate.c lstring.c ltable.c ltm.c lundump.c lvm.c lzio.c"
+# SIMD=1 builds the runtime with the simd128 cjson.decode fast path, as in
+# build.sh; json_decode_smoke then exercises it.
+SIMD_FLAGS=""
+if [ "${SIMD:-0}" = "1" ]; then
+  SIMD_FLAGS="-msimd128 -DREDIS_LUA_WASM_SIMD_JSON"
+fi
+
+LUA_CORE="lapi.c lcode.c ldebug.c ldo.c ldump.c lfunc.c lgc.c llex.c lmem.c lobject.c lopcodes.c lparser.c lstate.c ltm.c lundump.c lvm.c lzio.c"
 LUA_LIBS="lauxlib.c lbaselib.c ltablib.c lstrlib.c lmathlib.c loslib.c"
 REDIS_LUA_MODULES="lua_cjson.c lua_cmsgpack.c lua_struct.c lua_bit.c strbuf.c fpconv.c"
 
@@ -27,12 +53,18 @@ for file in $REDIS_LUA_MODULES; do
   MODULE_FILES="$MODULE_FILES $REDIS_LUA_DEPS/$file"
 done
 
-COMMON_SRC="$ROOT_DIR/wasm/src/runtime.c $ROOT_DIR/wasm/src/redis_api.c $ROOT_DIR/wasm/src/tests/test_host_stubs.c $CORE_FILES $LIB_FILES $MODULE_FILES"
+# See build.sh: lstring.c and ltable.c are built with entry points renamed for
+# string_hash.c and arena_resize.c.
+emcc -O2 -c -DluaS_newlstr=luaS_newlstr_sampled -DluaS_resize=luaS_resize_stock \
+  $COMPACT_FLAGS -I"$LUA_SRC_DIR" "$LUA_SRC_DIR/lstring.c" -o "$OUT_DIR/lstring.o"
+emcc -O2 -c -DluaH_set=luaH_set_stock -DluaH_setnum=luaH_setnum_stock \
+  -DluaH_setstr=luaH_setstr_stock -DluaH_resizearray=luaH_resizearray_stock \
+  $COMPACT_FLAGS -I"$LUA_SRC_DIR" "$LUA_SRC_DIR/ltable.c" -o "$OUT_DIR/ltable.o"
 
-mkdir -p "$OUT_DIR"
+COMMON_SRC="$ROOT_DIR/wasm/src/runtime.c $ROOT_DIR/wasm/src/redis_api.c $ROOT_DIR/wasm/src/fuel.c $ROOT_DIR/wasm/src/eval_arena.c $ROOT_DIR/wasm/src/alloc_track.c $ROOT_DIR/wasm/src/script_cache.c $ROOT_DIR/wasm/src/load_limits.c $ROOT_DIR/wasm/src/string_hash.c $ROOT_DIR/wasm/src/arena_resize.c $ROOT_DIR/wasm/src/json_simd.c $OUT_DIR/lstring.o $OUT_DIR/ltable.o $ROOT_DIR/wasm/src/tests/test_host_stubs.c $CORE_FILES $LIB_FILES $MODULE_FILES"
 
-for test in runtime_smoke runtime_eval_smoke runtime_eval_args_smoke modules_smoke; do
-  emcc -O2 -DENABLE_CJSON_GLOBAL -sENVIRONMENT=node -sEXIT_RUNTIME=1 \
+for test in runtime_smoke runtime_eval_smoke runtime_eval_args_smoke modules_smoke script_cache_smoke alloc_track_smoke string_hash_smoke eval_arena_smoke json_decode_smoke; do
+  emcc -O2 -DENABLE_CJSON_GLOBAL $COMPACT_FLAGS $SIMD_FLAGS -sENVIRONMENT=node -sEXIT_RUNTIME=1 \
     -sERROR_ON_UNDEFINED_SYMBOLS=0 -sWARN_ON_UNDEFINED_SYMBOLS=0 \
     -I"$ROOT_DIR/wasm/include" -I"$LUA_SRC_DIR" -I"$REDIS_LUA_DEPS" -I"$REDIS_SRC" \
     "$ROOT_DIR/wasm/src/tests/$test.c" $COMMON_SRC \
@@ -63,9 +63,49 @@ PtrLen eval(uint32_t ptr, uint32_t len);
 PtrLen eval_with_args(uint32_t script_ptr, uint32_t script_len, uint32_t args_ptr,
                       uint32_t args_len, uint32_t keys_count);
 void set_limits(uint32_t max_fuel, uint32_t max_reply_bytes, uint32_t max_arg_bytes);
+/* Applies a redis props delta (host_redis_props encoding) to the live state. */
+PtrLen update_redis_props(uint32_t ptr, uint32_t len);
+/* Compile-time limits applied to every script load; 0 disables each. */
+void set_load_limits(uint32_t max_script_bytes, uint32_t max_functions, uint32_t max_constants,
+                     uint32_t max_nesting, uint32_t max_parse_ms);
+/* Fuel the last eval charged against max_fuel. */
+uint32_t fuel_used(void);
 void set_compat(uint32_t flags);
+/* Compat flag sets to prebuild environments for at init/reset: bit (1 << flags). */
+void set_compat_envs(uint32_t mask);
+/* Runs later evals under the environment for compat `flags` (kept across reset). */
+void use_compat(uint32_t flags);
+void set_string_hash(uint32_t seeded, uint32_t seed);
+void set_eval_arena(uint32_t bytes);
+/* Precompiled script cache (see script_cache.c). `sha_ptr` points at the
+ * 40-char hex SHA1. */
+PtrLen script_compile(uint32_t ptr, uint32_t len);
+PtrLen script_install(uint32_t sha_ptr, uint32_t bc_ptr, uint32_t bc_len);
+PtrLen eval_sha(uint32_t sha_ptr, uint32_t args_ptr, uint32_t args_len, uint32_t keys_count);
+void script_flush(void);
+void script_evict(uint32_t sha_ptr);
+/* Memory governance: Lua heap bytes, a GC step of `kb` KB (0: full collection)
+ * returning the heap afterwards, and closing the state until the next init. */
+uint32_t heap_bytes(void);
+uint32_t gc_step(uint32_t kb);
+void hibernate(void);
+/* Allocation tracking (see alloc_track.c): enable for the next init/reset,
+ * attribute new Lua blocks to an owner slot, and snapshot live usage (after a
+ * full collection when `collect` is nonzero). */
+void set_alloc_tracking(uint32_t enabled);
+void set_alloc_owner(uint32_t owner);
+PtrLen alloc_snapshot(uint32_t collect);
+/* Eval tracing: while enabled, each eval stores five f64 phase timestamps
+ * (entered, KEYS/ARGV ready, compiled, executed, reply encoded) at the
+ * address trace_marks() returns. */
+void set_trace(uint32_t enabled);
+uint32_t trace_marks(void);
 uint32_t alloc(uint32_t size);
 void free_mem(uint32_t ptr);
+#ifdef REDIS_LUA_WASM_PROFILE
+/* Opcode / C-function counts since the previous call (see profile.c). */
+PtrLen profile_take(void);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,261 @@
+/* Optional allocation tracking, layered on the lua_Alloc hook.
+ *
+ * With tracking enabled, states are created with track_alloc in front of the
+ * regular allocator (plain realloc or the eval arena). Every block gets an
+ * 8-byte header recording the owner slot that was current when the block was
+ * first allocated; the host sets the owner to its slot for a script sha around
+ * each eval, so live bytes and allocation counts can be attributed per script.
+ * A block keeps its owner when it is reallocated, so a table created by one
+ * script and grown by another stays with the first.
+ *
+ * lua_Alloc is never told what a block is for, so object types come from a
+ * separate pass: alloc_track_snapshot walks the string table and the rootgc
+ * list (every other collectable object, userdata included), sizes each object
+ * the way lgc.c frees it, and files it under the owner in its header and its
+ * type. Table array and node parts count towards the table. Open upvalues hang
+ * off their thread rather than rootgc and are skipped; they only exist while a
+ * function is running.
+ *
+ * Blob layout (wasm is little-endian, so native copies are the wire format),
+ * owners with no allocations and no live objects omitted:
+ *
+ *   [owner_count: u32][class_count: u32]
+ *   { [owner: u32][live_bytes: u64][live_blocks: u64][allocations: u64]
+ *     [allocated_bytes: u64] { [objects: u64][bytes: u64] } * class_count }
+ *   * owner_count
+ *
+ * Classes, in order: string, table, function, proto, userdata, thread, upvalue.
+ * Sizes exclude the header. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lfunc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "lstring.h"
+
+#include "alloc_track.h"
+
+enum {
+  CLASS_STRING,
+  CLASS_TABLE,
+  CLASS_FUNCTION,
+  CLASS_PROTO,
+  CLASS_USERDATA,
+  CLASS_THREAD,
+  CLASS_UPVALUE,
+  CLASS_COUNT
+};
+
+/* 8 bytes keeps the block Lua sees as aligned as the one underneath. */
+typedef struct BlockHeader {
+  uint32_t owner;
+  uint32_t reserved;
+} BlockHeader;
+
+typedef struct OwnerStats {
+  uint64_t live_bytes;
+  uint64_t live_blocks;
+  uint64_t allocations;
+  uint64_t allocated_bytes;
+} OwnerStats;
+
+typedef struct ObjectStats {
+  uint64_t objects;
+  uint64_t bytes;
+} ObjectStats;
+
+static int g_enabled = 0;
+static lua_Alloc g_inner = NULL;
+static uint32_t g_owner = 0;
+static OwnerStats g_stats[ALLOC_TRACK_OWNERS];
+
+static void *track_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+  uint8_t *block = ptr ? (uint8_t *)ptr - sizeof(BlockHeader) : NULL;
+  uint32_t owner = block ? ((BlockHeader *)block)->owner : g_owner;
+  OwnerStats *stats = &g_stats[owner];
+  if (nsize == 0) {
+    if (block) {
+      stats->live_bytes -= osize;
+      stats->live_blocks--;
+      g_inner(ud, block, osize + sizeof(BlockHeader), 0);
+    }
+    return NULL;
+  }
+  uint8_t *out = g_inner(ud, block, block ? osize + sizeof(BlockHeader) : 0,
+                         nsize + sizeof(BlockHeader));
+  if (!out) {
+    return NULL;
+  }
+  if (block) {
+    stats->live_bytes -= osize;
+    if (nsize > osize) {
+      stats->allocated_bytes += nsize - osize;
+    }
+  } else {
+    ((BlockHeader *)out)->owner = owner;
+    ((BlockHeader *)out)->reserved = 0;
+    stats->live_blocks++;
+    stats->allocations++;
+    stats->allocated_bytes += nsize;
+  }
+  stats->live_bytes += nsize;
+  return out + sizeof(BlockHeader);
+}
+
+void alloc_track_configure(int enabled) {
+  g_enabled = enabled;
+  g_owner = 0;
+  memset(g_stats, 0, sizeof(g_stats));
+}
+
+int alloc_track_enabled(void) {
+  return g_enabled;
+}
+
+lua_Alloc alloc_track_wrap(lua_Alloc inner) {
+  if (!g_enabled) {
+    return inner;
+  }
+  g_inner = inner;
+  return track_alloc;
+}
+
+void alloc_track_set_owner(uint32_t owner) {
+  g_owner = owner < ALLOC_TRACK_OWNERS ? owner : 0;
+}
+
+static uint32_t object_owner(const GCObject *o) {
+  return ((const BlockHeader *)((const uint8_t *)o - sizeof(BlockHeader)))->owner;
+}
+
+static void count_object(ObjectStats *objects, GCObject *o, const Node *dummy) {
+  int cls;
+  size_t bytes;
+  switch (o->gch.tt) {
+    case LUA_TSTRING:
+      cls = CLASS_STRING;
+      bytes = sizestring(gco2ts(o));
+      break;
+    case LUA_TTABLE: {
+      const Table *t = gco2h(o);
+      cls = CLASS_TABLE;
+      bytes = sizeof(Table) + sizeof(TValue) * (size_t)t->sizearray;
+      if (t->node != dummy) {
+        bytes += sizeof(Node) * (size_t)sizenode(t);
+      }
+      break;
+    }
+    case LUA_TFUNCTION: {
+      const Closure *cl = gco2cl(o);
+      cls = CLASS_FUNCTION;
+      bytes = cl->c.isC ? (size_t)sizeCclosure(cl->c.nupvalues)
+                        : (size_t)sizeLclosure(cl->l.nupvalues);
+      break;
+    }
+    case LUA_TPROTO: {
+      const Proto *p = gco2p(o);
+      cls = CLASS_PROTO;
+      bytes = sizeof(Proto) + sizeof(Instruction) * (size_t)p->sizecode +
+              sizeof(TValue) * (size_t)p->sizek + sizeof(Proto *) * (size_t)p->sizep +
+              sizeof(int) * (size_t)p->sizelineinfo +
+              sizeof(LocVar) * (size_t)p->sizelocvars +
+              sizeof(TString *) * (size_t)p->sizeupvalues;
+      break;
+    }
+    case LUA_TUSERDATA:
+      cls = CLASS_USERDATA;
+      bytes = sizeudata(gco2u(o));
+      break;
+    case LUA_TTHREAD: {
+      const lua_State *th = gco2th(o);
+      cls = CLASS_THREAD;
+      bytes = sizeof(lua_State) + sizeof(TValue) * (size_t)th->stacksize +
+              sizeof(CallInfo) * (size_t)th->size_ci;
+      break;
+    }
+    case LUA_TUPVAL:
+      cls = CLASS_UPVALUE;
+      bytes = sizeof(UpVal);
+      break;
+    default:
+      return;
+  }
+  uint32_t owner = object_owner(o);
+  ObjectStats *slot = &objects[(owner < ALLOC_TRACK_OWNERS ? owner : 0) * CLASS_COUNT + cls];
+  slot->objects++;
+  slot->bytes += bytes;
+}
+
+static void walk_heap(lua_State *L, ObjectStats *objects) {
+  global_State *g = G(L);
+  /* A table created empty points at the shared static dummy node. */
+  lua_createtable(L, 0, 0);
+  const Node *dummy = ((const Table *)lua_topointer(L, -1))->node;
+  lua_pop(L, 1);
+  for (int i = 0; i < g->strt.size; i++) {
+    for (GCObject *o = g->strt.hash[i]; o != NULL; o = o->gch.next) {
+      count_object(objects, o, dummy);
+    }
+  }
+  for (GCObject *o = g->rootgc; o != NULL; o = o->gch.next) {
+    count_object(objects, o, dummy);
+  }
+}
+
+static int owner_used(uint32_t owner, const ObjectStats *owned) {
+  if (g_stats[owner].allocations != 0) {
+    return 1;
+  }
+  for (int cls = 0; cls < CLASS_COUNT; cls++) {
+    if (owned[cls].objects != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+PtrLen alloc_track_snapshot(lua_State *L) {
+  if (!g_enabled || !L) {
+    return (PtrLen){0, 0};
+  }
+  ObjectStats *objects = calloc((size_t)ALLOC_TRACK_OWNERS * CLASS_COUNT, sizeof(ObjectStats));
+  if (!objects) {
+    return (PtrLen){0, 0};
+  }
+  walk_heap(L, objects);
+
+  uint32_t owner_count = 0;
+  for (uint32_t owner = 0; owner < ALLOC_TRACK_OWNERS; owner++) {
+    owner_count += owner_used(owner, &objects[owner * CLASS_COUNT]);
+  }
+  size_t entry_len = 4 + sizeof(OwnerStats) + sizeof(ObjectStats) * CLASS_COUNT;
+  size_t len = 8 + entry_len * owner_count;
+  uint8_t *out = malloc(len);
+  if (!out) {
+    free(objects);
+    return (PtrLen){0, 0};
+  }
+  uint32_t class_count = CLASS_COUNT;
+  memcpy(out, &owner_count, 4);
+  memcpy(out + 4, &class_count, 4);
+  uint8_t *cursor = out + 8;
+  for (uint32_t owner = 0; owner < ALLOC_TRACK_OWNERS; owner++) {
+    const ObjectStats *owned = &objects[owner * CLASS_COUNT];
+    if (!owner_used(owner, owned)) {
+      continue;
+    }
+    memcpy(cursor, &owner, 4);
+    memcpy(cursor + 4, &g_stats[owner], sizeof(OwnerStats));
+    memcpy(cursor + 4 + sizeof(OwnerStats), owned, sizeof(ObjectStats) * CLASS_COUNT);
+    cursor += entry_len;
+  }
+  free(objects);
+  return (PtrLen){(uint32_t)(uintptr_t)out, (uint32_t)len};
+}
@@ -0,0 +1,31 @@
+#ifndef REDIS_LUA_WASM_ALLOC_TRACK_H
+#define REDIS_LUA_WASM_ALLOC_TRACK_H
+
+#include "../include/abi.h"
+#include <lua.h>
+#include <stdint.h>
+
+/* Optional allocation tracking. See alloc_track.c. */
+
+/* Owner slots, 0 included. Slot 0 collects everything allocated outside an
+ * attributed eval; out-of-range owners fall back to it. */
+#define ALLOC_TRACK_OWNERS 1024
+
+/* Enables tracking for states created afterwards and zeroes the counters. Only
+ * call while no lua_State exists. */
+void alloc_track_configure(int enabled);
+
+int alloc_track_enabled(void);
+
+/* Returns the tracking allocator layered over `inner` (which then sees every
+ * block with a small header in front), or `inner` itself when tracking is off. */
+lua_Alloc alloc_track_wrap(lua_Alloc inner);
+
+/* New blocks are attributed to `owner` until the next call. */
+void alloc_track_set_owner(uint32_t owner);
+
+/* Per-owner counters plus a walk of L's live objects by type; see
+ * alloc_track.c for the blob layout. {0, 0} when tracking is off. */
+PtrLen alloc_track_snapshot(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_ALLOC_TRACK_H */
@@ -0,0 +1,59 @@
+/* Resize entry points that keep pre-existing objects off the eval arena.
+ *
+ * The vendored lstring.c and ltable.c are compiled with their resize paths
+ * renamed (see wasm/build/build.sh): luaS_resize, and luaH_set / luaH_setnum /
+ * luaH_setstr / luaH_resizearray, the only ways a table's vectors grow after
+ * luaH_new. The real entry points here run the stock code under
+ * eval_arena_hold, so growing the string table or a table created before the
+ * eval allocates from the heap, never from the region (see eval_arena.c).
+ * Outside an eval, or for tables the eval created, the hold is a no-op. */
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lobject.h"
+#include "lstate.h"
+#include "lstring.h"
+#include "ltable.h"
+
+#include "eval_arena.h"
+
+void luaS_resize_stock(lua_State *L, int newsize);
+TValue *luaH_set_stock(lua_State *L, Table *t, const TValue *key);
+TValue *luaH_setnum_stock(lua_State *L, Table *t, int key);
+TValue *luaH_setstr_stock(lua_State *L, Table *t, TString *key);
+void luaH_resizearray_stock(lua_State *L, Table *t, int nasize);
+
+void luaS_resize(lua_State *L, int newsize) {
+  int held = eval_arena_hold(G(L)); /* the global state is never in the region */
+  luaS_resize_stock(L, newsize);
+  eval_arena_release(held);
+}
+
+TValue *luaH_set(lua_State *L, Table *t, const TValue *key) {
+  int held = eval_arena_hold(t);
+  TValue *slot = luaH_set_stock(L, t, key);
+  eval_arena_release(held);
+  return slot;
+}
+
+TValue *luaH_setnum(lua_State *L, Table *t, int key) {
+  int held = eval_arena_hold(t);
+  TValue *slot = luaH_setnum_stock(L, t, key);
+  eval_arena_release(held);
+  return slot;
+}
+
+TValue *luaH_setstr(lua_State *L, Table *t, TString *key) {
+  int held = eval_arena_hold(t);
+  TValue *slot = luaH_setstr_stock(L, t, key);
+  eval_arena_release(held);
+  return slot;
+}
+
+void luaH_resizearray(lua_State *L, Table *t, int nasize) {
+  int held = eval_arena_hold(t);
+  luaH_resizearray_stock(L, t, nasize);
+  eval_arena_release(held);
+}
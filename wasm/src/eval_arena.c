@@ -0,0 +1,226 @@
+/* Experimental per-eval region allocator.
+ *
+ * Globals are readonly, so almost everything a script allocates is garbage once
+ * eval returns. With the arena enabled, allocations made during an eval are
+ * bump-allocated from a fixed region, frees of region blocks are no-ops, and the
+ * GC is stopped for the duration of the eval. Objects created outside an eval
+ * (library tables, the redis API, anything from init) live on the regular heap.
+ *
+ * Lua 5.1 links every collectable object into global lists (rootgc and the
+ * string table), so the region cannot simply be dropped while those lists still
+ * point into it. It rewinds only when its live block count reaches zero, that
+ * is when the sweep that "frees" the last region block runs. Evals do not
+ * collect: the region keeps bumping across evals, and only an eval that ran it
+ * out (allocations then fall back to the heap and the GC is restarted) ends with
+ * one full collection, which unlinks every dead region block and so rewinds it.
+ *
+ * If something allocated during an eval survives that collection (say a table
+ * stored into the registry by a C function), the region is pinned: it cannot
+ * rewind while that object lives. Pinned, evals run on the regular heap with
+ * the GC running, and the region rewinds and comes back into use when the
+ * incremental GC frees the object. eval_arena_pinned reports the state.
+ * Correctness never depends on the region being empty, only the savings do.
+ *
+ * Growing an object replaces its vector with a fresh allocation (luaS_resize
+ * for the string table, setnodevector for a table's hash part), which the
+ * allocator cannot tell from a new object. A string table or globals vector
+ * placed in the region would outlive every eval and pin it for good, so
+ * arena_resize.c brackets those resizes with eval_arena_hold: the vectors of an
+ * object that is not itself in the region go to the heap.
+ *
+ * What remains is one mark of the small live set plus a sweep whose frees are
+ * free, once per region's worth of allocation rather than per eval; the
+ * incremental steps, per-object free() calls and heap fragmentation of the
+ * regular path are gone. */
+
+#include "eval_arena.h"
+#include "alloc_track.h"
+#include <lauxlib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 8
+
+static size_t g_configured_bytes = 0;
+
+static uint8_t *g_region = NULL;
+static size_t g_region_size = 0;
+static size_t g_region_used = 0;
+static size_t g_region_live = 0; /* region blocks not yet freed */
+static int g_in_eval = 0;        /* between eval_arena_begin and eval_arena_end */
+static int g_active = 0;         /* inside an eval: new blocks come from the region */
+static int g_exhausted = 0;      /* region ran out during this eval */
+static int g_pinned = 0;         /* a block survived a full collection */
+
+static int in_region(const void *ptr) {
+  return g_region && (const uint8_t *)ptr >= g_region &&
+         (const uint8_t *)ptr < g_region + g_region_size;
+}
+
+/* Once no region block is live, nothing can point into the region. */
+static void region_free(void) {
+  if (--g_region_live == 0) {
+    g_region_used = 0;
+    g_pinned = 0;
+  }
+}
+
+static void *region_alloc(size_t size) {
+  size_t aligned = (size + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+  if (aligned > g_region_size - g_region_used) {
+    g_exhausted = 1;
+    return NULL;
+  }
+  void *block = g_region + g_region_used;
+  g_region_used += aligned;
+  g_region_live++;
+  return block;
+}
+
+static void *arena_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+  (void)ud;
+  if (ptr && in_region(ptr)) {
+    if (nsize == 0) {
+      region_free();
+      return NULL;
+    }
+    if (nsize <= osize) {
+      return ptr;
+    }
+    void *block = g_active ? region_alloc(nsize) : NULL;
+    if (!block) {
+      block = malloc(nsize);
+      if (!block) {
+        return NULL;
+      }
+    }
+    memcpy(block, ptr, osize);
+    region_free();
+    return block;
+  }
+  if (nsize == 0) {
+    free(ptr);
+    return NULL;
+  }
+  /* Only fresh allocations go to the region: heap blocks (the Lua stack, call
+   * info) keep growing on the heap, and resizes of heap objects run held. */
+  if (!ptr && g_active) {
+    void *block = region_alloc(nsize);
+    if (block) {
+      return block;
+    }
+  }
+  return realloc(ptr, nsize);
+}
+
+/* luaL_newstate's allocator, for tracked states without an arena. */
+static void *heap_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+  (void)ud;
+  (void)osize;
+  if (nsize == 0) {
+    free(ptr);
+    return NULL;
+  }
+  return realloc(ptr, nsize);
+}
+
+static int arena_panic(lua_State *L) {
+  (void)L;
+  return 0;
+}
+
+void eval_arena_configure(size_t bytes) {
+  g_configured_bytes = bytes;
+}
+
+lua_State *eval_arena_newstate(void) {
+  if (g_configured_bytes == 0) {
+    free(g_region);
+    g_region = NULL;
+    g_region_size = 0;
+    if (!alloc_track_enabled()) {
+      return luaL_newstate();
+    }
+    lua_State *L = lua_newstate(alloc_track_wrap(heap_alloc), NULL);
+    if (L) {
+      lua_atpanic(L, arena_panic);
+    }
+    return L;
+  }
+  /* The previous state (if any) is closed, so every region block is freed. */
+  if (g_region_size != g_configured_bytes) {
+    free(g_region);
+    g_region = malloc(g_configured_bytes);
+    g_region_size = g_region ? g_configured_bytes : 0;
+  }
+  g_region_used = 0;
+  g_region_live = 0;
+  g_in_eval = 0;
+  g_active = 0;
+  g_exhausted = 0;
+  g_pinned = 0;
+  lua_State *L = lua_newstate(alloc_track_wrap(arena_alloc), NULL);
+  if (L) {
+    lua_atpanic(L, arena_panic);
+    /* The shared concat/lexer buffer starts unallocated; grow it now so it is a
+     * heap block rather than the first region allocation of the first eval. */
+    lua_pushliteral(L, "a");
+    lua_pushliteral(L, "b");
+    lua_concat(L, 2);
+    lua_pop(L, 1);
+  }
+  return L;
+}
+
+void eval_arena_begin(lua_State *L) {
+  if (!g_region || g_pinned) {
+    return;
+  }
+  lua_gc(L, LUA_GCSTOP, 0);
+  g_exhausted = 0;
+  g_in_eval = 1;
+  g_active = 1;
+}
+
+void eval_arena_end(lua_State *L) {
+  if (!g_in_eval) {
+    return;
+  }
+  g_in_eval = 0;
+  g_active = 0;
+  if (g_exhausted) {
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    g_pinned = g_region_live > 0;
+  }
+  lua_gc(L, LUA_GCRESTART, 0);
+}
+
+int eval_arena_hold(const void *owner) {
+  if (!g_active || in_region(owner)) {
+    return 0;
+  }
+  g_active = 0;
+  return 1;
+}
+
+void eval_arena_release(int held) {
+  if (held) {
+    g_active = 1;
+  }
+}
+
+size_t eval_arena_used(void) {
+  return g_region_used;
+}
+
+int eval_arena_pinned(void) {
+  return g_pinned;
+}
+
+void eval_arena_poll(lua_State *L) {
+  if (g_exhausted && g_active) {
+    g_exhausted = 0;
+    lua_gc(L, LUA_GCRESTART, 0);
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef REDIS_LUA_WASM_EVAL_ARENA_H
+#define REDIS_LUA_WASM_EVAL_ARENA_H
+
+#include <lua.h>
+#include <stddef.h>
+
+/* Experimental per-eval region allocator. See eval_arena.c. */
+
+/* Region size in bytes for states created afterwards; 0 disables the arena.
+ * Only call while no lua_State exists. */
+void eval_arena_configure(size_t bytes);
+
+/* luaL_newstate, using the arena-aware allocator when one is configured and
+ * the tracking allocator (alloc_track.h) on top when tracking is enabled. */
+lua_State *eval_arena_newstate(void);
+
+/* Bracket one eval: begin routes new allocations into the region and stops the
+ * GC; end restarts it, after a full collection if the eval ran the region out.
+ * The region rewinds whenever its last live block is freed. */
+void eval_arena_begin(lua_State *L);
+void eval_arena_end(lua_State *L);
+
+/* Brackets a resize of `owner` (a table, or the global state for the string
+ * table): unless `owner` itself was allocated in the region, the new vectors go
+ * to the heap. Returns a token for eval_arena_release. An error raised in
+ * between leaves the rest of the eval on the heap, which is safe. */
+int eval_arena_hold(const void *owner);
+void eval_arena_release(int held);
+
+/* Bytes of the region in use; 0 once it has rewound. */
+size_t eval_arena_used(void);
+
+/* Nonzero while a region block has survived a full collection. Evals then use
+ * the regular heap until the block is freed and the region rewinds. */
+int eval_arena_pinned(void);
+
+/* Called from the count hook: restarts the GC if the region ran out mid-eval,
+ * so overflow allocations on the regular heap stay bounded. */
+void eval_arena_poll(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_EVAL_ARENA_H */
@@ -0,0 +1,213 @@
+/* Fuel accounting: the instruction-count hook plus explicit charges for C
+ * library calls whose cost the hook cannot see.
+ *
+ * A call into string.rep, cjson.encode or table.sort is one or two VM
+ * instructions no matter how much work it does. The wrappers below charge fuel
+ * in proportion to bytes produced/scanned or elements compared:
+ *
+ *   - pre-charged from the arguments (the work is known up front, and charging
+ *     first avoids e.g. allocating a 50 MB string.rep result only to abort):
+ *     string.rep, string.gsub (subject), table.sort, cjson.decode,
+ *     cmsgpack.unpack;
+ *   - post-charged from the result (size unknown until produced):
+ *     string.gsub (result), table.concat, cjson.encode, cmsgpack.pack.
+ *
+ * Each wrapper repeats the original's argument checks before calling it, so
+ * argument errors still name the function ("bad argument #1 to 'rep'"): errors
+ * raised from a C function called by another C function lose the name. */
+
+#include "fuel.h"
+#include "eval_arena.h"
+#include "profile.h"
+#include <lauxlib.h>
+
+#define DEFAULT_FUEL_LIMIT 10000000
+/* Profiling builds count every instruction, so the hook fires on each one and
+ * charges one unit at a time. */
+#ifdef REDIS_LUA_WASM_PROFILE
+#define FUEL_HOOK_STEP 1
+#else
+#define FUEL_HOOK_STEP 1000
+#endif
+/* One unit of fuel per this many bytes copied, scanned or encoded: roughly what
+ * a byte loop in C gets through in the time of one interpreted instruction. */
+#define FUEL_BYTES_PER_UNIT 16
+
+static int64_t g_fuel_remaining = DEFAULT_FUEL_LIMIT;
+static int64_t g_fuel_limit = DEFAULT_FUEL_LIMIT;
+
+void fuel_set_limit(int64_t limit) {
+  g_fuel_limit = limit;
+}
+
+void fuel_reset(void) {
+  g_fuel_remaining = g_fuel_limit;
+}
+
+int64_t fuel_spent(void) {
+  return g_fuel_remaining < 0 ? g_fuel_limit : g_fuel_limit - g_fuel_remaining;
+}
+
+void fuel_charge(lua_State *L, int64_t units) {
+  g_fuel_remaining -= units;
+  if (g_fuel_remaining <= 0) {
+    luaL_error(L, "Script killed by fuel limit");
+  }
+}
+
+void fuel_charge_bytes(lua_State *L, double bytes) {
+  double units = bytes / FUEL_BYTES_PER_UNIT;
+  /* Clamp before converting: string.rep's len * n can exceed int64. */
+  fuel_charge(L, units > (double)g_fuel_limit ? g_fuel_limit + 1 : (int64_t)units);
+}
+
+static void fuel_hook(lua_State *L, lua_Debug *ar) {
+#ifdef REDIS_LUA_WASM_PROFILE
+  if (ar->event == LUA_HOOKCALL) {
+    profile_count_call(L, ar);
+    return;
+  }
+  profile_count_opcode(L);
+#else
+  (void)ar;
+#endif
+  eval_arena_poll(L);
+  fuel_charge(L, FUEL_HOOK_STEP);
+}
+
+void fuel_attach(lua_State *L) {
+#ifdef REDIS_LUA_WASM_PROFILE
+  lua_sethook(L, fuel_hook, LUA_MASKCOUNT | LUA_MASKCALL, FUEL_HOOK_STEP);
+#else
+  lua_sethook(L, fuel_hook, LUA_MASKCOUNT, FUEL_HOOK_STEP);
+#endif
+}
+
+/* Calls the wrapped function (upvalue 1) with the wrapper's arguments. Its
+ * results replace the arguments, starting at stack index 1. */
+static int call_wrapped(lua_State *L) {
+  int nargs = lua_gettop(L);
+  lua_pushvalue(L, lua_upvalueindex(1));
+  lua_insert(L, 1);
+  lua_call(L, nargs, LUA_MULTRET);
+  return lua_gettop(L);
+}
+
+/* Charges for the string result at index 1, if any. */
+static void charge_result_bytes(lua_State *L, int nresults) {
+  if (nresults > 0 && lua_type(L, 1) == LUA_TSTRING) {
+    fuel_charge_bytes(L, (double)lua_objlen(L, 1));
+  }
+}
+
+static int fuel_string_rep(lua_State *L) {
+  size_t len;
+  luaL_checklstring(L, 1, &len);
+  lua_Integer n = luaL_checkinteger(L, 2);
+  if (n > 0) {
+    fuel_charge_bytes(L, (double)len * (double)n);
+  }
+  return call_wrapped(L);
+}
+
+static int fuel_string_gsub(lua_State *L) {
+  size_t len;
+  luaL_checklstring(L, 1, &len);
+  luaL_checkstring(L, 2);
+  int tr = lua_type(L, 3);
+  luaL_argcheck(L,
+                tr == LUA_TNUMBER || tr == LUA_TSTRING || tr == LUA_TFUNCTION ||
+                    tr == LUA_TTABLE,
+                3, "string/function/table expected");
+  luaL_optinteger(L, 4, 0);
+  fuel_charge_bytes(L, (double)len);
+  int nresults = call_wrapped(L);
+  charge_result_bytes(L, nresults);
+  return nresults;
+}
+
+/* n log2 n comparisons. A Lua comparator is metered by the hook on top. */
+static int fuel_table_sort(lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
+  if (!lua_isnoneornil(L, 2)) {
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+  }
+  size_t n = lua_objlen(L, 1);
+  int64_t log2n = 0;
+  for (size_t m = n; m > 1; m >>= 1) {
+    log2n++;
+  }
+  fuel_charge(L, (int64_t)n * log2n);
+  return call_wrapped(L);
+}
+
+static int fuel_table_concat(lua_State *L) {
+  luaL_optstring(L, 2, "");
+  luaL_checktype(L, 1, LUA_TTABLE);
+  luaL_optinteger(L, 3, 1);
+  luaL_optinteger(L, 4, 0);
+  int nresults = call_wrapped(L);
+  charge_result_bytes(L, nresults);
+  return nresults;
+}
+
+static int fuel_cjson_encode(lua_State *L) {
+  luaL_argcheck(L, lua_gettop(L) == 1, 1, "expected 1 argument");
+  int nresults = call_wrapped(L);
+  charge_result_bytes(L, nresults);
+  return nresults;
+}
+
+static int fuel_cjson_decode(lua_State *L) {
+  size_t len;
+  luaL_argcheck(L, lua_gettop(L) == 1, 1, "expected 1 argument");
+  luaL_checklstring(L, 1, &len);
+  fuel_charge_bytes(L, (double)len);
+  return call_wrapped(L);
+}
+
+static int fuel_cmsgpack_pack(lua_State *L) {
+  if (lua_gettop(L) == 0) {
+    return luaL_argerror(L, 0, "MessagePack pack needs input.");
+  }
+  int nresults = call_wrapped(L);
+  charge_result_bytes(L, nresults);
+  return nresults;
+}
+
+static int fuel_cmsgpack_unpack(lua_State *L) {
+  size_t len;
+  luaL_checklstring(L, 1, &len);
+  fuel_charge_bytes(L, (double)len);
+  return call_wrapped(L);
+}
+
+/* lib[name] = closure(wrapper, lib[name]). Missing libraries or fields are
+ * skipped, so a build without a module still starts. */
+static void wrap_lib_function(lua_State *L, const char *lib, const char *name,
+                              lua_CFunction wrapper) {
+  lua_getglobal(L, lib);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return;
+  }
+  lua_getfield(L, -1, name);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 2);
+    return;
+  }
+  lua_pushcclosure(L, wrapper, 1);
+  lua_setfield(L, -2, name);
+  lua_pop(L, 1);
+}
+
+void fuel_wrap_library_costs(lua_State *L) {
+  wrap_lib_function(L, "string", "rep", fuel_string_rep);
+  wrap_lib_function(L, "string", "gsub", fuel_string_gsub);
+  wrap_lib_function(L, "table", "sort", fuel_table_sort);
+  wrap_lib_function(L, "table", "concat", fuel_table_concat);
+  wrap_lib_function(L, "cjson", "encode", fuel_cjson_encode);
+  wrap_lib_function(L, "cjson", "decode", fuel_cjson_decode);
+  wrap_lib_function(L, "cmsgpack", "pack", fuel_cmsgpack_pack);
+  wrap_lib_function(L, "cmsgpack", "unpack", fuel_cmsgpack_unpack);
+}
@@ -0,0 +1,35 @@
+#ifndef REDIS_LUA_WASM_FUEL_H
+#define REDIS_LUA_WASM_FUEL_H
+
+#include <lua.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Per-script fuel budget. The VM meters instructions through a count hook; C
+ * library functions that do work proportional to their input or output charge
+ * the same budget explicitly, so fuel bounds CPU time and not just bytecode. */
+
+void fuel_set_limit(int64_t limit);
+void fuel_reset(void);
+
+/* Fuel charged since the last fuel_reset, capped at the limit. The hook charges
+ * FUEL_HOOK_STEP instructions at a time, so this is that granular. */
+int64_t fuel_spent(void);
+
+/* Installs the instruction-count hook on L. */
+void fuel_attach(lua_State *L);
+
+/* Deducts `units` from the budget and raises "Script killed by fuel limit" once
+ * it is exhausted. Never returns in that case. */
+void fuel_charge(lua_State *L, int64_t units);
+
+/* fuel_charge for `bytes` produced or scanned (FUEL_BYTES_PER_UNIT per unit). */
+void fuel_charge_bytes(lua_State *L, double bytes);
+
+/* Replaces the costly bundled library functions (string.rep, string.gsub,
+ * table.sort, table.concat, cjson.encode/decode, cmsgpack.pack/unpack) with
+ * wrappers that charge fuel around the original. Must run after the libraries
+ * are opened and before globals protection. */
+void fuel_wrap_library_costs(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_FUEL_H */
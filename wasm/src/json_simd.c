@@ -0,0 +1,478 @@
+/* simd128 fast path for cjson.decode (SIMD=1 builds only).
+ *
+ * lua_cjson tokenizes one byte at a time. This decoder splits the work the way
+ * simdjson does:
+ *
+ *   1. Structural indexing, 16 bytes per step: compare each block against the
+ *      quote, backslash, whitespace and `{}[]:,` bytes, turn the results into
+ *      bitmasks, drop escaped quotes, derive the in-string mask with a prefix
+ *      XOR, and record the offset of every structural byte, every quote and
+ *      the first byte of every scalar outside strings.
+ *   2. Table construction: a recursive-descent walk over those offsets that
+ *      pushes Lua values exactly as lua_cjson does (rawseti for arrays, rawset
+ *      for objects, lightuserdata NULL for null, fpconv_strtod for numbers).
+ *
+ * The fast path only accepts what it can decode byte-for-byte like lua_cjson:
+ * RFC 8259 JSON with no raw control bytes inside strings, no "\u0000" or
+ * unpaired surrogates, nesting no deeper than JSON_SIMD_MAX_DEPTH and the
+ * configured decode_max_depth, and no larger than JSON_SIMD_MAX_BYTES.
+ * Anything else (including every malformed document) is handed unchanged to
+ * the original cjson.decode, so results, error messages and depth limits stay
+ * identical. */
+
+#ifdef REDIS_LUA_WASM_SIMD_JSON
+
+#include <lauxlib.h>
+#include <lua.h>
+#include <stdint.h>
+#include <string.h>
+#include <wasm_simd128.h>
+
+#include "fpconv.h"
+#include "json_simd.h"
+
+/* Recursion bound for the fast path; deeper documents use the fallback, which
+ * enforces decode_max_depth itself. Keeps the C stack use small. */
+#define JSON_SIMD_MAX_DEPTH 64
+/* Below this the index allocation outweighs the gain. */
+#define JSON_SIMD_MIN_BYTES 64
+/* The index takes 4 bytes per input byte. Above this, allocating it could fail
+ * where lua_cjson would still decode the document, so larger input takes the
+ * fallback: a 1 MiB document needs at most a 4 MiB index. */
+#define JSON_SIMD_MAX_BYTES ((size_t)1024 * 1024)
+#define DEFAULT_DECODE_MAX_DEPTH 1000
+
+typedef struct JsonParser {
+  const char *json;
+  size_t len;
+  const uint32_t *idx;
+  size_t count;
+  size_t pos;
+  int depth;
+  int max_depth;
+} JsonParser;
+
+/* ---- Stage 1: structural index ------------------------------------------ */
+
+static uint32_t eq_mask(v128_t v, char c) {
+  return (uint32_t)wasm_i8x16_bitmask(wasm_i8x16_eq(v, wasm_i8x16_splat(c)));
+}
+
+/* Writes the offsets of structurals, quotes and scalar starts into `out` (room
+ * for len entries) and returns how many, or -1 if the input needs the fallback
+ * (control bytes inside strings or an unterminated string). */
+static long index_structurals(const uint8_t *buf, size_t len, uint32_t *out) {
+  const v128_t space = wasm_i8x16_splat(0x20);
+  uint32_t in_string = 0; /* 0xffff while a string continues into the next block */
+  int escape_next = 0;    /* previous block ended in an unescaped backslash */
+  uint32_t prev_scalar = 0;
+  size_t n = 0;
+
+  for (size_t base = 0; base < len; base += 16) {
+    v128_t v;
+    if (len - base >= 16) {
+      v = wasm_v128_load(buf + base);
+    } else {
+      uint8_t tail[16];
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, buf + base, len - base);
+      v = wasm_v128_load(tail);
+    }
+
+    uint32_t quote = eq_mask(v, '"');
+    uint32_t backslash = eq_mask(v, '\\');
+    uint32_t ws = eq_mask(v, ' ') | eq_mask(v, '\t') | eq_mask(v, '\n') | eq_mask(v, '\r');
+    uint32_t op = eq_mask(v, '{') | eq_mask(v, '}') | eq_mask(v, '[') | eq_mask(v, ']') |
+                  eq_mask(v, ':') | eq_mask(v, ',');
+    uint32_t ctrl = (uint32_t)wasm_i8x16_bitmask(wasm_u8x16_lt(v, space));
+
+    /* Bytes preceded by an odd run of backslashes. Backslashes are rare
+     * outside escape-heavy strings, so resolve runs with a scalar loop. */
+    uint32_t escaped = 0;
+    if (backslash || escape_next) {
+      for (int i = 0; i < 16; i++) {
+        if (escape_next) {
+          escaped |= 1u << i;
+          escape_next = 0;
+        } else if (backslash & (1u << i)) {
+          escape_next = 1;
+        }
+      }
+    }
+    quote &= ~escaped;
+
+    /* Inclusive prefix XOR: set from an opening quote up to, not including,
+     * its closing quote. */
+    uint32_t inside = quote;
+    inside ^= inside << 1;
+    inside ^= inside << 2;
+    inside ^= inside << 4;
+    inside ^= inside << 8;
+    inside = (inside ^ in_string) & 0xffff;
+    in_string = (inside & 0x8000) ? 0xffff : 0;
+    uint32_t outside = ~inside & ~quote & 0xffff;
+
+    if (ctrl & ~(ws & outside)) {
+      return -1;
+    }
+
+    uint32_t scalar = ~(ws | op) & outside;
+    uint32_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+    prev_scalar = (scalar >> 15) & 1;
+
+    uint32_t emit = (op & outside) | quote | scalar_start;
+    while (emit) {
+      out[n++] = (uint32_t)base + (uint32_t)__builtin_ctz(emit);
+      emit &= emit - 1;
+    }
+  }
+  return in_string ? -1 : (long)n;
+}
+
+/* ---- Stage 2: table construction ----------------------------------------- */
+
+static int is_delimiter(const JsonParser *p, size_t at) {
+  if (at >= p->len) {
+    return 1;
+  }
+  switch (p->json[at]) {
+    case ' ': case '\t': case '\n': case '\r':
+    case '{': case '}': case '[': case ']': case ':': case ',':
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int next_token(JsonParser *p, size_t *at) {
+  if (p->pos >= p->count) {
+    return -1;
+  }
+  *at = p->idx[p->pos++];
+  return 0;
+}
+
+static int peek_char(const JsonParser *p) {
+  return p->pos < p->count ? p->json[p->idx[p->pos]] : -1;
+}
+
+static int hex4(const char *s, uint32_t *out) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = s[i];
+    v <<= 4;
+    if (c >= '0' && c <= '9') {
+      v |= (uint32_t)(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      v |= (uint32_t)(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      v |= (uint32_t)(c - 'A' + 10);
+    } else {
+      return -1;
+    }
+  }
+  *out = v;
+  return 0;
+}
+
+static void add_utf8(luaL_Buffer *b, uint32_t cp) {
+  if (cp < 0x80) {
+    luaL_addchar(b, (char)cp);
+  } else if (cp < 0x800) {
+    luaL_addchar(b, (char)(0xc0 | (cp >> 6)));
+    luaL_addchar(b, (char)(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    luaL_addchar(b, (char)(0xe0 | (cp >> 12)));
+    luaL_addchar(b, (char)(0x80 | ((cp >> 6) & 0x3f)));
+    luaL_addchar(b, (char)(0x80 | (cp & 0x3f)));
+  } else {
+    luaL_addchar(b, (char)(0xf0 | (cp >> 18)));
+    luaL_addchar(b, (char)(0x80 | ((cp >> 12) & 0x3f)));
+    luaL_addchar(b, (char)(0x80 | ((cp >> 6) & 0x3f)));
+    luaL_addchar(b, (char)(0x80 | (cp & 0x3f)));
+  }
+}
+
+static int push_unescaped(lua_State *L, const char *s, size_t len) {
+  luaL_Buffer b;
+  luaL_buffinit(L, &b);
+  size_t i = 0;
+  while (i < len) {
+    const char *bs = memchr(s + i, '\\', len - i);
+    size_t run = bs ? (size_t)(bs - (s + i)) : len - i;
+    luaL_addlstring(&b, s + i, run);
+    i += run;
+    if (i >= len) {
+      break;
+    }
+    if (i + 1 >= len) {
+      return -1;
+    }
+    char c = s[i + 1];
+    i += 2;
+    switch (c) {
+      case '"': luaL_addchar(&b, '"'); break;
+      case '\\': luaL_addchar(&b, '\\'); break;
+      case '/': luaL_addchar(&b, '/'); break;
+      case 'b': luaL_addchar(&b, '\b'); break;
+      case 'f': luaL_addchar(&b, '\f'); break;
+      case 'n': luaL_addchar(&b, '\n'); break;
+      case 'r': luaL_addchar(&b, '\r'); break;
+      case 't': luaL_addchar(&b, '\t'); break;
+      case 'u': {
+        uint32_t cp;
+        if (i + 4 > len || hex4(s + i, &cp) != 0 || cp == 0) {
+          return -1;
+        }
+        i += 4;
+        if (cp >= 0xdc00 && cp <= 0xdfff) {
+          return -1;
+        }
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+          uint32_t lo;
+          if (i + 6 > len || s[i] != '\\' || s[i + 1] != 'u' || hex4(s + i + 2, &lo) != 0 ||
+              lo < 0xdc00 || lo > 0xdfff) {
+            return -1;
+          }
+          i += 6;
+          cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+        }
+        add_utf8(&b, cp);
+        break;
+      }
+      default:
+        return -1;
+    }
+  }
+  luaL_pushresult(&b);
+  return 0;
+}
+
+/* The opening quote was consumed at `open`; the closing quote is the next
+ * index entry (escaped quotes were never indexed). */
+static int parse_string(lua_State *L, JsonParser *p, size_t open) {
+  size_t close;
+  if (next_token(p, &close) != 0 || p->json[close] != '"') {
+    return -1;
+  }
+  const char *s = p->json + open + 1;
+  size_t len = close - open - 1;
+  if (!memchr(s, '\\', len)) {
+    lua_pushlstring(L, s, len);
+    return 0;
+  }
+  return push_unescaped(L, s, len);
+}
+
+static int parse_literal(lua_State *L, JsonParser *p, size_t at, const char *lit, size_t n) {
+  if (at + n > p->len || memcmp(p->json + at, lit, n) != 0 || !is_delimiter(p, at + n)) {
+    return -1;
+  }
+  switch (lit[0]) {
+    case 't': lua_pushboolean(L, 1); break;
+    case 'f': lua_pushboolean(L, 0); break;
+    default: lua_pushlightuserdata(L, NULL); break; /* cjson.null */
+  }
+  return 0;
+}
+
+static int is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/* -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? then fpconv_strtod, the
+ * conversion lua_cjson uses, so the value is bit-identical. */
+static int parse_number(lua_State *L, JsonParser *p, size_t at) {
+  const char *s = p->json;
+  size_t i = at;
+  if (i < p->len && s[i] == '-') {
+    i++;
+  }
+  if (i < p->len && s[i] == '0') {
+    i++;
+  } else if (i < p->len && s[i] >= '1' && s[i] <= '9') {
+    while (i < p->len && is_digit(s[i])) i++;
+  } else {
+    return -1;
+  }
+  if (i < p->len && s[i] == '.') {
+    i++;
+    if (i >= p->len || !is_digit(s[i])) {
+      return -1;
+    }
+    while (i < p->len && is_digit(s[i])) i++;
+  }
+  if (i < p->len && (s[i] == 'e' || s[i] == 'E')) {
+    i++;
+    if (i < p->len && (s[i] == '+' || s[i] == '-')) {
+      i++;
+    }
+    if (i >= p->len || !is_digit(s[i])) {
+      return -1;
+    }
+    while (i < p->len && is_digit(s[i])) i++;
+  }
+  if (!is_delimiter(p, i)) {
+    return -1;
+  }
+  char *end = NULL;
+  double value = fpconv_strtod(s + at, &end);
+  if (end != s + i) {
+    return -1;
+  }
+  lua_pushnumber(L, value);
+  return 0;
+}
+
+static int parse_value(lua_State *L, JsonParser *p);
+
+static int enter_container(lua_State *L, JsonParser *p) {
+  if (++p->depth > p->max_depth || !lua_checkstack(L, LUA_MINSTACK)) {
+    return -1;
+  }
+  lua_newtable(L);
+  return 0;
+}
+
+static int parse_array(lua_State *L, JsonParser *p) {
+  size_t at;
+  if (enter_container(L, p) != 0) {
+    return -1;
+  }
+  if (peek_char(p) == ']') {
+    p->pos++;
+    p->depth--;
+    return 0;
+  }
+  for (int i = 1;; i++) {
+    if (parse_value(L, p) != 0) {
+      return -1;
+    }
+    lua_rawseti(L, -2, i);
+    if (next_token(p, &at) != 0) {
+      return -1;
+    }
+    if (p->json[at] == ']') {
+      break;
+    }
+    if (p->json[at] != ',') {
+      return -1;
+    }
+  }
+  p->depth--;
+  return 0;
+}
+
+static int parse_object(lua_State *L, JsonParser *p) {
+  size_t at;
+  if (enter_container(L, p) != 0) {
+    return -1;
+  }
+  if (peek_char(p) == '}') {
+    p->pos++;
+    p->depth--;
+    return 0;
+  }
+  for (;;) {
+    if (next_token(p, &at) != 0 || p->json[at] != '"' || parse_string(L, p, at) != 0) {
+      return -1;
+    }
+    if (next_token(p, &at) != 0 || p->json[at] != ':') {
+      return -1;
+    }
+    if (parse_value(L, p) != 0) {
+      return -1;
+    }
+    lua_rawset(L, -3);
+    if (next_token(p, &at) != 0) {
+      return -1;
+    }
+    if (p->json[at] == '}') {
+      break;
+    }
+    if (p->json[at] != ',') {
+      return -1;
+    }
+  }
+  p->depth--;
+  return 0;
+}
+
+static int parse_value(lua_State *L, JsonParser *p) {
+  size_t at;
+  if (next_token(p, &at) != 0) {
+    return -1;
+  }
+  char c = p->json[at];
+  switch (c) {
+    case '{': return parse_object(L, p);
+    case '[': return parse_array(L, p);
+    case '"': return parse_string(L, p, at);
+    case 't': return parse_literal(L, p, at, "true", 4);
+    case 'f': return parse_literal(L, p, at, "false", 5);
+    case 'n': return parse_literal(L, p, at, "null", 4);
+    default:
+      return (c == '-' || is_digit(c)) ? parse_number(L, p, at) : -1;
+  }
+}
+
+/* ---- cjson.decode replacement --------------------------------------------- */
+
+/* cjson.decode_max_depth() with no argument returns the current setting. */
+static int configured_max_depth(lua_State *L) {
+  int depth = DEFAULT_DECODE_MAX_DEPTH;
+  if (lua_isfunction(L, lua_upvalueindex(2))) {
+    lua_pushvalue(L, lua_upvalueindex(2));
+    lua_call(L, 0, 1);
+    if (lua_isnumber(L, -1)) {
+      depth = (int)lua_tointeger(L, -1);
+    }
+    lua_pop(L, 1);
+  }
+  return depth;
+}
+
+/* upvalue 1: original cjson.decode; upvalue 2: cjson.decode_max_depth. */
+static int json_simd_decode(lua_State *L) {
+  size_t len;
+  luaL_argcheck(L, lua_gettop(L) == 1, 1, "expected 1 argument");
+  const char *json = luaL_checklstring(L, 1, &len);
+
+  if (len >= JSON_SIMD_MIN_BYTES && len <= JSON_SIMD_MAX_BYTES) {
+    int max_depth = configured_max_depth(L);
+    uint32_t *idx = (uint32_t *)lua_newuserdata(L, len * sizeof(uint32_t));
+    long count = index_structurals((const uint8_t *)json, len, idx);
+    if (count > 0) {
+      JsonParser p = {json, len, idx, (size_t)count, 0, 0,
+                      max_depth < JSON_SIMD_MAX_DEPTH ? max_depth : JSON_SIMD_MAX_DEPTH};
+      if (parse_value(L, &p) == 0 && p.pos == p.count) {
+        return 1;
+      }
+    }
+    lua_settop(L, 1);
+  }
+
+  lua_pushvalue(L, lua_upvalueindex(1));
+  lua_insert(L, 1);
+  lua_call(L, 1, 1);
+  return 1;
+}
+
+void json_simd_install(lua_State *L) {
+  lua_getglobal(L, "cjson");
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return;
+  }
+  lua_getfield(L, -1, "decode");
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 2);
+    return;
+  }
+  lua_getfield(L, -2, "decode_max_depth");
+  lua_pushcclosure(L, json_simd_decode, 2);
+  lua_setfield(L, -2, "decode");
+  lua_pop(L, 1);
+}
+
+#endif /* REDIS_LUA_WASM_SIMD_JSON */
@@ -0,0 +1,16 @@
+#ifndef REDIS_LUA_WASM_JSON_SIMD_H
+#define REDIS_LUA_WASM_JSON_SIMD_H
+
+/* simd128 fast path for cjson.decode. Only built with SIMD=1
+ * (-msimd128 -DREDIS_LUA_WASM_SIMD_JSON). */
+#ifdef REDIS_LUA_WASM_SIMD_JSON
+
+#include <lua.h>
+
+/* Replaces cjson.decode with the fast path, keeping the original as its
+ * fallback. Run right after the cjson module is loaded. */
+void json_simd_install(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_SIMD_JSON */
+
+#endif /* REDIS_LUA_WASM_JSON_SIMD_H */
@@ -0,0 +1,191 @@
+/* Compile-time limits for script loading.
+ *
+ * luaL_loadbuffer runs without fuel (the count hook only fires for executing
+ * code) and without size limits, so a large generated script can stall the
+ * engine and fill its heap before anything runs. Checked here, in order:
+ *
+ *   - maxScriptBytes, before the parser starts;
+ *   - maxParseMs, from the chunk reader: with a budget the source is handed to
+ *     the lexer LOAD_SLICE bytes at a time and the clock is read before each
+ *     slice, so the check runs as the parser consumes input;
+ *   - function, constant and function-nesting counts, by walking the compiled
+ *     prototypes before the chunk is returned. Block nesting inside a function
+ *     is already bounded by the parser (LUAI_MAXCCALLS).
+ *
+ * Violations are ordinary load errors: the message is left on the stack like a
+ * syntax error's, and callers reply with it through their load-error path.
+ * Scripts compiling code at run time (loadstring, load) go through the same
+ * checks, and installed bytecode gets the prototype checks after undump. */
+
+#include <emscripten.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lobject.h"
+
+#include "load_limits.h"
+
+#define LOAD_SLICE 4096
+
+static uint32_t g_max_script_bytes = 0;
+static uint32_t g_max_functions = 0;
+static uint32_t g_max_constants = 0;
+static uint32_t g_max_nesting = 0;
+static uint32_t g_max_parse_ms = 0;
+
+void load_limits_set(uint32_t max_script_bytes, uint32_t max_functions, uint32_t max_constants,
+                     uint32_t max_nesting, uint32_t max_parse_ms) {
+  g_max_script_bytes = max_script_bytes;
+  g_max_functions = max_functions;
+  g_max_constants = max_constants;
+  g_max_nesting = max_nesting;
+  g_max_parse_ms = max_parse_ms;
+}
+
+typedef struct SliceReader {
+  const char *data;
+  size_t len;
+  double deadline;
+} SliceReader;
+
+/* Runs inside lua_load's protected call, so raising here becomes the load
+ * error. */
+static const char *slice_read(lua_State *L, void *ud, size_t *size) {
+  SliceReader *r = (SliceReader *)ud;
+  if (r->len == 0) {
+    return NULL;
+  }
+  if (emscripten_get_now() > r->deadline) {
+    lua_pushfstring(L, "ERR script parse exceeded maxParseMs (%d)", (int)g_max_parse_ms);
+    lua_error(L);
+  }
+  const char *slice = r->data;
+  *size = r->len < LOAD_SLICE ? r->len : LOAD_SLICE;
+  r->data += *size;
+  r->len -= *size;
+  return slice;
+}
+
+typedef struct ProtoCounts {
+  uint32_t functions;
+  uint32_t constants;
+  uint32_t nesting;
+} ProtoCounts;
+
+/* Recursion depth is bounded by the parser's own nesting limit. */
+static void count_protos(const Proto *p, uint32_t depth, ProtoCounts *c) {
+  c->functions++;
+  c->constants += (uint32_t)p->sizek;
+  if (depth > c->nesting) {
+    c->nesting = depth;
+  }
+  for (int i = 0; i < p->sizep; i++) {
+    count_protos(p->p[i], depth + 1, c);
+  }
+}
+
+int load_limits_check(lua_State *L) {
+  if (!g_max_functions && !g_max_constants && !g_max_nesting) {
+    return 0;
+  }
+  const Closure *cl = (const Closure *)lua_topointer(L, -1);
+  ProtoCounts c = {0, 0, 0};
+  count_protos(cl->l.p, 0, &c);
+  if (g_max_functions && c.functions > g_max_functions) {
+    lua_pop(L, 1);
+    lua_pushfstring(L, "ERR script defines %d functions, over maxScriptFunctions (%d)",
+                    (int)c.functions, (int)g_max_functions);
+    return -1;
+  }
+  if (g_max_constants && c.constants > g_max_constants) {
+    lua_pop(L, 1);
+    lua_pushfstring(L, "ERR script has %d constants, over maxScriptConstants (%d)",
+                    (int)c.constants, (int)g_max_constants);
+    return -1;
+  }
+  if (g_max_nesting && c.nesting > g_max_nesting) {
+    lua_pop(L, 1);
+    lua_pushfstring(L, "ERR script nests functions %d deep, over maxScriptNesting (%d)",
+                    (int)c.nesting, (int)g_max_nesting);
+    return -1;
+  }
+  return 0;
+}
+
+int load_limited(lua_State *L, const char *src, size_t len, const char *chunkname) {
+  if (g_max_script_bytes && len > g_max_script_bytes) {
+    lua_pushfstring(L, "ERR script of %d bytes exceeds maxScriptBytes (%d)", (int)len,
+                    (int)g_max_script_bytes);
+    return LUA_ERRSYNTAX;
+  }
+  int status;
+  if (g_max_parse_ms) {
+    SliceReader reader = {src, len, emscripten_get_now() + g_max_parse_ms};
+    status = lua_load(L, slice_read, &reader, chunkname);
+  } else {
+    status = luaL_loadbuffer(L, src, len, chunkname);
+  }
+  if (status != 0) {
+    return status;
+  }
+  return load_limits_check(L) != 0 ? LUA_ERRSYNTAX : 0;
+}
+
+/* lbaselib's load_aux: the chunk, or nil and the message. */
+static int load_result(lua_State *L, int status) {
+  if (status == 0) {
+    return 1;
+  }
+  lua_pushnil(L);
+  lua_insert(L, -2);
+  return 2;
+}
+
+static int limited_loadstring(lua_State *L) {
+  size_t len;
+  const char *src = luaL_checklstring(L, 1, &len);
+  const char *chunkname = luaL_optstring(L, 2, src);
+  return load_result(L, load_limited(L, src, len, chunkname));
+}
+
+/* load(func [, chunkname]): the reader runs (under fuel) until it returns nil
+ * or an empty string, then the collected source is compiled in one piece. As in
+ * lbaselib, where the reader runs inside lua_load's protected call, an error
+ * it raises becomes load's nil and message rather than propagating. */
+static int limited_load(lua_State *L) {
+  const char *chunkname = luaL_optstring(L, 2, "=(load)");
+  luaL_checktype(L, 1, LUA_TFUNCTION);
+  lua_settop(L, 2);
+  luaL_Buffer b;
+  luaL_buffinit(L, &b);
+  for (;;) {
+    lua_pushvalue(L, 1);
+    if (lua_pcall(L, 0, 1, 0) != 0) {
+      return load_result(L, LUA_ERRRUN);
+    }
+    if (lua_isnil(L, -1) || (lua_isstring(L, -1) && lua_objlen(L, -1) == 0)) {
+      lua_pop(L, 1);
+      break;
+    }
+    if (!lua_isstring(L, -1)) {
+      lua_pop(L, 1);
+      lua_pushliteral(L, "reader function must return a string");
+      return load_result(L, LUA_ERRSYNTAX);
+    }
+    luaL_addvalue(&b);
+  }
+  luaL_pushresult(&b);
+  size_t len;
+  const char *src = lua_tolstring(L, -1, &len);
+  return load_result(L, load_limited(L, src, len, chunkname));
+}
+
+void load_limits_register(lua_State *L) {
+  lua_pushcfunction(L, limited_loadstring);
+  lua_setglobal(L, "loadstring");
+  lua_pushcfunction(L, limited_load);
+  lua_setglobal(L, "load");
+}
@@ -0,0 +1,28 @@
+#ifndef REDIS_LUA_WASM_LOAD_LIMITS_H
+#define REDIS_LUA_WASM_LOAD_LIMITS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lua.h>
+
+/* Limits on compiling a script. The fuel hook does not run while the parser
+ * does, so these bound what a script costs before its first instruction. 0
+ * disables a limit. */
+void load_limits_set(uint32_t max_script_bytes, uint32_t max_functions, uint32_t max_constants,
+                     uint32_t max_nesting, uint32_t max_parse_ms);
+
+/* luaL_loadbuffer under the limits: pushes the compiled chunk and returns 0,
+ * or returns non-zero with the error message on the stack. */
+int load_limited(lua_State *L, const char *src, size_t len, const char *chunkname);
+
+/* Checks the function, constant and nesting counts of the chunk on top of the
+ * stack, for chunks that did not come through load_limited (undumped
+ * bytecode). Returns 0, or -1 with the chunk replaced by the error message. */
+int load_limits_check(lua_State *L);
+
+/* Replaces the global loadstring and load with versions that compile through
+ * load_limited, so scripts cannot use them to skip the limits. */
+void load_limits_register(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_LOAD_LIMITS_H */
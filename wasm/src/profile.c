@@ -0,0 +1,223 @@
+/* Opcode and C-function frequency histograms (PROFILE=1 builds only).
+ *
+ * The vendored VM is left untouched: the fuel hook runs with a count of 1 and
+ * reads the instruction about to execute from L->savedpc (traceexec stores pc
+ * before calling the hook), and a call hook looks the callee up in a registry
+ * table mapping C functions to counter slots. Both are far too slow for
+ * production, which is why the whole file is behind the build flag.
+ *
+ * profile_take() returns the counts accumulated since the previous call (the
+ * host calls it after every eval and aggregates per script sha) and zeroes
+ * them. Blob layout, two sections (opcodes, then C functions), nonzero entries
+ * only:
+ *
+ *   [count: u32] { [name_len: u32][name bytes][calls: u64] } * count */
+
+#ifdef REDIS_LUA_WASM_PROFILE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lobject.h"
+#include "lopcodes.h"
+#include "lstate.h"
+
+#include "../include/abi.h"
+#include "profile.h"
+
+#define PROFILE_MAX_CFUNCS 512
+#define PROFILE_CFUNC_MAP "redis_lua_wasm.profile.cfuncs"
+#define PROFILE_CFUNC_NAMES "redis_lua_wasm.profile.names"
+
+static uint64_t g_opcode_counts[NUM_OPCODES];
+static uint64_t g_cfunc_counts[PROFILE_MAX_CFUNCS];
+static int g_cfunc_count = 0;
+static lua_State *g_profiled_state = NULL;
+
+/* map[func] = slot and names[slot] = [prefix.]name for the C function at -1,
+ * unless it already has a slot. Pops the function. */
+static void index_cfunction(lua_State *L, int map, int names, const char *prefix,
+                            const char *name) {
+  if (!lua_iscfunction(L, -1) || g_cfunc_count >= PROFILE_MAX_CFUNCS) {
+    lua_pop(L, 1);
+    return;
+  }
+  lua_pushvalue(L, -1);
+  lua_rawget(L, map);
+  if (!lua_isnil(L, -1)) {
+    lua_pop(L, 2);
+    return;
+  }
+  lua_pop(L, 1);
+  int slot = g_cfunc_count++;
+  lua_pushinteger(L, slot);
+  lua_rawset(L, map);
+  if (prefix) {
+    lua_pushfstring(L, "%s.%s", prefix, name);
+  } else {
+    lua_pushstring(L, name);
+  }
+  lua_rawseti(L, names, slot);
+}
+
+static void index_table(lua_State *L, int tbl, int map, int names, const char *prefix) {
+  lua_pushnil(L);
+  while (lua_next(L, tbl) != 0) {
+    if (lua_type(L, -2) == LUA_TSTRING) {
+      lua_pushvalue(L, -1);
+      index_cfunction(L, map, names, prefix, lua_tostring(L, -3));
+    }
+    lua_pop(L, 1);
+  }
+}
+
+void profile_index_cfunctions(lua_State *L) {
+  g_profiled_state = L;
+  g_cfunc_count = 0;
+  memset(g_opcode_counts, 0, sizeof(g_opcode_counts));
+  memset(g_cfunc_counts, 0, sizeof(g_cfunc_counts));
+
+  lua_newtable(L);
+  int map = lua_gettop(L);
+  lua_newtable(L);
+  int names = lua_gettop(L);
+
+  /* Top-level C functions first (print, tostring, ...), then one level into each
+   * library table. A function reachable twice (e.g. through the `server` alias)
+   * keeps the first name it was found under. */
+  index_table(L, LUA_GLOBALSINDEX, map, names, NULL);
+  lua_pushnil(L);
+  while (lua_next(L, LUA_GLOBALSINDEX) != 0) {
+    if (lua_type(L, -2) == LUA_TSTRING && lua_istable(L, -1) &&
+        !lua_rawequal(L, -1, LUA_GLOBALSINDEX)) {
+      index_table(L, lua_gettop(L), map, names, lua_tostring(L, -2));
+    }
+    lua_pop(L, 1);
+  }
+
+  luaL_getmetatable(L, "redis.strbuf");
+  if (lua_istable(L, -1)) {
+    lua_getfield(L, -1, "__index");
+    if (lua_istable(L, -1)) {
+      index_table(L, lua_gettop(L), map, names, "strbuf");
+    }
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+
+  lua_setfield(L, LUA_REGISTRYINDEX, PROFILE_CFUNC_NAMES);
+  lua_setfield(L, LUA_REGISTRYINDEX, PROFILE_CFUNC_MAP);
+}
+
+void profile_count_opcode(lua_State *L) {
+  if (L->savedpc) {
+    g_opcode_counts[GET_OPCODE(L->savedpc[-1])]++;
+  }
+}
+
+void profile_count_call(lua_State *L, lua_Debug *ar) {
+  if (!lua_getinfo(L, "f", ar)) {
+    return;
+  }
+  if (lua_iscfunction(L, -1)) {
+    lua_getfield(L, LUA_REGISTRYINDEX, PROFILE_CFUNC_MAP);
+    lua_pushvalue(L, -2);
+    lua_rawget(L, -2);
+    if (lua_isnumber(L, -1)) {
+      g_cfunc_counts[lua_tointeger(L, -1)]++;
+    }
+    lua_pop(L, 2);
+  }
+  lua_pop(L, 1);
+}
+
+typedef struct Blob {
+  uint8_t *data;
+  size_t len;
+  size_t cap;
+} Blob;
+
+static int blob_append(Blob *b, const void *src, size_t n) {
+  if (b->len + n > b->cap) {
+    size_t cap = b->cap ? b->cap * 2 : 1024;
+    while (cap < b->len + n) {
+      cap *= 2;
+    }
+    uint8_t *data = realloc(b->data, cap);
+    if (!data) {
+      return -1;
+    }
+    b->data = data;
+    b->cap = cap;
+  }
+  memcpy(b->data + b->len, src, n);
+  b->len += n;
+  return 0;
+}
+
+/* wasm is little-endian, so native u32/u64 copies are the wire format. */
+static int blob_entry(Blob *b, const char *name, size_t name_len, uint64_t calls) {
+  uint32_t len32 = (uint32_t)name_len;
+  return blob_append(b, &len32, 4) || blob_append(b, name, name_len) ||
+         blob_append(b, &calls, 8);
+}
+
+static int blob_opcodes(Blob *b) {
+  uint32_t count = 0;
+  for (int op = 0; op < NUM_OPCODES; op++) {
+    count += g_opcode_counts[op] != 0;
+  }
+  if (blob_append(b, &count, 4)) {
+    return -1;
+  }
+  for (int op = 0; op < NUM_OPCODES; op++) {
+    if (g_opcode_counts[op] &&
+        blob_entry(b, luaP_opnames[op], strlen(luaP_opnames[op]), g_opcode_counts[op])) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int blob_cfunctions(Blob *b, lua_State *L) {
+  uint32_t count = 0;
+  for (int slot = 0; slot < g_cfunc_count; slot++) {
+    count += g_cfunc_counts[slot] != 0;
+  }
+  if (blob_append(b, &count, 4)) {
+    return -1;
+  }
+  lua_getfield(L, LUA_REGISTRYINDEX, PROFILE_CFUNC_NAMES);
+  int rc = 0;
+  for (int slot = 0; slot < g_cfunc_count && rc == 0; slot++) {
+    if (!g_cfunc_counts[slot]) {
+      continue;
+    }
+    size_t name_len = 0;
+    lua_rawgeti(L, -1, slot);
+    const char *name = lua_tolstring(L, -1, &name_len);
+    rc = blob_entry(b, name ? name : "?", name ? name_len : 1, g_cfunc_counts[slot]);
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  return rc;
+}
+
+PtrLen profile_take(void) {
+  Blob b = {NULL, 0, 0};
+  if (!g_profiled_state || blob_opcodes(&b) || blob_cfunctions(&b, g_profiled_state)) {
+    free(b.data);
+    return (PtrLen){0, 0};
+  }
+  memset(g_opcode_counts, 0, sizeof(g_opcode_counts));
+  memset(g_cfunc_counts, 0, sizeof(g_cfunc_counts));
+  return (PtrLen){(uint32_t)(uintptr_t)b.data, (uint32_t)b.len};
+}
+
+#endif /* REDIS_LUA_WASM_PROFILE */
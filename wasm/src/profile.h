@@ -0,0 +1,22 @@
+#ifndef REDIS_LUA_WASM_PROFILE_H
+#define REDIS_LUA_WASM_PROFILE_H
+
+/* Opcode and C-function call histograms. Only built with PROFILE=1
+ * (-DREDIS_LUA_WASM_PROFILE); release builds compile none of it. */
+#ifdef REDIS_LUA_WASM_PROFILE
+
+#include <lua.h>
+
+/* Maps every C function reachable from the globals (one table level deep, plus
+ * the redis.strbuf methods) to a counter named after it. Run before globals
+ * protection, after all libraries and the redis API are registered. */
+void profile_index_cfunctions(lua_State *L);
+
+/* From the VM hook: count the instruction about to execute (count hook with a
+ * step of 1) or a function call (call hook). */
+void profile_count_opcode(lua_State *L);
+void profile_count_call(lua_State *L, lua_Debug *ar);
+
+#endif /* REDIS_LUA_WASM_PROFILE */
+
+#endif /* REDIS_LUA_WASM_PROFILE_H */
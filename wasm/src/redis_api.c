@@ -1,11 +1,19 @@
+#define LUA_CORE
+
 #include "../include/abi.h"
+#include "fuel.h"
 #include "redis_api.h"
 #include <lauxlib.h>
 #include <lua.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "lgc.h"
+#include "lmem.h"
+#include "lstate.h"
+
 #define LOG_DEBUG 0
 #define LOG_VERBOSE 1
 #define LOG_NOTICE 2
@@ -119,6 +127,10 @@ static int arg_to_bytes(lua_State *L, int idx, const char **out, size_t *len) {
       *out = lua_tolstring(L, idx, len);
       return 0;
     }
+    case LUA_TUSERDATA:
+      // A redis.strbuf builder is passed as its bytes, without first
+      // materializing a Lua string.
+      return redis_strbuf_contents(L, idx, out, len) ? 0 : -1;
     default:
       return -1;
   }
@@ -522,7 +534,160 @@ int apply_redis_props(lua_State *L, const uint8_t *buf, size_t len) {
   return 0;
 }
 
+/* redis.strbuf(): a native string builder. Appends are amortized O(1) and never
+ * intern intermediate strings, so scripts assembling large CSV/JSON-like output
+ * avoid the O(n^2) cost of `s = s .. piece`. The builder is a full userdata
+ * whose methods live in a readonly metatable; encode_lua_value writes it
+ * straight out as a bulk reply.
+ *
+ * The buffer is allocated through luaM_realloc_, like the VM's own vectors: it
+ * counts towards the GC debt, heap_bytes and allocation tracking, comes from
+ * the eval arena during an eval, and a failed allocation is an ordinary Lua
+ * memory error rather than an abort. */
+#define STRBUF_METATABLE "redis.strbuf"
+
+/* Growth doubles the buffer, so a builder at the cap holds up to 1.5x it during
+ * a resize. 16 MiB keeps that well inside the 64 MiB linear memory. */
+#define STRBUF_MAX_LEN ((size_t)16 * 1024 * 1024)
+#define STRBUF_MIN_CAP 64
+
+typedef struct StrBuf {
+  char *buf;
+  size_t len;
+  size_t cap;
+} StrBuf;
+
+static StrBuf *check_strbuf(lua_State *L, int idx) {
+  return (StrBuf *)luaL_checkudata(L, idx, STRBUF_METATABLE);
+}
+
+static void strbuf_append_checked(lua_State *L, StrBuf *sb, const char *data, size_t len) {
+  if (len > STRBUF_MAX_LEN - sb->len) {
+    luaL_error(L, "ERR strbuf exceeds maximum size");
+  }
+  fuel_charge_bytes(L, (double)len);
+  if (sb->len + len > sb->cap) {
+    size_t cap = sb->cap ? sb->cap : STRBUF_MIN_CAP;
+    while (cap < sb->len + len) {
+      cap *= 2;
+    }
+    if (cap > STRBUF_MAX_LEN) {
+      cap = STRBUF_MAX_LEN;
+    }
+    luaC_checkGC(L);
+    /* Raises LUA_ERRMEM and leaves sb untouched if the allocation fails. */
+    sb->buf = (char *)luaM_realloc_(L, sb->buf, sb->cap, cap);
+    sb->cap = cap;
+  }
+  memcpy(sb->buf + sb->len, data, len);
+  sb->len += len;
+}
+
+int redis_strbuf_contents(lua_State *L, int idx, const char **data, size_t *len) {
+  void *ud = lua_touserdata(L, idx);
+  if (!ud || !lua_getmetatable(L, idx)) {
+    return 0;
+  }
+  luaL_getmetatable(L, STRBUF_METATABLE);
+  int is_strbuf = lua_rawequal(L, -1, -2);
+  lua_pop(L, 2);
+  if (!is_strbuf) {
+    return 0;
+  }
+  StrBuf *sb = (StrBuf *)ud;
+  *data = sb->buf ? sb->buf : "";
+  *len = sb->len;
+  return 1;
+}
+
+static int l_redis_strbuf(lua_State *L) {
+  StrBuf *sb = (StrBuf *)lua_newuserdata(L, sizeof(StrBuf));
+  sb->buf = NULL;
+  sb->len = 0;
+  sb->cap = 0;
+  luaL_getmetatable(L, STRBUF_METATABLE);
+  lua_setmetatable(L, -2);
+  return 1;
+}
+
+/* buf:append(...) appends each string (numbers are coerced, as with `..`) and
+ * returns the builder so calls can be chained. */
+static int l_strbuf_append(lua_State *L) {
+  StrBuf *sb = check_strbuf(L, 1);
+  int argc = lua_gettop(L);
+  for (int i = 2; i <= argc; i++) {
+    size_t len = 0;
+    const char *data = luaL_checklstring(L, i, &len);
+    strbuf_append_checked(L, sb, data, len);
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+/* buf:append_number(n) formats n exactly like tostring(n) without creating the
+ * intermediate string. */
+static int l_strbuf_append_number(lua_State *L) {
+  StrBuf *sb = check_strbuf(L, 1);
+  lua_Number n = luaL_checknumber(L, 2);
+  char tmp[LUAI_MAXNUMBER2STR];
+  int len = snprintf(tmp, sizeof(tmp), LUA_NUMBER_FMT, n);
+  strbuf_append_checked(L, sb, tmp, (size_t)len);
+  lua_settop(L, 1);
+  return 1;
+}
+
+static int l_strbuf_tostring(lua_State *L) {
+  StrBuf *sb = check_strbuf(L, 1);
+  lua_pushlstring(L, sb->buf ? sb->buf : "", sb->len);
+  return 1;
+}
+
+static int l_strbuf_len(lua_State *L) {
+  StrBuf *sb = check_strbuf(L, 1);
+  lua_pushnumber(L, (lua_Number)sb->len);
+  return 1;
+}
+
+static int l_strbuf_gc(lua_State *L) {
+  StrBuf *sb = check_strbuf(L, 1);
+  luaM_freemem(L, sb->buf, sb->cap);
+  sb->buf = NULL;
+  sb->len = 0;
+  sb->cap = 0;
+  return 0;
+}
+
+/* The metatable lives in the registry, out of reach of enable_globals_protection's
+ * walk from the globals table, so it and its method table are locked here. */
+static void register_strbuf_metatable(lua_State *L) {
+  luaL_newmetatable(L, STRBUF_METATABLE);
+
+  lua_newtable(L);
+  lua_pushcfunction(L, l_strbuf_append);
+  lua_setfield(L, -2, "append");
+  lua_pushcfunction(L, l_strbuf_append_number);
+  lua_setfield(L, -2, "append_number");
+  lua_pushcfunction(L, l_strbuf_tostring);
+  lua_setfield(L, -2, "tostring");
+  lua_enablereadonlytable(L, -1, 1);
+  lua_setfield(L, -2, "__index");
+
+  lua_pushcfunction(L, l_strbuf_tostring);
+  lua_setfield(L, -2, "__tostring");
+  lua_pushcfunction(L, l_strbuf_len);
+  lua_setfield(L, -2, "__len");
+  lua_pushcfunction(L, l_strbuf_gc);
+  lua_setfield(L, -2, "__gc");
+  lua_pushliteral(L, STRBUF_METATABLE);
+  lua_setfield(L, -2, "__metatable");
+
+  lua_enablereadonlytable(L, -1, 1);
+  lua_pop(L, 1);
+}
+
 void register_redis_api(lua_State *L) {
+  register_strbuf_metatable(L);
+
   lua_newtable(L);
 
   lua_pushcfunction(L, l_redis_call);
@@ -546,6 +711,9 @@ void register_redis_api(lua_State *L) {
   lua_pushcfunction(L, l_redis_setresp);
   lua_setfield(L, -2, "setresp");
 
+  lua_pushcfunction(L, l_redis_strbuf);
+  lua_setfield(L, -2, "strbuf");
+
   set_log_constants(L);
 
   lua_setglobal(L, "redis");
@@ -10,7 +10,13 @@ uint32_t redis_resp_version(void);
 void redis_reset_resp_version(void);
 
 /* Decodes the host_redis_props blob and assigns each entry onto the global
- * `redis` table. Returns 0 on success, -1 on a malformed blob. */
+ * `redis` table; a field with no value removes the member. The table must be
+ * writable. Returns 0 on success, -1 on a malformed blob. */
 int apply_redis_props(lua_State *L, const uint8_t *buf, size_t len);
 
+/* If the value at idx is a redis.strbuf builder, points data/len at its bytes
+ * (valid until the builder is next appended to or collected) and returns 1;
+ * otherwise returns 0 and leaves data/len untouched. */
+int redis_strbuf_contents(lua_State *L, int idx, const char **data, size_t *len);
+
 #endif /* REDIS_LUA_WASM_REDIS_API_H */
@@ -1,5 +1,14 @@
 #include "../include/abi.h"
+#include "alloc_track.h"
+#include "eval_arena.h"
+#include "fuel.h"
+#include "json_simd.h"
+#include "load_limits.h"
+#include "profile.h"
 #include "redis_api.h"
+#include "script_cache.h"
+#include "string_hash.h"
+#include <emscripten.h>
 #include <lauxlib.h>
 #include <lua.h>
 #include <lualib.h>
@@ -7,9 +16,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define DEFAULT_FUEL_LIMIT 10000000
-#define FUEL_HOOK_STEP 1000
-
 typedef struct ReplyBuffer {
   uint8_t *data;
   size_t len;
@@ -17,8 +23,6 @@ typedef struct ReplyBuffer {
 } ReplyBuffer;
 
 static lua_State *g_state = NULL;
-static int64_t g_fuel_remaining = DEFAULT_FUEL_LIMIT;
-static int64_t g_fuel_limit = DEFAULT_FUEL_LIMIT;
 static uint32_t g_max_reply_bytes = 0;
 static uint32_t g_max_arg_bytes = 0;
 /* Script line captured by script_error_handler at the last error point. */
@@ -420,6 +424,19 @@ static int encode_lua_value(lua_State *L, int idx, ReplyBuffer *rb) {
     }
     case LUA_TTABLE:
       return encode_table(L, idx, rb);
+    case LUA_TUSERDATA: {
+      // A redis.strbuf builder is written straight out as a bulk reply, without
+      // materializing the assembled string in Lua first.
+      size_t len = 0;
+      const char *data = NULL;
+      if (!redis_strbuf_contents(L, idx, &data, &len)) {
+        return -1;
+      }
+      if (rb_write_header(rb, REPLY_BULK, (uint32_t)len) != 0) {
+        return -1;
+      }
+      return rb_append(rb, data, len);
+    }
     default:
       return -1;
   }
@@ -452,9 +469,114 @@ static void remove_package_entry(lua_State *L, const char *name) {
 #define COMPAT_PRINT 0x1u        // keep Lua `print` (Redis 6.2 only)
 #define COMPAT_OS 0x2u           // expose `os` lib (Redis 7.4+, Valkey 8.0+)
 #define COMPAT_SERVER_ALIAS 0x4u // `server` aliases `redis` (Valkey 8.0+)
+#define COMPAT_ALL (COMPAT_PRINT | COMPAT_OS | COMPAT_SERVER_ALIAS)
 static uint32_t g_compat_flags = COMPAT_OS | COMPAT_SERVER_ALIAS;
 
-void set_compat(uint32_t flags) { g_compat_flags = flags; }
+// Per-eval profile selection (see push_compat_env). g_compat_envs has bit
+// (1 << flags) set for each flag set setup_state prebuilds an environment for;
+// g_eval_compat is the flag set evals run under, kept across resets;
+// g_active_compat is the flag set of the live state's current globals.
+static uint32_t g_compat_envs = 0;
+static uint32_t g_eval_compat = COMPAT_OS | COMPAT_SERVER_ALIAS;
+static uint32_t g_active_compat = COMPAT_OS | COMPAT_SERVER_ALIAS;
+
+void set_compat(uint32_t flags) {
+  g_compat_flags = flags & COMPAT_ALL;
+  g_eval_compat = g_compat_flags;
+}
+
+void set_compat_envs(uint32_t mask) { g_compat_envs = mask; }
+
+// String hashing for the next init()/reset() (see string_hash.c). 0 keeps Lua's
+// stock sampled hash; otherwise every byte is hashed under `seed`. Applied only
+// when a state is built: interned strings keep their hash, so it cannot change
+// under a live state.
+static uint32_t g_string_hash_seeded = 0;
+static uint32_t g_string_hash_seed = 0;
+
+void set_string_hash(uint32_t seeded, uint32_t seed) {
+  g_string_hash_seeded = seeded;
+  g_string_hash_seed = seed;
+}
+
+// Experimental per-eval region (see eval_arena.c), in bytes; 0 disables it.
+// Like the string hash, applied when the next state is built.
+static uint32_t g_eval_arena_bytes = 0;
+
+void set_eval_arena(uint32_t bytes) {
+  g_eval_arena_bytes = bytes;
+}
+
+// Allocation tracking (see alloc_track.c), applied when the next state is
+// built: every block of a state must carry the tracking header, or none.
+static uint32_t g_alloc_tracking = 0;
+
+void set_alloc_tracking(uint32_t enabled) {
+  g_alloc_tracking = enabled;
+}
+
+void set_alloc_owner(uint32_t owner) {
+  alloc_track_set_owner(owner);
+}
+
+// Phase timestamps of the last eval for the host's tracer, in the host's
+// performance.now() clock (ms). Only written while set_trace(1) is in effect;
+// a phase the eval never reached (say, execution after a compile error) is 0.
+#define TRACE_ENTERED 0
+#define TRACE_ARGS_READY 1
+#define TRACE_COMPILED 2
+#define TRACE_EXECUTED 3
+#define TRACE_ENCODED 4
+#define TRACE_MARKS 5
+static uint32_t g_trace = 0;
+static double g_trace_marks[TRACE_MARKS];
+
+void set_trace(uint32_t enabled) {
+  g_trace = enabled;
+}
+
+uint32_t trace_marks(void) {
+  return (uint32_t)(uintptr_t)g_trace_marks;
+}
+
+static void trace_begin(void) {
+  if (g_trace) {
+    memset(g_trace_marks, 0, sizeof(g_trace_marks));
+    g_trace_marks[TRACE_ENTERED] = emscripten_get_now();
+  }
+}
+
+static void trace_mark(int mark) {
+  if (g_trace) {
+    g_trace_marks[mark] = emscripten_get_now();
+  }
+}
+
+PtrLen alloc_snapshot(uint32_t collect) {
+  if (!g_state) {
+    return (PtrLen){0, 0};
+  }
+  if (collect) {
+    lua_gc(g_state, LUA_GCCOLLECT, 0);
+  }
+  return alloc_track_snapshot(g_state);
+}
+
+// Registry keys of the per-profile environments (flags -> globals table) and of
+// the globals only some profiles expose.
+#define COMPAT_ENVS_KEY "redis_lua_wasm.compat_envs"
+#define COMPAT_STASH_KEY "redis_lua_wasm.compat_stash"
+
+// Keeps `print` and `os` reachable for environments that expose them when the
+// state's own profile strips them. Must run before disable_non_determinism.
+static void stash_compat_globals(lua_State *L) {
+  lua_createtable(L, 0, 2);
+  lua_getglobal(L, "print");
+  lua_setfield(L, -2, "print");
+  lua_getglobal(L, "os");
+  lua_setfield(L, -2, "os");
+  lua_setfield(L, LUA_REGISTRYINDEX, COMPAT_STASH_KEY);
+}
 
 // Mirror Redis's allow/deny arrays (src/script_lua.c) rather than a hand-rolled
 // deny set. Redis exposes loadstring/load/collectgarbage/gcinfo (lua_builtins_
@@ -601,6 +723,9 @@ LUALIB_API int luaopen_bit(lua_State *L);
 
 static void load_redis_modules(lua_State *L) {
   luaLoadLib(L, "cjson", luaopen_cjson);
+#ifdef REDIS_LUA_WASM_SIMD_JSON
+  json_simd_install(L);
+#endif
   luaLoadLib(L, "struct", luaopen_struct);
   luaLoadLib(L, "cmsgpack", luaopen_cmsgpack);
   luaLoadLib(L, "bit", luaopen_bit);
@@ -615,37 +740,41 @@ static void open_allowed_libs(lua_State *L, uint32_t flags) {
   luaopen_string(L);
   luaopen_math(L);
   // Redis exposes os via libraries_allow_list; the vendored loslib.c sandboxes
-  // it to only os.clock (sandbox_syslib), so opening it here is safe. Skipped
-  // unless COMPAT_OS is set (Redis < 7.4 / Valkey 7.2 had no os); when skipped,
-  // reading `os` hits the globals-protection __index handler and raises.
-  if (flags & COMPAT_OS) {
-    luaopen_os(L);
-  }
+  // it to only os.clock (sandbox_syslib), so opening it here is safe. Removed
+  // unless COMPAT_OS is set (Redis < 7.4 / Valkey 7.2 had no os); then reading
+  // `os` hits the globals-protection __index handler and raises. It is opened
+  // regardless so that other profiles' environments can expose it.
+  luaopen_os(L);
   lua_settop(L, 0);
+  load_limits_register(L);
+  stash_compat_globals(L);
+  if (!(flags & COMPAT_OS)) {
+    remove_global(L, "os");
+    remove_package_entry(L, "os");
+  }
   disable_non_determinism(L, flags);
   load_redis_modules(L);
-}
-
-static void fuel_hook(lua_State *L, lua_Debug *ar) {
-  (void)ar;
-  g_fuel_remaining -= FUEL_HOOK_STEP;
-  if (g_fuel_remaining <= 0) {
-    luaL_error(L, "Script killed by fuel limit");
-  }
-}
-
-static void reset_fuel(void) {
-  g_fuel_remaining = g_fuel_limit;
+  fuel_wrap_library_costs(L);
 }
 
 void set_limits(uint32_t max_fuel, uint32_t max_reply_bytes, uint32_t max_arg_bytes) {
   if (max_fuel > 0) {
-    g_fuel_limit = (int64_t)max_fuel;
+    fuel_set_limit((int64_t)max_fuel);
   }
   g_max_reply_bytes = max_reply_bytes;
   g_max_arg_bytes = max_arg_bytes;
 }
 
+void set_load_limits(uint32_t max_script_bytes, uint32_t max_functions, uint32_t max_constants,
+                     uint32_t max_nesting, uint32_t max_parse_ms) {
+  load_limits_set(max_script_bytes, max_functions, max_constants, max_nesting, max_parse_ms);
+}
+
+uint32_t fuel_used(void) {
+  int64_t spent = fuel_spent();
+  return spent > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)spent;
+}
+
 static int set_keys_argv(lua_State *L, const uint8_t *buf, size_t len, uint32_t keys_count) {
   if (len < 4) {
     return -1;
@@ -692,10 +821,83 @@ static void set_empty_keys_argv(lua_State *L) {
   raw_setglobal(L, "ARGV");
 }
 
+// Pushes the globals table for compat `flags`, building it on first use. The
+// state's own globals serve g_compat_flags; any other flag set gets a copy of
+// them with print/os/server adjusted and the same protection metatable. Library
+// tables, `redis` and the functions in them are shared, so an environment costs
+// one table, and everything but those three globals behaves identically.
+static void push_compat_env(lua_State *L, uint32_t flags) {
+  lua_getfield(L, LUA_REGISTRYINDEX, COMPAT_ENVS_KEY); // [envs]
+  lua_rawgeti(L, -1, (int)flags);                      // [envs, env]
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    lua_rawgeti(L, -1, (int)g_compat_flags); // [envs, G]
+    lua_newtable(L);                         // [envs, G, env]
+    lua_pushnil(L);
+    while (lua_next(L, -3)) {  // [envs, G, env, key, value]
+      lua_pushvalue(L, -2);    // [envs, G, env, key, value, key]
+      lua_insert(L, -2);       // [envs, G, env, key, key, value]
+      lua_rawset(L, -4);       // env[key] = value
+    }
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "_G");
+    lua_getfield(L, LUA_REGISTRYINDEX, COMPAT_STASH_KEY); // [envs, G, env, stash]
+    if (flags & COMPAT_PRINT) {
+      lua_getfield(L, -1, "print");
+    } else {
+      lua_pushnil(L);
+    }
+    lua_setfield(L, -3, "print");
+    if (flags & COMPAT_OS) {
+      lua_getfield(L, -1, "os");
+    } else {
+      lua_pushnil(L);
+    }
+    lua_setfield(L, -3, "os");
+    lua_pop(L, 1);
+    if (flags & COMPAT_SERVER_ALIAS) {
+      lua_pushliteral(L, "redis");
+      lua_rawget(L, -3);
+    } else {
+      lua_pushnil(L);
+    }
+    lua_setfield(L, -2, "server");
+    lua_getmetatable(L, -2);
+    lua_setmetatable(L, -2);
+    protect_table_recursively(L);
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, -4, (int)flags); // [envs, G, env]
+    lua_remove(L, -2);              // [envs, env]
+  }
+  lua_remove(L, -2); // [env]
+}
+
+// Makes the environment for `flags` the state's globals. New chunks (and
+// loadstring) take their environment from there; cached scripts are pointed at
+// it before each run (eval_cached_script).
+static void select_compat_env(lua_State *L, uint32_t flags) {
+  if (flags == g_active_compat) {
+    return;
+  }
+  push_compat_env(L, flags);
+  lua_replace(L, LUA_GLOBALSINDEX);
+  g_active_compat = flags;
+}
+
+void use_compat(uint32_t flags) {
+  g_eval_compat = flags & COMPAT_ALL;
+  if (g_state) {
+    select_compat_env(g_state, g_eval_compat);
+  }
+}
+
 // Build a fresh Lua state in g_state honoring g_compat_flags. Shared by init()
 // and reset(); the caller is responsible for closing any prior state.
 static int32_t setup_state(void) {
-  g_state = luaL_newstate();
+  string_hash_configure(g_string_hash_seeded != 0, g_string_hash_seed);
+  eval_arena_configure(g_eval_arena_bytes);
+  alloc_track_configure(g_alloc_tracking != 0);
+  g_state = eval_arena_newstate();
   if (!g_state) {
     return -1;
   }
@@ -720,9 +922,24 @@ static int32_t setup_state(void) {
     lua_getglobal(g_state, "redis");
     lua_setglobal(g_state, "server");
   }
+#ifdef REDIS_LUA_WASM_PROFILE
+  profile_index_cfunctions(g_state);
+#endif
   enable_globals_protection(g_state);
-  lua_sethook(g_state, fuel_hook, LUA_MASKCOUNT, FUEL_HOOK_STEP);
-  reset_fuel();
+  lua_newtable(g_state);
+  lua_pushvalue(g_state, LUA_GLOBALSINDEX);
+  lua_rawseti(g_state, -2, (int)g_compat_flags);
+  lua_setfield(g_state, LUA_REGISTRYINDEX, COMPAT_ENVS_KEY);
+  g_active_compat = g_compat_flags;
+  for (uint32_t flags = 0; flags <= COMPAT_ALL; flags++) {
+    if (g_compat_envs & (1u << flags)) {
+      push_compat_env(g_state, flags);
+      lua_pop(g_state, 1);
+    }
+  }
+  select_compat_env(g_state, g_eval_compat);
+  fuel_attach(g_state);
+  fuel_reset();
   return 0;
 }
 
@@ -743,25 +960,13 @@ int32_t reset(void) {
   return setup_state();
 }
 
-PtrLen eval(uint32_t ptr, uint32_t len) {
-  if (!g_state) {
-    return reply_error("ERR Lua VM not initialized", 26);
-  }
-  reset_fuel();
-  redis_reset_resp_version();
-  set_empty_keys_argv(g_state);
-  const char *script = (const char *)(uintptr_t)ptr;
-  lua_pushcfunction(g_state, script_error_handler);
-  int errfunc = lua_gettop(g_state);
-  if (luaL_loadbuffer(g_state, script, (size_t)len, "@user_script") != 0) {
-    size_t err_len = 0;
-    const char *err = lua_tolstring(g_state, -1, &err_len);
-    PtrLen out = reply_script_error(err ? err : "ERR script load failed", err ? err_len : 23, 0);
-    lua_settop(g_state, 0);
-    return out;
-  }
+/* Runs the function above `errfunc` (the script_error_handler slot) and
+ * encodes its result. Shared by every eval flavor; clears the stack. */
+static PtrLen run_script(int errfunc) {
   g_error_line = 0;
-  if (lua_pcall(g_state, 0, LUA_MULTRET, errfunc) != 0) {
+  int status = lua_pcall(g_state, 0, LUA_MULTRET, errfunc);
+  trace_mark(TRACE_EXECUTED);
+  if (status != 0) {
     size_t err_len = 0;
     const char *err = lua_tolstring(g_state, -1, &err_len);
     PtrLen out =
@@ -796,65 +1001,231 @@ PtrLen eval(uint32_t ptr, uint32_t len) {
   return out;
 }
 
-PtrLen eval_with_args(uint32_t script_ptr, uint32_t script_len, uint32_t args_ptr,
-                      uint32_t args_len, uint32_t keys_count) {
-  if (!g_state) {
-    return reply_error("ERR Lua VM not initialized", 26);
+/* Pushes the error handler and the compiled script. Returns the handler's
+ * stack index, or 0 with a load-error reply in *err. */
+static int load_script(const char *script, size_t len, PtrLen *err) {
+  lua_pushcfunction(g_state, script_error_handler);
+  int errfunc = lua_gettop(g_state);
+  if (load_limited(g_state, script, len, "@user_script") != 0) {
+    size_t err_len = 0;
+    const char *msg = lua_tolstring(g_state, -1, &err_len);
+    *err = reply_script_error(msg ? msg : "ERR script load failed", msg ? err_len : 23, 0);
+    lua_settop(g_state, 0);
+    return 0;
   }
-  reset_fuel();
-  redis_reset_resp_version();
+  trace_mark(TRACE_COMPILED);
+  return errfunc;
+}
+
+/* Fills KEYS/ARGV from an ArgArray, enforcing maxArgBytes. */
+static int prepare_args(uint32_t args_ptr, uint32_t args_len, uint32_t keys_count, PtrLen *err) {
   if (g_max_arg_bytes > 0 && args_len > g_max_arg_bytes) {
-    return reply_error("ERR KEYS/ARGV exceeds configured limit", 40);
+    *err = reply_error("ERR KEYS/ARGV exceeds configured limit", 40);
+    return -1;
   }
   const uint8_t *args = (const uint8_t *)(uintptr_t)args_ptr;
   if (set_keys_argv(g_state, args, (size_t)args_len, keys_count) != 0) {
     lua_settop(g_state, 0);
-    return reply_error("ERR invalid KEYS/ARGV encoding", 31);
+    *err = reply_error("ERR invalid KEYS/ARGV encoding", 31);
+    return -1;
+  }
+  trace_mark(TRACE_ARGS_READY);
+  return 0;
+}
+
+static PtrLen eval_script(uint32_t ptr, uint32_t len) {
+  fuel_reset();
+  redis_reset_resp_version();
+  set_empty_keys_argv(g_state);
+  trace_mark(TRACE_ARGS_READY);
+  PtrLen err;
+  int errfunc = load_script((const char *)(uintptr_t)ptr, (size_t)len, &err);
+  return errfunc ? run_script(errfunc) : err;
+}
+
+static PtrLen eval_script_with_args(uint32_t script_ptr, uint32_t script_len,
+                                    uint32_t args_ptr, uint32_t args_len, uint32_t keys_count) {
+  fuel_reset();
+  redis_reset_resp_version();
+  PtrLen err;
+  if (prepare_args(args_ptr, args_len, keys_count, &err) != 0) {
+    return err;
+  }
+  int errfunc = load_script((const char *)(uintptr_t)script_ptr, (size_t)script_len, &err);
+  return errfunc ? run_script(errfunc) : err;
+}
+
+static PtrLen eval_cached_script(uint32_t sha_ptr, uint32_t args_ptr, uint32_t args_len,
+                                 uint32_t keys_count) {
+  fuel_reset();
+  redis_reset_resp_version();
+  PtrLen err;
+  if (prepare_args(args_ptr, args_len, keys_count, &err) != 0) {
+    return err;
   }
-  const char *script = (const char *)(uintptr_t)script_ptr;
   lua_pushcfunction(g_state, script_error_handler);
   int errfunc = lua_gettop(g_state);
-  if (luaL_loadbuffer(g_state, script, (size_t)script_len, "@user_script") != 0) {
+  if (script_cache_push(g_state, (const char *)(uintptr_t)sha_ptr, SCRIPT_SHA_LEN) != 0) {
+    lua_settop(g_state, 0);
+    return reply_error("NOSCRIPT No matching script. Please use EVAL.", 45);
+  }
+  // The cached function keeps the environment it was installed under.
+  lua_pushvalue(g_state, LUA_GLOBALSINDEX);
+  lua_setfenv(g_state, -2);
+  trace_mark(TRACE_COMPILED);
+  return run_script(errfunc);
+}
+
+// KEYS/ARGV are rebuilt by every eval. Drop them before the arena may collect,
+// or the previous call's tables would survive it and pin the region.
+static void end_eval_arena(void) {
+  if (g_eval_arena_bytes == 0) {
+    return;
+  }
+  lua_pushnil(g_state);
+  raw_setglobal(g_state, "KEYS");
+  lua_pushnil(g_state);
+  raw_setglobal(g_state, "ARGV");
+  eval_arena_end(g_state);
+}
+
+PtrLen eval(uint32_t ptr, uint32_t len) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
+  }
+  trace_begin();
+  eval_arena_begin(g_state);
+  PtrLen out = eval_script(ptr, len);
+  trace_mark(TRACE_ENCODED);
+  end_eval_arena();
+  return out;
+}
+
+PtrLen eval_with_args(uint32_t script_ptr, uint32_t script_len, uint32_t args_ptr,
+                      uint32_t args_len, uint32_t keys_count) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
+  }
+  trace_begin();
+  eval_arena_begin(g_state);
+  PtrLen out = eval_script_with_args(script_ptr, script_len, args_ptr, args_len, keys_count);
+  trace_mark(TRACE_ENCODED);
+  end_eval_arena();
+  return out;
+}
+
+PtrLen eval_sha(uint32_t sha_ptr, uint32_t args_ptr, uint32_t args_len, uint32_t keys_count) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
+  }
+  trace_begin();
+  eval_arena_begin(g_state);
+  PtrLen out = eval_cached_script(sha_ptr, args_ptr, args_len, keys_count);
+  trace_mark(TRACE_ENCODED);
+  end_eval_arena();
+  return out;
+}
+
+PtrLen script_compile(uint32_t ptr, uint32_t len) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
+  }
+  char *bc = NULL;
+  size_t bc_len = 0;
+  if (script_cache_compile(g_state, (const char *)(uintptr_t)ptr, (size_t)len, &bc, &bc_len) != 0) {
     size_t err_len = 0;
     const char *err = lua_tolstring(g_state, -1, &err_len);
-    PtrLen out = reply_script_error(err ? err : "ERR script load failed", err ? err_len : 23, 0);
+    PtrLen out = reply_script_error(err ? err : "ERR script load failed", err ? err_len : 22, 0);
     lua_settop(g_state, 0);
     return out;
   }
-  g_error_line = 0;
-  if (lua_pcall(g_state, 0, LUA_MULTRET, errfunc) != 0) {
+  ReplyBuffer rb;
+  rb_init(&rb);
+  PtrLen out = {0, 0};
+  if (rb_write_header(&rb, REPLY_BULK, (uint32_t)bc_len) == 0 && rb_append(&rb, bc, bc_len) == 0) {
+    out = rb_finalize(&rb);
+  }
+  free(bc);
+  free(rb.data);
+  return out.ptr ? out : reply_error("ERR reply encoding failed", 25);
+}
+
+PtrLen script_install(uint32_t sha_ptr, uint32_t bc_ptr, uint32_t bc_len) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
+  }
+  if (script_cache_install(g_state, (const char *)(uintptr_t)sha_ptr, SCRIPT_SHA_LEN,
+                           (const char *)(uintptr_t)bc_ptr, (size_t)bc_len) != 0) {
     size_t err_len = 0;
     const char *err = lua_tolstring(g_state, -1, &err_len);
-    PtrLen out =
-        reply_script_error(err ? err : "ERR script execution failed", err ? err_len : 28, g_error_line);
+    PtrLen out = reply_error(err ? err : "ERR script install failed", err ? err_len : 25);
     lua_settop(g_state, 0);
     return out;
   }
-  lua_remove(g_state, errfunc);
-  int top = lua_gettop(g_state);
-  if (top == 0) {
-    // A script with no return value replies with nil, matching real Redis.
-    return reply_null();
+  return reply_status("OK", 2);
+}
+
+/* Applies a props delta (host_redis_props encoding) to the live `redis` table,
+ * lifting its readonly flag for the writes as raw_setglobal does for globals.
+ * `server` is the same table, so it sees the changes too. */
+PtrLen update_redis_props(uint32_t ptr, uint32_t len) {
+  if (!g_state) {
+    return reply_error("ERR Lua VM not initialized", 26);
   }
-  ReplyBuffer rb;
-  rb_init(&rb);
-  if (encode_lua_value(g_state, -1, &rb) != 0) {
+  lua_getglobal(g_state, "redis");
+  if (!lua_istable(g_state, -1)) {
     lua_settop(g_state, 0);
-    free(rb.data);
-    return reply_error("ERR unsupported Lua return type", 32);
+    return reply_error("ERR redis table missing", 23);
   }
-  if (g_max_reply_bytes > 0 && rb.len > g_max_reply_bytes) {
-    lua_settop(g_state, 0);
-    free(rb.data);
-    return reply_error("ERR reply exceeds configured limit", 34);
+  int was_ro = lua_isreadonlytable(g_state, -1);
+  if (was_ro) {
+    lua_enablereadonlytable(g_state, -1, 0);
+  }
+  int rc = apply_redis_props(g_state, (const uint8_t *)(uintptr_t)ptr, (size_t)len);
+  if (was_ro) {
+    lua_enablereadonlytable(g_state, -1, 1);
   }
   lua_settop(g_state, 0);
-  PtrLen out = rb_finalize(&rb);
-  free(rb.data);
-  if (out.ptr == 0) {
-    return reply_error("ERR reply encoding failed", 26);
+  if (rc != 0) {
+    return reply_error("ERR invalid redis props", 23);
+  }
+  return reply_status("OK", 2);
+}
+
+void script_flush(void) {
+  if (g_state) {
+    script_cache_flush(g_state);
+  }
+}
+
+void script_evict(uint32_t sha_ptr) {
+  if (g_state) {
+    script_cache_evict(g_state, (const char *)(uintptr_t)sha_ptr, SCRIPT_SHA_LEN);
+  }
+}
+
+// Bytes the Lua allocator holds for the state (lua_gc's count), 0 without one.
+uint32_t heap_bytes(void) {
+  if (!g_state) {
+    return 0;
+  }
+  return (uint32_t)lua_gc(g_state, LUA_GCCOUNT, 0) * 1024 + (uint32_t)lua_gc(g_state, LUA_GCCOUNTB, 0);
+}
+
+// One incremental collection step of `kb` kilobytes (0: a full collection).
+uint32_t gc_step(uint32_t kb) {
+  if (g_state) {
+    lua_gc(g_state, kb ? LUA_GCSTEP : LUA_GCCOLLECT, (int)kb);
+  }
+  return heap_bytes();
+}
+
+// Closes the state, handing its heap back to malloc. init() builds a new one.
+void hibernate(void) {
+  if (g_state) {
+    lua_close(g_state);
+    g_state = NULL;
   }
-  return out;
 }
 
 uint32_t alloc(uint32_t size) {
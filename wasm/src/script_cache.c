@@ -0,0 +1,187 @@
+/* Precompiled script cache (SCRIPT LOAD-style registration).
+ *
+ * A script is compiled once, typically on a separate engine off the serving
+ * path, and its bytecode installed into serving engines keyed by sha. Evals by
+ * sha then call the cached function and never run the parser.
+ *
+ * The vendored VM refuses binary chunks in luaL_loadbuffer (Redis disables
+ * bytecode loading for script sources), so installation goes through
+ * luaU_undump directly, mirroring ldo.c's f_parser. Undump rejects a header
+ * from a different VM build and runs luaG_checkcode on every function, but
+ * that check is known to be bypassable (CVE-2015-4335): crafted bytecode can
+ * still corrupt the VM. script_install must therefore only ever see bytecode
+ * from script_compile; the JS engine enforces that by sealing compiled
+ * bytecode with a per-process HMAC and verifying it before calling here. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "ldo.h"
+#include "lfunc.h"
+#include "lgc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "lundump.h"
+#include "lzio.h"
+
+#include "load_limits.h"
+#include "script_cache.h"
+
+#define SCRIPT_CACHE_KEY "redis_lua_wasm.scripts"
+
+#ifdef REDIS_LUA_WASM_COMPACT_TVALUE
+/* COMPACT_TVALUE builds (see build.sh) only change lua_Number's alignment.
+ * Dumped numbers stay 8 bytes, so bytecode moves freely between layouts. */
+_Static_assert(sizeof(TValue) == 12, "compact TValue layout not applied");
+_Static_assert(sizeof(lua_Number) == 8, "bytecode number size changed");
+#endif
+
+typedef struct DumpBuf {
+  char *data;
+  size_t len;
+  size_t cap;
+} DumpBuf;
+
+static int dump_writer(lua_State *L, const void *p, size_t sz, void *ud) {
+  (void)L;
+  DumpBuf *b = (DumpBuf *)ud;
+  if (b->len + sz > b->cap) {
+    size_t cap = b->cap ? b->cap * 2 : 4096;
+    while (cap < b->len + sz) {
+      cap *= 2;
+    }
+    char *data = realloc(b->data, cap);
+    if (!data) {
+      return 1;
+    }
+    b->data = data;
+    b->cap = cap;
+  }
+  memcpy(b->data + b->len, p, sz);
+  b->len += sz;
+  return 0;
+}
+
+int script_cache_compile(lua_State *L, const char *src, size_t len, char **out,
+                         size_t *out_len) {
+  if (load_limited(L, src, len, "@user_script") != 0) {
+    return -1;
+  }
+  DumpBuf b = {NULL, 0, 0};
+  int rc = lua_dump(L, dump_writer, &b);
+  lua_pop(L, 1);
+  if (rc != 0 || b.len == 0) {
+    free(b.data);
+    lua_pushliteral(L, "ERR out of memory dumping script");
+    return -1;
+  }
+  *out = b.data;
+  *out_len = b.len;
+  return 0;
+}
+
+typedef struct ChunkReader {
+  const char *data;
+  size_t len;
+} ChunkReader;
+
+static const char *chunk_read(lua_State *L, void *ud, size_t *size) {
+  (void)L;
+  ChunkReader *r = (ChunkReader *)ud;
+  if (r->len == 0) {
+    return NULL;
+  }
+  *size = r->len;
+  r->len = 0;
+  return r->data;
+}
+
+typedef struct Undump {
+  ZIO *z;
+  Mbuffer buff;
+} Undump;
+
+/* ldo.c's f_parser, binary branch only. */
+static void f_undump(lua_State *L, void *ud) {
+  Undump *u = (Undump *)ud;
+  luaC_checkGC(L);
+  Proto *tf = luaU_undump(L, u->z, &u->buff, "=user_script");
+  Closure *cl = luaF_newLclosure(L, tf->nups, hvalue(gt(L)));
+  cl->l.p = tf;
+  for (int i = 0; i < tf->nups; i++) {
+    cl->l.upvals[i] = luaF_newupval(L);
+  }
+  setclvalue(L, L->top, cl);
+  incr_top(L);
+}
+
+static int undump(lua_State *L, const char *bc, size_t bc_len) {
+  ChunkReader reader = {bc, bc_len};
+  ZIO z;
+  luaZ_init(L, &z, chunk_read, &reader);
+  Undump u;
+  u.z = &z;
+  luaZ_initbuffer(L, &u.buff);
+  int status = luaD_pcall(L, f_undump, &u, savestack(L, L->top), L->errfunc);
+  luaZ_freebuffer(L, &u.buff);
+  return status;
+}
+
+int script_cache_install(lua_State *L, const char *sha, size_t sha_len, const char *bc,
+                         size_t bc_len) {
+  if (bc_len == 0 || bc[0] != LUA_SIGNATURE[0]) {
+    lua_pushliteral(L, "ERR not a compiled script");
+    return -1;
+  }
+  if (undump(L, bc, bc_len) != 0 || load_limits_check(L) != 0) {
+    return -1;
+  }
+  lua_getfield(L, LUA_REGISTRYINDEX, SCRIPT_CACHE_KEY);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_CACHE_KEY);
+  }
+  lua_pushlstring(L, sha, sha_len);
+  lua_pushvalue(L, -3);
+  lua_rawset(L, -3);
+  lua_pop(L, 2);
+  return 0;
+}
+
+int script_cache_push(lua_State *L, const char *sha, size_t sha_len) {
+  lua_getfield(L, LUA_REGISTRYINDEX, SCRIPT_CACHE_KEY);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return -1;
+  }
+  lua_pushlstring(L, sha, sha_len);
+  lua_rawget(L, -2);
+  lua_remove(L, -2);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 1);
+    return -1;
+  }
+  return 0;
+}
+
+void script_cache_evict(lua_State *L, const char *sha, size_t sha_len) {
+  lua_getfield(L, LUA_REGISTRYINDEX, SCRIPT_CACHE_KEY);
+  if (lua_istable(L, -1)) {
+    lua_pushlstring(L, sha, sha_len);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+  }
+  lua_pop(L, 1);
+}
+
+void script_cache_flush(lua_State *L) {
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_CACHE_KEY);
+}
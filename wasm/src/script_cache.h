@@ -0,0 +1,32 @@
+#ifndef REDIS_LUA_WASM_SCRIPT_CACHE_H
+#define REDIS_LUA_WASM_SCRIPT_CACHE_H
+
+#include <stddef.h>
+
+#include <lua.h>
+
+/* Scripts are keyed by their 40-char hex SHA1, as in EVALSHA. */
+#define SCRIPT_SHA_LEN 40
+
+/* Compiles `src` (under the load limits, see load_limits.c) and dumps it to
+ * bytecode in a malloc'd buffer the caller frees. On failure returns -1 with the error message on the stack. */
+int script_cache_compile(lua_State *L, const char *src, size_t len, char **out,
+                         size_t *out_len);
+
+/* Loads bytecode produced by script_cache_compile (header and code are checked
+ * by the VM's undump) and caches the function under `sha`. On failure returns
+ * -1 with the error message on the stack. */
+int script_cache_install(lua_State *L, const char *sha, size_t sha_len, const char *bc,
+                         size_t bc_len);
+
+/* Pushes the cached function for `sha` and returns 0, or pushes nothing and
+ * returns -1 if none is installed. */
+int script_cache_push(lua_State *L, const char *sha, size_t sha_len);
+
+/* Drops the cached function for `sha`, if any. */
+void script_cache_evict(lua_State *L, const char *sha, size_t sha_len);
+
+/* Drops every cached function. */
+void script_cache_flush(lua_State *L);
+
+#endif /* REDIS_LUA_WASM_SCRIPT_CACHE_H */
@@ -0,0 +1,145 @@
+/* String interning entry point with an optional seeded, full-coverage hash.
+ *
+ * Lua 5.1's luaS_newlstr hashes at most ~32 bytes of a string (every
+ * `(len >> 5) + 1`-th byte). Long keys that share a prefix, or differ only in
+ * bytes the sampling skips, land in one string-table bucket and interning
+ * degrades into a linear chain of memcmp calls. Table string keys reuse the same
+ * hash (TString.hash), so lookups degrade with them.
+ *
+ * The vendored lstring.c is compiled with `-DluaS_newlstr=luaS_newlstr_sampled`
+ * (see wasm/build/build.sh); this file provides the real luaS_newlstr. With the
+ * seeded hash off it uses the stock sampled hash, so the default build hashes
+ * exactly like upstream. With it on, every byte goes through HalfSipHash-1-3,
+ * keyed from a host-chosen seed. A keyed PRF, unlike MurmurHash3, has no
+ * multicollisions that hold for every seed, so colliding keys cannot be
+ * precomputed; the key is derived from a 32-bit seed, though, so it only holds
+ * while the seed stays secret and is not guessable. Either way strings are
+ * chained here, so string table growth goes through luaS_resize in
+ * arena_resize.c. */
+
+#include <string.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+
+#include "lmem.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "lstring.h"
+
+#include "string_hash.h"
+
+static int g_seeded = 0;
+static uint32_t g_seed = 0;
+
+void string_hash_configure(int seeded, uint32_t seed) {
+  g_seeded = seeded;
+  g_seed = seed;
+}
+
+static uint32_t rotl32(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+#define HALFSIPROUND(v0, v1, v2, v3) \
+  do {                                 \
+    v0 += v1;                          \
+    v1 = rotl32(v1, 5);                \
+    v1 ^= v0;                          \
+    v0 = rotl32(v0, 16);               \
+    v2 += v3;                          \
+    v3 = rotl32(v3, 8);                \
+    v3 ^= v2;                          \
+    v0 += v3;                          \
+    v3 = rotl32(v3, 7);                \
+    v3 ^= v0;                          \
+    v2 += v1;                          \
+    v1 = rotl32(v1, 13);               \
+    v1 ^= v2;                          \
+    v2 = rotl32(v2, 16);               \
+  } while (0)
+
+/* HalfSipHash-1-3 with a 32-bit output, keyed with (k0, k1). */
+static uint32_t halfsiphash13(const unsigned char *data, size_t len, uint32_t k0, uint32_t k1) {
+  uint32_t v0 = k0;
+  uint32_t v1 = k1;
+  uint32_t v2 = 0x6c796765u ^ k0;
+  uint32_t v3 = 0x74656462u ^ k1;
+  size_t nblocks = len / 4;
+  for (size_t i = 0; i < nblocks; i++) {
+    uint32_t m;
+    memcpy(&m, data + i * 4, sizeof(m)); /* wasm is little-endian */
+    v3 ^= m;
+    HALFSIPROUND(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+  const unsigned char *tail = data + nblocks * 4;
+  uint32_t b = (uint32_t)len << 24;
+  switch (len & 3) {
+    case 3: b |= (uint32_t)tail[2] << 16; /* fallthrough */
+    case 2: b |= (uint32_t)tail[1] << 8;  /* fallthrough */
+    case 1: b |= tail[0];
+  }
+  v3 ^= b;
+  HALFSIPROUND(v0, v1, v2, v3);
+  v0 ^= b;
+  v2 ^= 0xff;
+  HALFSIPROUND(v0, v1, v2, v3);
+  HALFSIPROUND(v0, v1, v2, v3);
+  HALFSIPROUND(v0, v1, v2, v3);
+  return v1 ^ v3;
+}
+
+/* The stock hash from lstring.c: every `(l >> 5) + 1`-th byte, from the end. */
+static unsigned int sampled_hash(const char *str, size_t l) {
+  unsigned int h = cast(unsigned int, l);
+  size_t step = (l >> 5) + 1;
+  for (size_t l1 = l; l1 >= step; l1 -= step) {
+    h = h ^ ((h << 5) + (h >> 2) + cast(unsigned char, str[l1 - 1]));
+  }
+  return h;
+}
+
+/* Allocates and chains a new string; mirrors newlstr in lstring.c. */
+static TString *newlstr(lua_State *L, const char *str, size_t l, unsigned int h) {
+  TString *ts;
+  stringtable *tb;
+  if (l + 1 > (MAX_SIZET - sizeof(TString)) / sizeof(char)) {
+    luaM_toobig(L);
+  }
+  ts = cast(TString *, luaM_malloc(L, (l + 1) * sizeof(char) + sizeof(TString)));
+  ts->tsv.len = l;
+  ts->tsv.hash = h;
+  ts->tsv.marked = luaC_white(G(L));
+  ts->tsv.tt = LUA_TSTRING;
+  ts->tsv.reserved = 0;
+  memcpy(ts + 1, str, l * sizeof(char));
+  ((char *)(ts + 1))[l] = '\0';
+  tb = &G(L)->strt;
+  h = lmod(h, tb->size);
+  ts->tsv.next = tb->hash[h];
+  tb->hash[h] = obj2gco(ts);
+  tb->nuse++;
+  if (tb->nuse > cast(lu_int32, tb->size) && tb->size <= MAX_INT / 2) {
+    luaS_resize(L, tb->size * 2);
+  }
+  return ts;
+}
+
+TString *luaS_newlstr(lua_State *L, const char *str, size_t l) {
+  unsigned int h = g_seeded ? halfsiphash13((const unsigned char *)str, l, g_seed,
+                                            g_seed ^ 0x9e3779b9u)
+                            : sampled_hash(str, l);
+  for (GCObject *o = G(L)->strt.hash[lmod(h, G(L)->strt.size)]; o != NULL; o = o->gch.next) {
+    TString *ts = rawgco2ts(o);
+    if (ts->tsv.hash == h && ts->tsv.len == l && memcmp(str, getstr(ts), l) == 0) {
+      /* string may be dead */
+      if (isdead(G(L), o)) {
+        changewhite(o);
+      }
+      return ts;
+    }
+  }
+  return newlstr(L, str, l, h);
+}
@@ -0,0 +1,12 @@
+#ifndef REDIS_LUA_WASM_STRING_HASH_H
+#define REDIS_LUA_WASM_STRING_HASH_H
+
+#include <stdint.h>
+
+/* Selects the hash used by luaS_newlstr for states created afterwards: the stock
+ * sampled hash (seeded == 0) or a full-coverage hash under `seed`. Every interned
+ * string keeps the hash it was created with, so this must only be called while
+ * no lua_State exists. */
+void string_hash_configure(int seeded, uint32_t seed);
+
+#endif /* REDIS_LUA_WASM_STRING_HASH_H */
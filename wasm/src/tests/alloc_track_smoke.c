@@ -0,0 +1,108 @@
+#include "../../include/abi.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Mirrors the blob layout documented in alloc_track.c. */
+enum { STATS_U64 = 4, CLASS_PROTO = 3, CLASS_FUNCTION = 2, CLASS_STRING = 0 };
+
+static uint32_t read_u32_le(const uint8_t *src) {
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) |
+         ((uint32_t)src[3] << 24);
+}
+
+static uint64_t read_u64_le(const uint8_t *src) {
+  return (uint64_t)read_u32_le(src) | ((uint64_t)read_u32_le(src + 4) << 32);
+}
+
+static uint32_t copy_in(const void *data, uint32_t len) {
+  uint32_t ptr = alloc(len);
+  memcpy((void *)(uintptr_t)ptr, data, len);
+  return ptr;
+}
+
+/* Entry for `owner`, or NULL. */
+static const uint8_t *find_owner(PtrLen snap, uint32_t owner, uint32_t *class_count) {
+  const uint8_t *buf = (const uint8_t *)(uintptr_t)snap.ptr;
+  uint32_t owners = read_u32_le(buf);
+  *class_count = read_u32_le(buf + 4);
+  size_t entry_len = 4 + 8 * STATS_U64 + 16 * (size_t)*class_count;
+  for (uint32_t i = 0; i < owners; i++) {
+    const uint8_t *entry = buf + 8 + entry_len * i;
+    if (read_u32_le(entry) == owner) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static uint64_t class_objects(const uint8_t *entry, int cls) {
+  return read_u64_le(entry + 4 + 8 * STATS_U64 + 16 * cls);
+}
+
+static const char SHA[] = "0123456789abcdef0123456789abcdef01234567";
+
+int main(void) {
+  /* Off by default: no snapshot. */
+  assert(init() == 0);
+  PtrLen off = alloc_snapshot(1);
+  assert(off.ptr == 0);
+
+  set_alloc_tracking(1);
+  assert(reset() == 0);
+
+  set_alloc_owner(1);
+  const char *script = "local t = {} for i = 1, 100 do t[i] = 'v' .. i end return #t";
+  uint32_t script_ptr = copy_in(script, (uint32_t)strlen(script));
+  PtrLen reply = eval(script_ptr, (uint32_t)strlen(script));
+  assert(((const uint8_t *)(uintptr_t)reply.ptr)[0] == REPLY_INT);
+  free_mem(reply.ptr);
+  free_mem(script_ptr);
+
+  /* A cached script's closure and prototype stay live under its owner. */
+  set_alloc_owner(2);
+  const char *cached = "return ARGV[1]";
+  uint32_t cached_ptr = copy_in(cached, (uint32_t)strlen(cached));
+  PtrLen compiled = script_compile(cached_ptr, (uint32_t)strlen(cached));
+  free_mem(cached_ptr);
+  const uint8_t *buf = (const uint8_t *)(uintptr_t)compiled.ptr;
+  assert(buf[0] == REPLY_BULK);
+  uint32_t bc_len = read_u32_le(buf + 1);
+  uint32_t bc_ptr = copy_in(buf + 5, bc_len);
+  free_mem(compiled.ptr);
+  uint32_t sha_ptr = copy_in(SHA, 40);
+  PtrLen installed = script_install(sha_ptr, bc_ptr, bc_len);
+  assert(((const uint8_t *)(uintptr_t)installed.ptr)[0] == REPLY_STATUS);
+  free_mem(installed.ptr);
+  free_mem(sha_ptr);
+  free_mem(bc_ptr);
+  set_alloc_owner(0);
+
+  PtrLen snap = alloc_snapshot(1);
+  assert(snap.ptr != 0);
+  uint32_t class_count = 0;
+
+  /* Library tables and interned names were built outside any eval. */
+  const uint8_t *engine = find_owner(snap, 0, &class_count);
+  assert(engine && class_count == 7);
+  assert(read_u64_le(engine + 4) > 0);
+  assert(class_objects(engine, CLASS_STRING) > 0);
+
+  /* The eval's table and strings were garbage: allocated, but no longer live. */
+  const uint8_t *evaluated = find_owner(snap, 1, &class_count);
+  assert(evaluated);
+  assert(read_u64_le(evaluated + 4 + 16) >= 100);
+  assert(read_u64_le(evaluated + 4) < read_u64_le(evaluated + 4 + 24));
+
+  const uint8_t *loaded = find_owner(snap, 2, &class_count);
+  assert(loaded);
+  assert(class_objects(loaded, CLASS_PROTO) >= 1);
+  assert(class_objects(loaded, CLASS_FUNCTION) >= 1);
+  free_mem(snap.ptr);
+
+  /* The tracked state is closed through its own allocator. */
+  set_alloc_tracking(0);
+  assert(reset() == 0);
+  return 0;
+}
@@ -0,0 +1,48 @@
+/* Checks that the eval arena rewinds after evals that grow objects created
+ * before them: the string table (thousands of new strings) and the globals
+ * table (KEYS/ARGV on the first eval). If either vector landed in the region it
+ * would survive the collection that follows an exhausting eval and pin the
+ * region. Evals do not collect otherwise; the strings are interned once, but
+ * each eval's table fills the region further until an eval runs it out. */
+#include "../../include/abi.h"
+#include "../eval_arena.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t copy_in(const void *data, uint32_t len) {
+  uint32_t ptr = alloc(len);
+  memcpy((void *)(uintptr_t)ptr, data, len);
+  return ptr;
+}
+
+int main(void) {
+  set_eval_arena(1024 * 1024);
+  assert(init() == 0);
+  assert(eval_arena_used() == 0);
+
+  const char *script =
+      "local t, n = {}, 0 for i = 1, 20000 do local s = ARGV[1] .. i t[i] = s n = n + #s end "
+      "return n";
+  uint32_t script_ptr = copy_in(script, (uint32_t)strlen(script));
+  uint8_t args[4 + 4 + 1] = {1, 0, 0, 0, 1, 0, 0, 0, 'v'};
+  uint32_t args_ptr = copy_in(args, sizeof(args));
+
+  int rewinds = 0;
+  size_t used = 0;
+  for (int i = 0; i < 20; i++) {
+    PtrLen reply = eval_with_args(script_ptr, (uint32_t)strlen(script), args_ptr, sizeof(args), 0);
+    assert(((const uint8_t *)(uintptr_t)reply.ptr)[0] == REPLY_INT);
+    free_mem(reply.ptr);
+    assert(!eval_arena_pinned());
+    if (eval_arena_used() < used) {
+      rewinds++;
+    }
+    used = eval_arena_used();
+  }
+  assert(rewinds >= 2);
+
+  free_mem(args_ptr);
+  free_mem(script_ptr);
+  return 0;
+}
@@ -0,0 +1,50 @@
+/* Checks cjson.decode on documents the SIMD=1 fast path takes (over 64 bytes,
+ * nested, escapes) and on ones it hands to lua_cjson (over JSON_SIMD_MAX_BYTES,
+ * malformed), so both builds must give the same replies. */
+#include "../../include/abi.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t read_u32_le(const uint8_t *src) {
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) |
+         ((uint32_t)src[3] << 24);
+}
+
+/* Evaluates `script` and checks that it replies with the bulk string `want`. */
+static void expect_bulk(const char *script, const char *want) {
+  uint32_t script_len = (uint32_t)strlen(script);
+  uint32_t script_ptr = alloc(script_len);
+  memcpy((void *)(uintptr_t)script_ptr, script, script_len);
+  PtrLen reply = eval(script_ptr, script_len);
+  free_mem(script_ptr);
+
+  const uint8_t *buf = (const uint8_t *)(uintptr_t)reply.ptr;
+  assert(reply.ptr != 0);
+  assert(buf[0] == REPLY_BULK);
+  assert(read_u32_le(buf + 1) == strlen(want));
+  assert(memcmp(buf + 5, want, strlen(want)) == 0);
+  free_mem(reply.ptr);
+}
+
+int main(void) {
+  assert(init() == 0);
+
+  expect_bulk("local doc = cjson.decode('{\"id\": 12, \"name\": \"caf\\\\u00e9 \\\\\"x\\\\\"\", "
+              "\"tags\": [\"a\", \"b\", null, true, false], \"nested\": {\"x\": -1.5e2, "
+              "\"y\": []}}') "
+              "return table.concat({doc.id, doc.name, #doc.tags, tostring(doc.tags[3] == cjson.null), "
+              "tostring(doc.tags[4]), doc.nested.x, #doc.nested.y}, '|')",
+              "12|caf\xc3\xa9 \"x\"|5|true|true|-150|0");
+
+  /* Larger than the fast path's cap: decoded by lua_cjson all the same. */
+  expect_bulk("local parts = {} for i = 1, 200000 do parts[i] = i end "
+              "local doc = cjson.decode('[' .. table.concat(parts, ',') .. ']') "
+              "return #doc .. ':' .. doc[200000]",
+              "200000:200000");
+
+  expect_bulk("local ok, err = pcall(cjson.decode, '{\"a\": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13], }') "
+              "return tostring(ok) .. ':' .. tostring(err ~= nil)",
+              "false:true");
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "../../include/abi.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t read_u32_le(const uint8_t *src) {
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) |
+         ((uint32_t)src[3] << 24);
+}
+
+static uint32_t copy_in(const void *data, uint32_t len) {
+  uint32_t ptr = alloc(len);
+  memcpy((void *)(uintptr_t)ptr, data, len);
+  return ptr;
+}
+
+static const char SHA[] = "0123456789abcdef0123456789abcdef01234567";
+
+int main(void) {
+  assert(init() == 0);
+
+  /* Compile, then install into a fresh state: the cached function must not
+   * depend on the state that compiled it. */
+  const char *script = "return KEYS[1] .. ARGV[1]";
+  uint32_t script_ptr = copy_in(script, (uint32_t)strlen(script));
+  PtrLen compiled = script_compile(script_ptr, (uint32_t)strlen(script));
+  free_mem(script_ptr);
+  const uint8_t *buf = (const uint8_t *)(uintptr_t)compiled.ptr;
+  assert(buf[0] == REPLY_BULK);
+  uint32_t bc_len = read_u32_le(buf + 1);
+  assert(bc_len > 0 && buf[5] == 0x1b);
+  uint32_t bc_ptr = copy_in(buf + 5, bc_len);
+  free_mem(compiled.ptr);
+
+  assert(reset() == 0);
+  uint32_t sha_ptr = copy_in(SHA, 40);
+
+  uint8_t args[4 + 4 + 1 + 4 + 1] = {2, 0, 0, 0, 1, 0, 0, 0, 'k', 1, 0, 0, 0, 'v'};
+  uint32_t args_ptr = copy_in(args, sizeof(args));
+  PtrLen missing = eval_sha(sha_ptr, args_ptr, sizeof(args), 1);
+  assert(((const uint8_t *)(uintptr_t)missing.ptr)[0] == REPLY_ERROR);
+  free_mem(missing.ptr);
+
+  PtrLen installed = script_install(sha_ptr, bc_ptr, bc_len);
+  assert(((const uint8_t *)(uintptr_t)installed.ptr)[0] == REPLY_STATUS);
+  free_mem(installed.ptr);
+
+  PtrLen reply = eval_sha(sha_ptr, args_ptr, sizeof(args), 1);
+  buf = (const uint8_t *)(uintptr_t)reply.ptr;
+  assert(buf[0] == REPLY_BULK);
+  assert(read_u32_le(buf + 1) == 2);
+  assert(memcmp(buf + 5, "kv", 2) == 0);
+  free_mem(reply.ptr);
+
+  /* Truncated bytecode is rejected by undump. */
+  PtrLen bad = script_install(sha_ptr, bc_ptr, bc_len / 2);
+  assert(((const uint8_t *)(uintptr_t)bad.ptr)[0] == REPLY_ERROR);
+  free_mem(bad.ptr);
+
+  script_flush();
+  PtrLen flushed = eval_sha(sha_ptr, args_ptr, sizeof(args), 1);
+  assert(((const uint8_t *)(uintptr_t)flushed.ptr)[0] == REPLY_ERROR);
+  free_mem(flushed.ptr);
+
+  free_mem(args_ptr);
+  free_mem(sha_ptr);
+  free_mem(bc_ptr);
+  return 0;
+}
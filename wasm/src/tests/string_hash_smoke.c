@@ -0,0 +1,53 @@
+/* Checks that set_string_hash changes the hash strings are interned under: keys
+ * that differ only in bytes the stock hash skips share one hash without a seed
+ * and are spread out with one. Interning compares contents either way, so this
+ * is only visible in TString.hash. */
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LUA_CORE
+
+#include "lua.h"
+#include "lauxlib.h"
+
+#include "lobject.h"
+#include "lstate.h"
+#include "lstring.h"
+
+#include "../string_hash.h"
+
+enum { KEYS = 64, PREFIX = 1000 };
+
+/* Number of distinct hashes among KEYS keys of PREFIX 'k's, a three-digit
+ * counter and a 'z'. For a 1004-byte string the stock hash samples every 32nd
+ * byte from the last one (indices 1003, 971, ...), so it skips the counter. */
+static int distinct_hashes(int seeded, uint32_t seed) {
+  static char key[PREFIX + 5];
+  unsigned int hashes[KEYS];
+  int distinct = 0;
+  string_hash_configure(seeded, seed);
+  lua_State *L = luaL_newstate();
+  assert(L != NULL);
+  memset(key, 'k', PREFIX);
+  for (int i = 0; i < KEYS; i++) {
+    snprintf(key + PREFIX, 5, "%03dz", i);
+    TString *ts = luaS_newlstr(L, key, PREFIX + 4);
+    assert(ts->tsv.len == PREFIX + 4);
+    hashes[i] = ts->tsv.hash;
+    int seen = 0;
+    for (int j = 0; j < i; j++) {
+      seen |= hashes[j] == hashes[i];
+    }
+    distinct += !seen;
+  }
+  lua_close(L);
+  return distinct;
+}
+
+int main(void) {
+  assert(distinct_hashes(0, 0) == 1);
+  assert(distinct_hashes(1, 0x9e3779b9u) > KEYS - 4);
+  string_hash_configure(0, 0);
+  return 0;
+}